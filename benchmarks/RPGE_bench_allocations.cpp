@@ -0,0 +1,148 @@
+
+/**
+ * Checks that warm frames make no heap allocations. A generated scene is drawn by a headless engine in several
+ * configurations: every backend in both render modes, then the software mode with all post passes split among the
+ * threads of a worker pool. Frames of each configuration are drawn until they are warm, afterwards allocations of
+ * further frames are counted (see `getAllocationCount` function).
+ *
+ * Usage:
+ *   RPGE-bench-allocations [--warmup N] [--frames N] [--size W H]
+ *
+ * Exits with code 1 when any counted frame allocated, the library has to be built with RPGE_TRACK_ALLOCATIONS. Builds
+ * with the benchmarks and that option run it as CTest test `allocations`.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <RPGE_engine.hpp>
+#include <RPGE_generator.hpp>
+
+#define SCREEN_WIDTH   640
+#define SCREEN_HEIGHT  400
+#define SCENE_SIZE     128
+#define SIGHTLINES     8
+#define WARMUP_FRAMES  30
+#define FRAME_COUNT    200
+#define POOL_THREADS   4
+
+using namespace rpge;
+
+// Draws `warmup` frames, then `frames` more while turning the camera, returns heap allocations made by the latter
+uint64_t countAllocations(Engine& engine, Camera& camera, int warmup, int frames)
+{
+    for(int f = 0; f < warmup; f++)
+    {
+        camera.changeDirection(0.05f);
+        engine.render();
+        engine.tick();
+    }
+    uint64_t allocations = getAllocationCount();
+    for(int f = 0; f < frames; f++)
+    {
+        camera.changeDirection(0.05f);
+        engine.render();
+        engine.tick();
+    }
+    return getAllocationCount() - allocations;
+}
+
+// Prints usage of the program `program` and returns exit code of a wrong invocation
+int printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n";
+    std::cerr << "  --warmup N     frames drawn before counting (" << WARMUP_FRAMES << ")\n";
+    std::cerr << "  --frames N     frames counted per configuration (" << FRAME_COUNT << ")\n";
+    std::cerr << "  --size W H     frame size in pixels (" << SCREEN_WIDTH << " " << SCREEN_HEIGHT << ")\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    int warmup = WARMUP_FRAMES, frames = FRAME_COUNT, width = SCREEN_WIDTH, height = SCREEN_HEIGHT;
+    for(int a = 1; a < argc; a++)
+    {
+        bool hasValue = a + 1 < argc;
+        if(!strcmp(argv[a], "--warmup") && hasValue)
+            warmup = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--frames") && hasValue)
+            frames = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--size") && a + 2 < argc)
+        {
+            width  = atoi(argv[++a]);
+            height = atoi(argv[++a]);
+        }
+        else
+            return printUsage(argv[0]);
+    }
+    if(warmup < 1 || frames < 1 || width < 1 || height < 1)
+        return printUsage(argv[0]);
+    if(!isAllocationTracked())
+    {
+        std::cerr << "Allocations are not counted, configure the build with -DRPGE_TRACK_ALLOCATIONS=ON\n";
+        return 2;
+    }
+
+    Engine engine(width, height, true);
+    if(engine.getError())
+    {
+        std::cerr << "Can not start headless engine: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    engine.setResolutionGovernor(false);
+    engine.setFrameRate(1000);
+    engine.getWalker()->setMaxTileDistance(64);
+
+    GeneratorSettings settings;
+    settings.width            = SCENE_SIZE;
+    settings.height           = SCENE_SIZE;
+    settings.sightlineSpacing = SIGHTLINES;
+    Scene scene(engine.getRendererHandle(), SCENE_SIZE, SCENE_SIZE);
+    SceneGenerator(settings).fill(scene);
+    Camera camera(Vector2(2.5f, SIGHTLINES * 8 + 0.5f), 0, M_PI_2);
+    engine.setMainCamera(&camera);
+    engine.getWalker()->setTargetScene(&scene);
+
+    std::cout << SCENE_SIZE << "x" << SCENE_SIZE << " scene, " << width << "x" << height << " frames, ";
+    std::cout << frames << " counted after " << warmup << " warm-up frames\n";
+
+    struct Configuration {
+        const char*   name;
+        RenderMode    mode;
+        RenderBackend backend;
+        bool          post;   // Post passes run on the worker pool
+    };
+    const Configuration configurations[] = {
+        { "hardware, raycast     ", RM_HARDWARE, RB_RAYCAST,      false },
+        { "hardware, object order", RM_HARDWARE, RB_OBJECT_ORDER, false },
+        { "software, raycast     ", RM_SOFTWARE, RB_RAYCAST,      false },
+        { "software, object order", RM_SOFTWARE, RB_OBJECT_ORDER, false },
+        { "software, post passes ", RM_SOFTWARE, RB_RAYCAST,      true  }
+    };
+
+    uint8_t lut[256];
+    for(int i = 0; i < 256; i++)
+        lut[i] = 255 - i;
+    WorkerPool pool(POOL_THREADS);
+    PostProcessor* post = engine.getPostProcessor();
+
+    bool allocated = false;
+    for(const Configuration& configuration : configurations)
+    {
+        engine.setRenderMode(configuration.mode);
+        engine.setRenderBackend(configuration.backend);
+        post->setWorkerPool(configuration.post ? &pool : nullptr);
+        post->setFog(configuration.post, 40, 40, 60, 4, 32);
+        post->setColorLut(configuration.post, lut, lut, lut);
+        post->setGamma(configuration.post ? 2.2f : 1);
+        post->setVignette(configuration.post ? 0.5f : 0);
+
+        uint64_t allocations = countAllocations(engine, camera, warmup, frames);
+        std::cout << configuration.name << ": " << allocations << " allocations";
+        std::cout << " (" << (float)allocations / frames << " per frame)\n";
+        allocated = allocated || allocations > 0;
+    }
+    if(allocated)
+        std::cout << "warm frames allocate\n";
+    return allocated ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+
+/**
+ * Measures how long it takes to draw a frame worth of textured wall columns into the software framebuffer, writing
+ * them directly into rows (row-major layout) and into contiguous columns which are transposed afterwards
+ * (column-major layout), at several resolutions.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <RPGE_framebuffer.hpp>
+
+#define FRAME_COUNT   20
+#define TEXTURE_SIZE  64
+
+using namespace rpge;
+using ::std::chrono::steady_clock;
+using ::std::chrono::duration;
+
+// Draws one wall line per column the way the software column kernels do, line heights vary like walls at various
+// distances and every pixel is sampled from texture `texels`
+void drawWalls(Framebuffer& fb, const std::vector<uint32_t>& texels)
+{
+    const int width  = fb.getWidth();
+    const int height = fb.getHeight();
+    const int step   = fb.getDrawStep();
+    for(int x = 0; x < width; x++)
+    {
+        int lineHeight = height * (0.3f + 0.7f * fabsf(sinf(x * 0.01f)));
+        int top = (height - lineHeight) / 2;
+        int texColumn = x % TEXTURE_SIZE;
+        float texStep = TEXTURE_SIZE / (float)lineHeight;
+        uint32_t* pixel = fb.getDrawColumn(x) + top * step;
+        for(int y = 0; y < lineHeight; y++, pixel += step)
+            *pixel = texels[(int)((y + 0.5f) * texStep) * TEXTURE_SIZE + texColumn];
+    }
+}
+
+// Returns average times in milliseconds of drawing a frame (`draw`) and of making its rows (`resolve`)
+void measure(Framebuffer& fb, const std::vector<uint32_t>& texels, float& draw, float& resolve)
+{
+    // Warm up caches
+    drawWalls(fb, texels);
+    fb.resolve(false);
+
+    duration<float, std::milli> drawTotal(0), resolveTotal(0);
+    for(int f = 0; f < FRAME_COUNT; f++)
+    {
+        steady_clock::time_point start = steady_clock::now();
+        drawWalls(fb, texels);
+        steady_clock::time_point drawn = steady_clock::now();
+        fb.resolve(false);
+        drawTotal    += drawn - start;
+        resolveTotal += steady_clock::now() - drawn;
+    }
+    draw    = drawTotal.count() / FRAME_COUNT;
+    resolve = resolveTotal.count() / FRAME_COUNT;
+}
+
+int main()
+{
+    std::vector<uint32_t> texels(TEXTURE_SIZE * TEXTURE_SIZE);
+    for(int i = 0; i < TEXTURE_SIZE * TEXTURE_SIZE; i++)
+        texels[i] = enColor(i * 7, i * 13, i * 29, 255);
+
+    const int resolutions[][2] = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+    for(const int* resolution : resolutions)
+    {
+        Framebuffer fb;
+        float rowDraw, rowResolve, columnDraw, columnResolve;
+        fb.setColumnMajor(false);
+        fb.resize(resolution[0], resolution[1]);
+        measure(fb, texels, rowDraw, rowResolve);
+        fb.setColumnMajor(true);
+        measure(fb, texels, columnDraw, columnResolve);
+
+        std::cout << resolution[0] << "x" << resolution[1] << "\n";
+        std::cout << "  row-major:    " << rowDraw << " ms/frame\n";
+        std::cout << "  column-major: " << columnDraw + columnResolve << " ms/frame (" << columnDraw << " drawing, ";
+        std::cout << columnResolve << " transposing)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,483 @@
+
+/**
+ * Measures the hot kernels the renderer is made of one by one: DDA ray walking, wall intersection, `Vector2`
+ * operations, wall metrics, tile lookups, the color/number/pixel helpers and whole frames drawn by the software
+ * column kernels of a headless engine, unlit and lit. Every kernel runs in batches which are made long enough to time
+ * reliably (this warms it up too), then it is timed over several repetitions; the median time per operation is what
+ * gets compared, mean, deviation and minimum tell how noisy it was.
+ *
+ * Usage:
+ *   RPGE-bench-kernels [--filter TEXT] [--repetitions N] [--json FILE]
+ *       Runs kernels whose names contain TEXT (all by default) and optionally writes the results to FILE as JSON.
+ *   RPGE-bench-kernels --compare OLD NEW [--threshold PERCENT]
+ *       Compares two result files and lists kernels which got slower by more than PERCENT (5 by default), exit
+ *       code is 1 when there is any such regression.
+ *
+ * Textures of the scene are written to the working directory as `bench_kernels_texture_<N>.bmp` files.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <RPGE_dda.hpp>
+#include <RPGE_engine.hpp>
+#include <RPGE_generator.hpp>
+#include <RPGE_pixel.hpp>
+#include <RPGE_scene.hpp>
+
+#define SCENE_SIZE       128
+#define INPUT_COUNT      4096   // Inputs every kernel cycles through, so values do not get predictable
+#define MAX_DISTANCE     48
+#define FRAME_WIDTH      640    // Size of the frames drawn by the engine
+#define FRAME_HEIGHT     400
+#define FRAME_BATCH      8      // Frames of a batch, they make a full turn of the camera
+#define TEXTURE_COUNT    4
+#define TEXTURE_SIZE     64
+#define MIN_SAMPLE_TIME  2.0    // Milliseconds a repetition takes at least
+#define WARMUP_SAMPLES   3
+#define REPETITIONS      21
+#define THRESHOLD        5.0f   // Percent of slowdown considered a regression
+
+using namespace rpge;
+using ::std::chrono::steady_clock;
+using ::std::chrono::duration;
+
+struct Kernel {
+    std::string                 name;
+    std::function<long long()>  batch; // Runs the kernel over all of its inputs, returns the amount of operations done
+};
+
+struct Result {
+    std::string name;
+    long long   operations;  // Operations of a single repetition
+    double      median;      // Nanoseconds per operation
+    double      mean;
+    double      deviation;
+    double      minimum;
+};
+
+// Results are added to it so the compiler can not drop the kernels as dead code
+static volatile double sink = 0;
+
+// Draws `FRAME_BATCH` frames making a full turn of camera `camera` with the software kernels of engine `engine`,
+// lit when `lit` is true; returns amount of pixels drawn
+long long drawFrames(Engine& engine, Camera& camera, bool lit)
+{
+    engine.setLightBehavior(lit, 0.7f);
+    for(int f = 0; f < FRAME_BATCH; f++)
+    {
+        camera.changeDirection(2 * M_PI / FRAME_BATCH);
+        engine.render();
+        engine.tick();
+    }
+    sink = sink + engine.getFramebuffer()->getRow(FRAME_HEIGHT / 2)[FRAME_WIDTH / 2];
+    return (long long)FRAME_BATCH * FRAME_WIDTH * FRAME_HEIGHT;
+}
+
+// Makes all kernels, their inputs are captured by them
+std::vector<Kernel> makeKernels(Scene& scene, Engine& engine, Camera& camera, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> coord(1, SCENE_SIZE - 1);
+    std::uniform_real_distribution<float> unit(0, 1);
+    std::uniform_real_distribution<float> angle(0, 2 * M_PI);
+    std::uniform_int_distribution<int> tile(-2, SCENE_SIZE + 1);
+
+    auto starts     = std::make_shared<std::vector<Vector2>>();
+    auto directions = std::make_shared<std::vector<Vector2>>();
+    auto locals     = std::make_shared<std::vector<Vector2>>();
+    auto angles     = std::make_shared<std::vector<float>>();
+    auto tiles      = std::make_shared<std::vector<std::pair<int, int>>>();
+    auto colors     = std::make_shared<std::vector<uint32_t>>();
+    for(int i = 0; i < INPUT_COUNT; i++)
+    {
+        starts->push_back(Vector2(coord(rng), coord(rng)));
+        directions->push_back(Vector2::RIGHT.rotate(angle(rng)));
+        locals->push_back(Vector2(unit(rng), unit(rng)));
+        angles->push_back(angle(rng));
+        tiles->push_back(std::make_pair(tile(rng), tile(rng)));
+        colors->push_back(rng());
+    }
+    auto walls = std::make_shared<std::vector<WallData>>();
+    walls->push_back(WallData(LinearFunc(0, 0), 0, 0, 1, 0, true));
+    walls->push_back(WallData(Vector2(0, 0), Vector2(0, 1), 0, 0, 1, 0, true));
+    walls->push_back(WallData(LinearFunc(1, 0), 0, 0, 1, 0, false));
+    walls->push_back(WallData(LinearFunc(0.3f, 0.2f), 0, 0.5f, 1.3f, 0, false));
+    auto texts = std::make_shared<std::vector<std::string>>(std::vector<std::string>{
+        "0", "12", "-3.5", "1.0023e+2", "6.02E-23", ".5", "128.", "+7", "wall", "1e", "--1", "3.14.15", "0x1F", ""
+    });
+    auto dda = std::make_shared<DDA>(&scene, MAX_DISTANCE);
+
+    std::vector<Kernel> kernels;
+    kernels.push_back({ "dda init", [=]{
+        for(int i = 0; i < INPUT_COUNT; i++)
+            dda->init((*starts)[i], (*directions)[i]);
+        sink = sink + dda->rayFlag;
+        return (long long)INPUT_COUNT;
+    } });
+    // Every ray is walked until it leaves the reach, operations are `next` calls
+    kernels.push_back({ "dda next", [=]{
+        long long steps = 0;
+        float distance = 0;
+        for(int i = 0; i < INPUT_COUNT; i += 8)
+        {
+            dda->init((*starts)[i], (*directions)[i]);
+            while(true)
+            {
+                RayHitInfo hit = dda->next();
+                steps++;
+                if(dda->rayFlag & (DDA::RF_TOO_FAR | DDA::RF_OUTSIDE | DDA::RF_FAIL))
+                    break;
+                distance += hit.distance;
+            }
+        }
+        sink = sink + distance;
+        return steps;
+    } });
+    kernels.push_back({ "wall intersect", [=]{
+        float total = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+        {
+            float distance, u;
+            if((*walls)[i & 3].intersect((*locals)[i], (*directions)[i], distance, u))
+                total += distance + u;
+        }
+        sink = sink + total;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "wall update metrics", [=]{
+        float total = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+        {
+            WallData& wall = (*walls)[i & 3];
+            wall.updateMetrics();
+            total += wall.length;
+        }
+        sink = sink + total;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "vector2 arithmetic", [=]{
+        Vector2 total(0, 0);
+        for(int i = 0; i < INPUT_COUNT; i++)
+            total += (*starts)[i] - (*directions)[i] * (*locals)[i].x;
+        sink = sink + total.x + total.y;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "vector2 dot", [=]{
+        float total = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+            total += (*starts)[i].dot((*directions)[i]);
+        sink = sink + total;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "vector2 normalized", [=]{
+        Vector2 total(0, 0);
+        for(int i = 0; i < INPUT_COUNT; i++)
+            total += (*starts)[i].normalized();
+        sink = sink + total.x + total.y;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "vector2 rotate", [=]{
+        Vector2 total(0, 0);
+        for(int i = 0; i < INPUT_COUNT; i++)
+            total += (*directions)[i].rotate((*angles)[i]);
+        sink = sink + total.x + total.y;
+        return (long long)INPUT_COUNT;
+    } });
+    // Some of the coordinates are outside of the scene, the way DDA asks for them near the edges
+    kernels.push_back({ "scene get tile id", [=, &scene]{
+        long long total = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+            total += scene.getTileId((*tiles)[i].first, (*tiles)[i].second);
+        sink = sink + total;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "is float", [=]{
+        int total = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+            total += isFloat((*texts)[i % texts->size()]);
+        sink = sink + total;
+        return (long long)INPUT_COUNT;
+    } });
+    // Operations are pixels of the frames, their walls are solid-colored and textured
+    kernels.push_back({ "software frame", [&engine, &camera]{
+        return drawFrames(engine, camera, false);
+    } });
+    kernels.push_back({ "software frame lit", [&engine, &camera]{
+        return drawFrames(engine, camera, true);
+    } });
+    kernels.push_back({ "blend shade pixel", [=]{
+        uint32_t pixel = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+            pixel = shadePixel(blendPixel(pixel, (*colors)[i], (*colors)[i] >> 24), i & 255);
+        sink = sink + pixel;
+        return (long long)INPUT_COUNT;
+    } });
+    kernels.push_back({ "de color", [=]{
+        uint32_t total = 0;
+        for(int i = 0; i < INPUT_COUNT; i++)
+        {
+            uint8_t r, g, b, a;
+            deColor((*colors)[i], r, g, b, a);
+            total += r + g + b + a;
+        }
+        sink = sink + total;
+        return (long long)INPUT_COUNT;
+    } });
+    return kernels;
+}
+
+// Returns median, mean, deviation and minimum time per operation of kernel `kernel` over `repetitions` repetitions
+Result measure(const Kernel& kernel, int repetitions)
+{
+    // Find how many batches make a repetition long enough, which also warms up caches and branch predictors
+    int batches = 1;
+    long long operations = 0;
+    while(true)
+    {
+        steady_clock::time_point start = steady_clock::now();
+        operations = 0;
+        for(int b = 0; b < batches; b++)
+            operations += kernel.batch();
+        duration<double, std::milli> time = steady_clock::now() - start;
+        if(time.count() >= MIN_SAMPLE_TIME)
+            break;
+        batches *= 2;
+    }
+
+    std::vector<double> samples;
+    for(int s = -WARMUP_SAMPLES; s < repetitions; s++)
+    {
+        steady_clock::time_point start = steady_clock::now();
+        operations = 0;
+        for(int b = 0; b < batches; b++)
+            operations += kernel.batch();
+        duration<double, std::nano> time = steady_clock::now() - start;
+        if(s >= 0)
+            samples.push_back(time.count() / operations);
+    }
+
+    Result result;
+    result.name       = kernel.name;
+    result.operations = operations;
+    std::sort(samples.begin(), samples.end());
+    int middle = samples.size() / 2;
+    result.median  = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+    result.minimum = samples.front();
+    result.mean    = 0;
+    for(double sample : samples)
+        result.mean += sample / samples.size();
+    result.deviation = 0;
+    for(double sample : samples)
+        result.deviation += (sample - result.mean) * (sample - result.mean) / samples.size();
+    result.deviation = sqrt(result.deviation);
+    return result;
+}
+
+// Writes results `results` to file `file` as JSON, returns false if it can not be written
+bool writeResults(const std::string& file, const std::vector<Result>& results)
+{
+    std::ofstream stream(file);
+    if(!stream.good())
+        return false;
+    stream << std::setprecision(6) << "{\n  \"unit\": \"ns/op\",\n  \"results\": [\n";
+    for(int r = 0; r < (int)results.size(); r++)
+    {
+        const Result& result = results[r];
+        stream << "    { \"name\": \"" << result.name << "\", \"operations\": " << result.operations;
+        stream << ", \"median\": " << result.median << ", \"mean\": " << result.mean;
+        stream << ", \"deviation\": " << result.deviation << ", \"minimum\": " << result.minimum << " }";
+        stream << (r + 1 < (int)results.size() ? ",\n" : "\n");
+    }
+    stream << "  ]\n}\n";
+    return stream.good();
+}
+
+// Returns number following key `key` in JSON object text `object`, or -1 when it is not there
+double readNumber(const std::string& object, const std::string& key)
+{
+    size_t at = object.find("\"" + key + "\"");
+    if(at == std::string::npos || (at = object.find(':', at)) == std::string::npos)
+        return -1;
+    return strtod(object.c_str() + at + 1, nullptr);
+}
+
+// Reads results written by `writeResults` from file `file` to `results`, returns false if it can not be read. Only
+// the format written above is understood: flat result objects with string names free of quotes.
+bool readResults(const std::string& file, std::vector<Result>& results)
+{
+    std::ifstream stream(file);
+    if(!stream.good())
+        return false;
+    std::stringstream text;
+    text << stream.rdbuf();
+    std::string json = text.str();
+
+    size_t at = json.find("\"results\"");
+    if(at == std::string::npos)
+        return false;
+    while((at = json.find('{', at + 1)) != std::string::npos)
+    {
+        size_t end = json.find('}', at);
+        if(end == std::string::npos)
+            return false;
+        std::string object = json.substr(at, end - at + 1);
+        size_t name = object.find("\"name\"");
+        size_t open = name == std::string::npos ? name : object.find('"', object.find(':', name));
+        size_t close = open == std::string::npos ? open : object.find('"', open + 1);
+        if(close == std::string::npos)
+            return false;
+
+        Result result;
+        result.name       = object.substr(open + 1, close - open - 1);
+        result.operations = readNumber(object, "operations");
+        result.median     = readNumber(object, "median");
+        result.mean       = readNumber(object, "mean");
+        result.deviation  = readNumber(object, "deviation");
+        result.minimum    = readNumber(object, "minimum");
+        results.push_back(result);
+        at = end;
+    }
+    return true;
+}
+
+// Prints how results of file `newFile` differ from those of `oldFile`, returns exit code (1 on regressions)
+int compare(const std::string& oldFile, const std::string& newFile, float threshold)
+{
+    std::vector<Result> oldResults, newResults;
+    if(!readResults(oldFile, oldResults) || !readResults(newFile, newResults))
+    {
+        std::cerr << "Can not read results from " << (oldResults.empty() ? oldFile : newFile) << "\n";
+        return 2;
+    }
+
+    int regressions = 0;
+    std::cout << std::left << std::setw(24) << "kernel" << std::right << std::setw(12) << "old ns/op";
+    std::cout << std::setw(12) << "new ns/op" << std::setw(10) << "change" << "\n";
+    for(const Result& newResult : newResults)
+    {
+        const Result* oldResult = nullptr;
+        for(const Result& result : oldResults)
+            if(result.name == newResult.name)
+                oldResult = &result;
+        std::cout << std::left << std::setw(24) << newResult.name << std::right << std::fixed << std::setprecision(2);
+        if(oldResult == nullptr || oldResult->median <= 0)
+        {
+            std::cout << std::setw(12) << "-" << std::setw(12) << newResult.median << "       new\n";
+            continue;
+        }
+        float change = (newResult.median / oldResult->median - 1) * 100;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        std::cout << std::setw(12) << oldResult->median << std::setw(12) << newResult.median;
+        std::cout << std::showpos << std::setw(9) << change << "%" << std::noshowpos;
+        std::cout << (regressed ? "  REGRESSION" : (change < -threshold ? "  faster" : "")) << "\n";
+    }
+    for(const Result& oldResult : oldResults)
+    {
+        bool kept = false;
+        for(const Result& result : newResults)
+            kept |= result.name == oldResult.name;
+        if(!kept)
+            std::cout << std::left << std::setw(24) << oldResult.name << std::right << "  missing in " << newFile << "\n";
+    }
+
+    std::cout << regressions << " regression(s) above " << threshold << "%\n";
+    return regressions > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter, jsonFile, oldFile, newFile;
+    int repetitions = REPETITIONS;
+    float threshold = THRESHOLD;
+    for(int a = 1; a < argc; a++)
+    {
+        bool hasValue = a + 1 < argc;
+        if(!strcmp(argv[a], "--filter") && hasValue)
+            filter = argv[++a];
+        else if(!strcmp(argv[a], "--repetitions") && hasValue)
+            repetitions = std::max(1, atoi(argv[++a]));
+        else if(!strcmp(argv[a], "--json") && hasValue)
+            jsonFile = argv[++a];
+        else if(!strcmp(argv[a], "--threshold") && hasValue)
+            threshold = atof(argv[++a]);
+        else if(!strcmp(argv[a], "--compare") && a + 2 < argc)
+        {
+            oldFile = argv[++a];
+            newFile = argv[++a];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter TEXT] [--repetitions N] [--json FILE]\n";
+            std::cerr << "       " << argv[0] << " --compare OLD NEW [--threshold PERCENT]\n";
+            return 2;
+        }
+    }
+    if(!oldFile.empty())
+        return compare(oldFile, newFile, threshold);
+
+    Engine engine(FRAME_WIDTH, FRAME_HEIGHT, true);
+    if(engine.getError())
+    {
+        std::cerr << "Can not start headless engine: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    engine.setRenderMode(RM_SOFTWARE);
+    engine.setResolutionGovernor(false);
+    engine.setFrameRate(1000000); // Frames are never waited for
+    engine.getWalker()->setMaxTileDistance(MAX_DISTANCE);
+
+    // Few of the tiles have walls and over a third of those is see-through, so rays walk far
+    GeneratorSettings settings;
+    settings.width            = SCENE_SIZE;
+    settings.height           = SCENE_SIZE;
+    settings.wallDensity      = 0.08f;
+    settings.transparentRatio = 0.375f;
+    settings.textureCount     = TEXTURE_COUNT;
+    settings.texturePrefix    = "bench_kernels_texture_";
+    SceneGenerator generator(settings);
+    if(!generator.writeTextures(TEXTURE_SIZE))
+    {
+        std::cerr << "Can not write textures: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    Scene scene(engine.getRendererHandle(), SCENE_SIZE, SCENE_SIZE);
+    generator.fill(scene);
+    Camera camera(Vector2(SCENE_SIZE / 2 + 0.5f, SCENE_SIZE / 2 + 0.5f), 0, M_PI_2);
+    engine.setMainCamera(&camera);
+    engine.getWalker()->setTargetScene(&scene);
+
+    std::mt19937 rng(2024);
+
+    std::vector<Result> results;
+    std::cout << std::left << std::setw(24) << "kernel" << std::right << std::setw(12) << "median ns";
+    std::cout << std::setw(12) << "mean ns" << std::setw(12) << "deviation" << std::setw(12) << "minimum" << "\n";
+    for(const Kernel& kernel : makeKernels(scene, engine, camera, rng))
+    {
+        if(kernel.name.find(filter) == std::string::npos)
+            continue;
+        Result result = measure(kernel, repetitions);
+        results.push_back(result);
+        std::cout << std::left << std::setw(24) << result.name << std::right << std::fixed << std::setprecision(3);
+        std::cout << std::setw(12) << result.median << std::setw(12) << result.mean << std::setw(12) << result.deviation;
+        std::cout << std::setw(12) << result.minimum << "\n";
+    }
+
+    if(!jsonFile.empty() && !writeResults(jsonFile, results))
+    {
+        std::cerr << "Can not write results to " << jsonFile << "\n";
+        return 2;
+    }
+    return 0;
+}
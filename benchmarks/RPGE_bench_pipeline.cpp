@@ -0,0 +1,230 @@
+
+/**
+ * Measures throughput and latency of frames whose game logic runs serially before drawing, against frames pipelined
+ * with a simulation thread (see `Simulation`). The logic is a fixed-timestep tick which moves the camera along an
+ * empty row of a generated scene, answers a batch of line-of-sight queries and now and then opens or closes a door
+ * tile; frames are drawn by a headless engine in the software mode as fast as it allows.
+ *
+ * Usage:
+ *   RPGE-bench-pipeline [--ticks N] [--queries N] [--seconds F] [--size W H]
+ *
+ * Latency is the time from the end of the tick whose state a frame shows to the moment the frame is presented.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <RPGE_engine.hpp>
+#include <RPGE_generator.hpp>
+#include <RPGE_simulation.hpp>
+
+#define SCREEN_WIDTH   640
+#define SCREEN_HEIGHT  400
+#define SCENE_SIZE     256
+#define SIGHTLINES     8
+#define TICK_RATE      60
+#define QUERY_COUNT    20000
+#define SECONDS        3.0f
+#define DOOR_TICKS     30     // Ticks between door changes
+#define CAMERA_SPEED   3.0f   // Tiles per second
+
+using namespace rpge;
+using ::std::chrono::steady_clock;
+using ::std::chrono::duration;
+
+/**
+ * Game logic shared by both ways of running it, everything it changes is the camera and the scene.
+ */
+struct Game {
+    Scene*                   scene;
+    Camera*                  camera;
+    std::vector<RayQuery>    queries;
+    std::vector<RayQueryHit> hits;
+    float                    direction; // Camera goes along the row to the right (1) or to the left (-1)
+    int                      tick;
+
+    Game(Scene* scene, Camera* camera, int queryCount) : scene(scene), camera(camera), direction(1), tick(0)
+    {
+        std::mt19937 rng(2024);
+        std::uniform_real_distribution<float> coord(1, scene->getWidth() - 1);
+        std::uniform_real_distribution<float> angle(0, 2 * M_PI);
+        for(int i = 0; i < queryCount; i++)
+            queries.push_back(RayQuery(Vector2(coord(rng), coord(rng)), Vector2::RIGHT.rotate(angle(rng)), 32));
+        hits.resize(queryCount);
+    }
+
+    // Advances the game by `dt` seconds
+    void update(float dt)
+    {
+        Vector2 position = camera->getPosition() + Vector2(direction * CAMERA_SPEED * dt, 0);
+        if(position.x < 2 || position.x > scene->getWidth() - 2)
+            direction = -direction;
+        camera->setPosition(position);
+        camera->changeDirection(0.4f * dt);
+
+        scene->castRays(queries.data(), hits.data(), queries.size());
+        if(++tick % DOOR_TICKS == 0)
+            scene->setTileId(SIGHTLINES * 2, SIGHTLINES * 4, tick / DOOR_TICKS % 2 ? SceneGenerator::SOLID_KIND : 0);
+    }
+};
+
+struct Result {
+    int   frames;
+    int   ticks;
+    float seconds;
+    float latency;  // Mean latency in milliseconds
+    float tickTime; // Mean update time in milliseconds
+};
+
+// Draws frames for `seconds` with the game ticked on the calling thread before each frame, as many ticks as the
+// time passed requires
+Result runSerial(Engine& engine, Scene& scene, Camera& camera, int tickRate, int queryCount, float seconds)
+{
+    Game game(&scene, &camera, queryCount);
+    engine.setSimulation(nullptr);
+    engine.setMainCamera(&camera);
+    engine.getWalker()->setTargetScene(&scene);
+
+    const float period = 1.0f / tickRate;
+    Result result = { 0, 0, 0, 0, 0 };
+    float pending = 0, latencySum = 0, tickSum = 0;
+    steady_clock::time_point start = steady_clock::now(), last = start, tickEnd = start;
+    while(duration<float>(steady_clock::now() - start).count() < seconds)
+    {
+        steady_clock::time_point now = steady_clock::now();
+        pending += duration<float>(now - last).count();
+        last = now;
+        while(pending >= period)
+        {
+            steady_clock::time_point tickStart = steady_clock::now();
+            game.update(period);
+            tickEnd = steady_clock::now();
+            tickSum += duration<float>(tickEnd - tickStart).count();
+            pending -= period;
+            result.ticks++;
+        }
+        engine.render();
+        engine.tick();
+        latencySum += duration<float>(steady_clock::now() - tickEnd).count();
+        result.frames++;
+    }
+    result.seconds  = duration<float>(steady_clock::now() - start).count();
+    result.latency  = 1000 * latencySum / result.frames;
+    result.tickTime = result.ticks > 0 ? 1000 * tickSum / result.ticks : 0;
+    return result;
+}
+
+// Draws frames for `seconds` while the game is ticked by a simulation thread
+Result runPipelined(Engine& engine, Scene& scene, Camera& camera, int tickRate, int queryCount, float seconds)
+{
+    Game game(&scene, &camera, queryCount);
+    Simulation simulation(&scene, &camera, tickRate);
+    simulation.setUpdate([&game](float dt) { game.update(dt); });
+    engine.setSimulation(&simulation);
+
+    Result result = { 0, 0, 0, 0, 0 };
+    float latencySum = 0;
+    simulation.start();
+    steady_clock::time_point start = steady_clock::now();
+    while(duration<float>(steady_clock::now() - start).count() < seconds)
+    {
+        engine.render();
+        engine.tick();
+        latencySum += engine.getSnapshotLatency();
+        result.frames++;
+    }
+    result.seconds = duration<float>(steady_clock::now() - start).count();
+    simulation.stop();
+    engine.setSimulation(nullptr);
+
+    result.ticks    = simulation.getTickCount();
+    result.latency  = 1000 * latencySum / result.frames;
+    result.tickTime = 1000 * simulation.getAverageTickTime();
+    return result;
+}
+
+// Prints result `result` of the run named `name`
+void printResult(const char* name, const Result& result)
+{
+    std::cout << name << ": " << result.frames / result.seconds << " frames/s, ";
+    std::cout << 1000 * result.seconds / result.frames << " ms per frame, ";
+    std::cout << result.ticks / result.seconds << " ticks/s (" << result.tickTime << " ms each), ";
+    std::cout << result.latency << " ms latency\n";
+}
+
+// Prints usage of the program `program` and returns exit code of a wrong invocation
+int printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n";
+    std::cerr << "  --ticks N      simulation ticks per second (" << TICK_RATE << ")\n";
+    std::cerr << "  --queries N    line-of-sight queries per tick (" << QUERY_COUNT << ")\n";
+    std::cerr << "  --seconds F    duration of each run (" << SECONDS << ")\n";
+    std::cerr << "  --size W H     frame size in pixels (" << SCREEN_WIDTH << " " << SCREEN_HEIGHT << ")\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    int tickRate = TICK_RATE, queryCount = QUERY_COUNT, width = SCREEN_WIDTH, height = SCREEN_HEIGHT;
+    float seconds = SECONDS;
+    for(int a = 1; a < argc; a++)
+    {
+        bool hasValue = a + 1 < argc;
+        if(!strcmp(argv[a], "--ticks") && hasValue)
+            tickRate = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--queries") && hasValue)
+            queryCount = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--seconds") && hasValue)
+            seconds = atof(argv[++a]);
+        else if(!strcmp(argv[a], "--size") && a + 2 < argc)
+        {
+            width  = atoi(argv[++a]);
+            height = atoi(argv[++a]);
+        }
+        else
+            return printUsage(argv[0]);
+    }
+    if(tickRate < 1 || queryCount < 0 || seconds <= 0 || width < 1 || height < 1)
+        return printUsage(argv[0]);
+
+    Engine engine(width, height, true);
+    if(engine.getError())
+    {
+        std::cerr << "Can not start headless engine: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    engine.setRenderMode(RM_SOFTWARE);
+    engine.setResolutionGovernor(false);
+    engine.setFrameRate(1000);
+    engine.getWalker()->setMaxTileDistance(64);
+
+    GeneratorSettings settings;
+    settings.width            = SCENE_SIZE;
+    settings.height           = SCENE_SIZE;
+    settings.sightlineSpacing = SIGHTLINES;
+    SceneGenerator generator(settings);
+    const Vector2 origin(2.5f, SIGHTLINES * 16 + 0.5f);
+
+    std::cout << SCENE_SIZE << "x" << SCENE_SIZE << " scene, " << width << "x" << height << " frames, ";
+    std::cout << tickRate << " ticks/s with " << queryCount << " queries each\n";
+
+    Scene serialScene(engine.getRendererHandle(), SCENE_SIZE, SCENE_SIZE);
+    generator.fill(serialScene);
+    Camera serialCamera(origin, 0, M_PI_2);
+    Result serial = runSerial(engine, serialScene, serialCamera, tickRate, queryCount, seconds);
+
+    Scene pipelinedScene(nullptr, SCENE_SIZE, SCENE_SIZE);
+    generator.fill(pipelinedScene);
+    Camera pipelinedCamera(origin, 0, M_PI_2);
+    Result pipelined = runPipelined(engine, pipelinedScene, pipelinedCamera, tickRate, queryCount, seconds);
+
+    printResult("serial   ", serial);
+    printResult("pipelined", pipelined);
+    std::cout << "pipelined frames are " << serial.seconds / serial.frames / (pipelined.seconds / pipelined.frames);
+    std::cout << "x as frequent\n";
+    return 0;
+}
@@ -0,0 +1,73 @@
+
+/**
+ * Measures how long it takes to answer a frame worth of gameplay ray queries (line of sight, hitscan) using
+ * `Scene::castRays`, both on the calling thread only and split among worker pool threads.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <RPGE_generator.hpp>
+#include <RPGE_scene.hpp>
+#include <RPGE_threads.hpp>
+
+#define SCENE_SIZE    256
+#define QUERY_COUNT   100000
+#define FRAME_COUNT   30
+#define MAX_DISTANCE  64.0f
+
+using namespace rpge;
+using ::std::chrono::steady_clock;
+using ::std::chrono::duration;
+
+// Returns average time in milliseconds of answering all queries once
+float measure(const Scene& scene, const std::vector<RayQuery>& queries, std::vector<RayQueryHit>& hits, WorkerPool* pool)
+{
+    // Warm up caches and worker threads
+    scene.castRays(queries.data(), hits.data(), queries.size(), pool);
+
+    steady_clock::time_point start = steady_clock::now();
+    for(int f = 0; f < FRAME_COUNT; f++)
+        scene.castRays(queries.data(), hits.data(), queries.size(), pool);
+    duration<float, std::milli> total = steady_clock::now() - start;
+    return total.count() / FRAME_COUNT;
+}
+
+int main()
+{
+    // Fifth of the tiles has walls, a quarter of which rays see through
+    GeneratorSettings settings;
+    settings.width            = SCENE_SIZE;
+    settings.height           = SCENE_SIZE;
+    settings.wallDensity      = 0.2f;
+    settings.transparentRatio = 0.25f;
+    Scene scene(nullptr, SCENE_SIZE, SCENE_SIZE);
+    SceneGenerator(settings).fill(scene);
+
+    std::mt19937 rng(2024);
+
+    std::uniform_real_distribution<float> coord(0, SCENE_SIZE);
+    std::uniform_real_distribution<float> angle(0, 2 * M_PI);
+    std::vector<RayQuery> queries;
+    std::vector<RayQueryHit> hits(QUERY_COUNT);
+    for(int i = 0; i < QUERY_COUNT; i++)
+        queries.push_back(RayQuery(Vector2(coord(rng), coord(rng)), Vector2::RIGHT.rotate(angle(rng)), MAX_DISTANCE));
+
+    WorkerPool pool;
+    float serial   = measure(scene, queries, hits, nullptr);
+    float parallel = measure(scene, queries, hits, &pool);
+
+    int hitCount = 0, blockedCount = 0;
+    for(const RayQueryHit& hit : hits)
+    {
+        hitCount += hit.hit;
+        blockedCount += hit.blocked;
+    }
+
+    std::cout << QUERY_COUNT << " queries on " << SCENE_SIZE << "x" << SCENE_SIZE << " scene (";
+    std::cout << hitCount << " hits, " << blockedCount << " blocked)\n";
+    std::cout << "  1 thread:  " << serial << " ms/frame\n";
+    std::cout << "  " << pool.getThreadCount() << " threads: " << parallel << " ms/frame\n";
+    return 0;
+}
@@ -51,6 +51,10 @@ namespace rpge {
             /* Returns camera position */
             Vector2 getPosition() const;
 
+            /* Returns camera which is `t` (0 - 1) of the way from this one to camera `next`: position and field of
+               view go linearly, direction turns along the shorter arc */
+            Camera  interpolate(const Camera& next, float t) const;
+
             /* Sets the looking direction to angle of `radians` rad counter-clockwise */
             void    setDirection(float radians);
 
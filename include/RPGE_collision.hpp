@@ -0,0 +1,98 @@
+
+#ifndef _RPGE_COLLISION_HPP
+#define _RPGE_COLLISION_HPP
+
+#include <vector>
+#include "RPGE_globals.hpp"
+#include "RPGE_math.hpp"
+#include "RPGE_scene.hpp"
+#include "RPGE_threads.hpp"
+
+namespace rpge {
+    using ::std::vector;
+
+    /**
+     * Describes a moving object (player, NPC) as a vertical cylinder: a circle of `radius` when looked at from
+     * the top, occupying heights from `hMin` to `hMax` (in the same units as `WallData` height range).
+     */
+    struct CollisionBody {
+        Vector2 position; // Center of the body in global coordinates
+        float radius;     // Radius of the body circle
+        float hMin, hMax; // Range of heights occupied by the body
+
+        CollisionBody();
+        CollisionBody(const Vector2& position, float radius);
+        CollisionBody(const Vector2& position, float radius, float hMin, float hMax);
+    };
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const CollisionBody& body);
+    #endif
+
+    /**
+     * Wall line segment in global coordinates, collected from the scene by `Collider` class.
+     */
+    struct CollisionSegment {
+        Vector2 start, end;
+
+        CollisionSegment();
+        CollisionSegment(const Vector2& start, const Vector2& end);
+    };
+
+    /**
+     * Moves collision bodies through a scene (instance of `Scene` class) so they do not pass through walls, a
+     * body hitting a wall slides along it instead of stopping. Set the target scene using `setTargetScene`
+     * method and then call `move` method for every body, or `moveAll` to resolve many of them at once.
+     *
+     * Only tiles overlapping the bounds of a swept body are examined. A wall blocks a body when their height
+     * ranges overlap, walls that do not stop rays can be ignored using `setSolidOnly` method.
+     */
+    class Collider {
+        private:
+            bool         solidOnly;
+            int          maxIterations;
+            float        skinWidth;
+            const Scene* scene;
+
+            // Finds the earliest fraction `time` of `delta` at which a circle moving from `position` touches `segment`,
+            // `normal` is then set to the direction the circle should be pushed away in
+            static bool sweep(const Vector2& position, const Vector2& delta, float radius, const CollisionSegment& segment, float& time, Vector2& normal);
+            // Returns point of `segment` located the nearest to `point`
+            static Vector2 closestPoint(const Vector2& point, const CollisionSegment& segment);
+
+            // Appends segments of walls able to block `body` in tiles overlapping given bounds to `segments` vector
+            void gatherSegments(const CollisionBody& body, const Vector2& boundMin, const Vector2& boundMax, vector<CollisionSegment>& segments) const;
+            // Version of `move` method working on external segments buffer, so batches can reuse it
+            Vector2 move(CollisionBody& body, const Vector2& delta, vector<CollisionSegment>& segments) const;
+        public:
+            static const int BATCH_GRAIN; // Amount of bodies processed by a worker at once
+
+            Collider();
+            Collider(const Scene* scene);
+
+            /* Returns pointer to the target `Scene` class instance, whose walls are collided with */
+            const Scene* getTargetScene() const;
+
+            /* Moves `body` by `delta` vector, sliding along the walls it hits. Returns the displacement that
+               was actually applied. */
+            Vector2      move(CollisionBody& body, const Vector2& delta) const;
+
+            /* Performs `move` for each of `count` bodies from `bodies` array using displacements at the respective
+               indices of `deltas` array. Version with `pool` argument splits large batches among its worker threads. */
+            void         moveAll(CollisionBody* bodies, const Vector2* deltas, int count) const;
+            void         moveAll(CollisionBody* bodies, const Vector2* deltas, int count, WorkerPool* pool) const;
+
+            /* Sets maximum amount of slides performed during a single move */
+            void         setMaxIterations(int n);
+
+            /* Sets distance kept between a body and the wall it has hit, it prevents sticking to walls */
+            void         setSkinWidth(float width);
+
+            /* The `solidOnly` flag tells whether walls that do not stop rays should be passable */
+            void         setSolidOnly(bool solidOnly);
+
+            /* Sets the target scene, whose walls will be collided with */
+            void         setTargetScene(const Scene* scene);
+    };
+}
+
+#endif
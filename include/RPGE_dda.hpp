@@ -69,6 +69,10 @@ namespace rpge {
             /* Returns a pointer to the target `Scene` class instance, on which DDA is performed */
             Scene*     getTargetScene();
 
+            /* Returns point at which the ray entered tile described by `hit` (the latest one returned by `next`
+             * method) in local tile coordinates. For the origin tile it is the starting point itself. */
+            Vector2    getLocalEnter(const RayHitInfo& hit) const;
+
             /* Prepares things that are necessary for performing continous ray-walking */
             void       init(const Vector2& start, const Vector2& direction);
 
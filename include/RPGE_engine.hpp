@@ -4,20 +4,30 @@
 
 #include <chrono>
 #include <cmath>
-#include <map>
 #include <memory>
 #include <SDL2/SDL.h>
 #include "RPGE_camera.hpp"
 #include "RPGE_dda.hpp"
+#include "RPGE_framebuffer.hpp"
 #include "RPGE_globals.hpp"
+#include "RPGE_governor.hpp"
+#include "RPGE_input.hpp"
 #include "RPGE_math.hpp"
+#include "RPGE_memory.hpp"
+#include "RPGE_overlay.hpp"
+#include "RPGE_pacer.hpp"
+#include "RPGE_palette.hpp"
+#include "RPGE_post.hpp"
 #include "RPGE_scene.hpp"
+#include "RPGE_simd.hpp"
+#include "RPGE_simulation.hpp"
+#include "RPGE_trace.hpp"
+#include "RPGE_visibility.hpp"
 
 namespace rpge {
     using ::std::chrono::time_point;
-    using ::std::chrono::system_clock;
+    using ::std::chrono::steady_clock;
     using ::std::chrono::duration;
-    using ::std::map;
     using ::std::unique_ptr;
     using ::std::pair;
     using ::std::make_pair;
@@ -31,6 +41,38 @@ namespace rpge {
         UP     // Key is not pressed anymore (single event)
     };
 
+    enum RenderBackend {
+        RB_AUTO,        // Picks one of the others for every frame, the one expected to be faster
+        RB_RAYCAST,     // Casts rays through the tiles, one per pixel column (or per run of columns)
+        RB_OBJECT_ORDER // Projects walls of the tiles in the view frustum onto the screen
+    };
+
+    enum RenderMode {
+        RM_HARDWARE, // Walls are drawn by the SDL renderer
+        RM_SOFTWARE  // Walls are drawn into the framebuffer on the CPU, which goes through post passes to the screen
+    };
+
+    /**
+     * Wall line drawn in a pixel column, kept by the renderer for the frame it was drawn in. When `hit` flag is not
+     * set, the rest of members should not be trusted.
+     */
+    struct ColumnSample {
+        bool    hit;       // Whether any wall was drawn
+        int     tileId;    // ID of the tile the wall belongs to
+        int     wallIndex; // Index of the wall in vector returned by `Scene::getTileWalls`
+        int     drawStart; // Top of the wall line in screen coordinates
+        int     drawEnd;   // Bottom of the wall line in screen coordinates
+        float   depth;     // Perpendicular distance from the camera plane
+        float   u;         // Position of the seen point along the wall, from its start (0) to its end (1)
+        Vector2 tile;      // Position of the tile
+        Vector2 point;     // Global position of the seen point
+
+        ColumnSample();
+    };
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const ColumnSample& sample);
+    #endif
+
     class Engine {
         private:
             bool                     bClear;
@@ -38,6 +80,7 @@ namespace rpge {
             bool                     bLightEnabled;
             bool                     bRedraw;
             bool                     bRun;
+            bool                     bSpanCoherence;
             int                      iError;
             int                      iColumnsPerRay;
             int                      iFramesPerSecond;
@@ -45,19 +88,237 @@ namespace rpge {
             int                      iScreenWidth;
             int                      iScreenHeight;
             float                    fAspectRatio;
+            float                    fOpacityThreshold; // Opacity at which translucent walls hide what is behind them
             SDL_Color                cClearColor;
             uint64_t                 frameIndex;
+            uint64_t                 frameAllocations; // Heap allocations made during the last `tick` call
             Vector2                  vLightDir;
-            time_point<system_clock> tpLast;
+            time_point<steady_clock> tpLast;
             duration<float>          elapsedTime;
             SDL_Rect                 rClearArea;
             SDL_Rect                 rRenderArea;
-            map<int, KeyState>       keyStates; // SDL Scancode -> State of that key
+            KeyState                 keyStates[SDL_NUM_SCANCODES]; // SDL Scancode -> State of that key
+            uint8_t                  keyFlags[SDL_NUM_SCANCODES];  // SDL Scancode -> `KF_<name>` flags of that key
+            int                      dirtyKeys[SDL_NUM_SCANCODES]; // Scancodes of keys whose state changes in the next frame
+            int                      dirtyCount;
+            InputQueue               inputQueue;   // Events captured by the SDL event watch
+            vector<InputEvent>       frameInputs;  // Events processed during the last frame
+            float                    fInputLatency;
+            float                    fMeanInputLatency;
+            Simulation*              simulation;    // Simulation whose snapshots are drawn, null pointer when not pipelined
+            Camera                   frameCamera;   // Camera of the drawn snapshot, between the two latest ticks
+            unique_ptr<Scene>        frameScene;    // Scene viewing data of the drawn snapshot
+            Scene*                   serialScene;   // Target scene of the walker before frames were pipelined
+            bool                     bFreshSnapshot; // Whether the drawn snapshot was not drawn by any previous frame
+            float                    fSnapshotLatency;
+            float                    fMeanSnapshotLatency;
+            int                      iPvsTile;   // Tile index the decoded visibility flags belong to
+            const VisibilitySet*     pvsSource;  // Visibility set the decoded flags come from
+            int                      iPvsRevision; // Revision of the set the decoded flags come from
+            vector<uint8_t>          pvsVisible; // Tiles visible from the camera tile
+
+            int                      iCoherentColumns; // Pixel columns drawn as parts of wall runs in the last frame
+            RenderBackend            backend;          // Backend set by the user
+            RenderBackend            frameBackend;     // Backend which drew the last frame
+            float                    fRaycastCost;     // Average time raycasting takes for a unit of estimated work (see
+                                                       // `estimateWallWork`), -1 when unknown
+            float                    fObjectCost;      // The same for object order
+            const Scene*             costScene;        // Scene the average costs belong to
+            uint64_t                 costGridRevision; // Grid and walls revisions of the cost scene the densities were
+            uint64_t                 costWallsRevision; // sampled at
+            float                    fStopDensity;     // Part of the tiles of the cost scene having walls which stop rays
+            float                    fWallDensity;     // Average amount of walls per tile of the cost scene
+            bool                     bProbeFrame;      // Whether the last frame was drawn by a backend just to measure it
+
+            SDL_Rect                 rSampleArea;          // Render area of the frame the samples come from
+            int                      iSampleColumnsPerRay; // Columns per ray of the frame the samples come from
+            vector<ColumnSample>     columnSamples;        // Ray -> The nearest line it drew
+            FrameList<ColumnSample>  spanSamples;          // Lines drawn by all rays, ray after ray from the nearest line
+            vector<int>              spanOffsets;          // Ray -> Index of its first line in `spanSamples`
+            FrameArena               sampleArena;          // Memory of the lines, it is reset when the next frame is drawn
+
+            FrameArena               frameArena; // Working memory of the current frame
+            FrameGovernor            governor;
+            FramePacer               pacer;
+
+            RenderMode               renderMode;
+            Framebuffer              framebuffer;  // Frame drawn by the software mode, it covers the render area
+            SDL_Texture*             frameTexture; // Streaming texture the framebuffer is uploaded to
+            PostProcessor            postProcessor;
+            Colormap                 colormap;     // Shades and fogs texels of indexed textures in the software mode
+
+            CostOverlay              overlay;
+            SDL_Texture*             heatTexture;    // Streaming texture of the heatmap, one pixel per ray
+            SDL_Texture*             minimapTexture; // Streaming texture of the minimap, one pixel per block of tiles
+
+            enum {
+                KF_DIRTY      = 1 << 0, // Key is in the dirty list
+                KF_UP_PENDING = 1 << 1  // Key was released in the same frame it got pressed
+            };
+
+            enum {
+                CK_TEXTURED      = 1 << 0,
+                CK_LIT           = 1 << 1,
+                CK_EXCLUDED      = 1 << 2, // Column has some exclusions already
+                CK_SINGLE_COLUMN = 1 << 3, // One column per ray
+                CK_SOFTWARE      = 1 << 4  // Pixels are written into the framebuffer
+            };
+
+            /**
+             * Everything column kernels need to know in order to draw a wall in a pixel column.
+             */
+            struct ColumnSpan {
+                int             column;
+                int             width;       // Columns per ray
+                int             drawStart;   // Top of the wall line in screen coordinates
+                int             drawEnd;     // Bottom of the wall line in screen coordinates
+                SDL_Color       color;       // Color of solid-color walls
+                SDL_Texture*    texture;
+                int             texWidth;
+                int             texHeight;
+                float           texX;        // Normalized horizontal texture coordinate
+                float           texelHeight; // Texture pixel height in screen pixels
+                const uint32_t* texels;      // Texture pixels read by the software mode
+                const uint8_t*  indices;     // Palette indices of indexed texture pixels read by the software mode
+                const uint32_t* colors;      // Colormap row the indices are turned into final colors with
+                int             texPitch;    // Texture pixels (or indices) per row
+                uint8_t         shade;       // Opacity of black drawn over lit walls
+            };
+            typedef void (Engine::*ColumnKernel)(const ColumnSpan&, const FrameList<pair<int, int>>&);
+
+            /**
+             * Camera state the current frame is drawn from.
+             */
+            struct FrameView {
+                Vector2         position;
+                Vector2         direction;
+                Vector2         plane;
+                float           pcmDist;       // Perspective-correct minimum distance
+                int             columnsPerRay;
+                int             rowsInterval;
+                int             kernel;        // Column kernel features which stay the same for the whole frame
+                const Colormap* colormap;      // Lookup tables of indexed textures, null pointer when they are not used
+            };
+            FrameView frameView;
+
+            /**
+             * Translucent wall line of the current pixel column, it is drawn once the column is done so the farther walls
+             * are there to be blended with.
+             */
+            struct TranslucentLayer {
+                ColumnSpan span;
+                int        kernel; // Column kernel the line is drawn with
+            };
+            FrameList<TranslucentLayer>  translucentLayers; // Translucent lines of the current column, from the nearest one
+            FrameList<pair<int, int>>*   layerExclusions;   // Layer -> Draw exclusions of the column when its line was found
+            float*                       transmittance;     // Render area row -> How much of the farther walls is seen
+
+            /**
+             * Wall found in the view frustum by the object-order backend, with range of rays it may be hit by.
+             */
+            struct WallCandidate {
+                const WallData* wall;
+                int             wallIndex;
+                int             tileId;
+                Vector2         tile;
+                int             firstRay;
+                int             lastRay;
+            };
+
+            /**
+             * Wall hit by a ray of the object-order backend.
+             */
+            struct WallFragment {
+                float           perpDist;
+                float           u;
+                float                order;     // Distance of the tile center along the ray, sorts walls of touching tiles
+                const WallCandidate* candidate;
+            };
+
+            static const int TRANSLUCENT_LAYERS; // Translucent lines a pixel column can have, the farther ones are cut off
+
+            // Column kernels indexed by combination of `CK_<name>` flags, each of them is specialized for these features
+            static const ColumnKernel COLUMN_KERNELS[32];
+
+            // Draws wall line `span` except the parts covered by draw exclusions `drawExcls`
+            template<bool Textured, bool Lit, bool Excluded, bool SingleColumn, bool Software>
+            void drawColumn(const ColumnSpan& span, const FrameList<pair<int, int>>& drawExcls);
+            // Draws part of wall line `span` which starts at `lineStart` and ends at `lineEnd` screen rows
+            template<bool Textured, bool Lit, bool SingleColumn, bool Software>
+            void drawSpan(const ColumnSpan& span, int lineStart, int lineEnd);
+            // Keeps translucent line `span` to be drawn with kernel `kernel` once the column is done, `surface` holds pixels
+            // of its texture (if it has one); rows where walls behind it become hidden are added to draw exclusions
+            // `drawExcls`. Returns false when the column can not have more translucent lines.
+            bool deferLine(const ColumnSpan& span, int kernel, const SDL_Surface* surface, FrameList<pair<int, int>>& drawExcls);
+            // Draws translucent lines of the current column from the farthest one, then forgets them
+            void drawTranslucentLines();
+            // Adds range of screen rows from `start` to `end` to draw exclusions `drawExcls`, merging it with the ones it
+            // touches so they stay separated and sorted
+            void exclude(FrameList<pair<int, int>>& drawExcls, int start, int end);
+            // Tells whether draw exclusions `drawExcls` cover the whole pixel column of the render area
+            bool isColumnOccluded(const FrameList<pair<int, int>>& drawExcls) const;
+            // Draws all pixel columns by projecting walls found in the view frustum and sorting them per column, `rayDirsX`
+            // and `rayDirsY` are directions of `rayCount` rays
+            void drawObjectOrder(const float* rayDirsX, const float* rayDirsY, int rayCount,
+                                 FrameList<pair<int, int>>& drawExcls, bool usePvs);
+            // Returns how much work drawing walls of the current frame of `rayCount` rays with backend `backend` is
+            // expected to take, in units whose time is measured per backend; it is made of the scene densities and the view
+            float estimateWallWork(RenderBackend backend, int rayCount) const;
+            // Samples tiles of scene `scene` to find its densities (see `fStopDensity` and `fWallDensity`)
+            void sampleDensities(const Scene* scene);
+            // Draws solid-color wall `wall` of the tile at `tile` over screen columns from `xStart` to `xEnd` at once,
+            // `span` tells its color and shade
+            void drawRun(const ColumnSpan& span, const WallData& wall, const Vector2& tile, int xStart, int xEnd);
+            // Draws wall `wall` hit by ray of direction `rayDir` at perpendicular distance `perpDist` and position `u` along
+            // the wall into pixel column `column`, except the parts covered by `drawExcls` which then cover the drawn line too;
+            // the drawn line is described in `span`. Translucent lines are deferred (see `deferLine`) and cover only rows they
+            // made opaque enough. Returns whether the column is fully covered, so farther walls can not be seen.
+            bool drawWallLine(const WallData& wall, const Vector2& rayDir, int column, float perpDist, float u,
+                              FrameList<pair<int, int>>& drawExcls, ColumnSpan& span);
+            // Writes top and bottom screen rows of the line of wall `wall` seen at perpendicular distance `perpDist` to
+            // `drawStart` and `drawEnd`
+            void getLineRange(const WallData& wall, float perpDist, int& drawStart, int& drawEnd) const;
+            // Returns ray of the last drawn frame which drew screen column `x`, or -1 when none did
+            int  getSampleRay(int x) const;
+            // Keeps line of wall `wall` (of index `wallIndex`) of the tile at `tile` with ID `tileId` drawn by ray `ray` of
+            // direction `rayDir`, at perpendicular distance `perpDist` and position `u` along the wall; lines of a ray must
+            // be kept from the nearest one
+            void keepSample(int ray, const Vector2& rayDir, const Vector2& tile, int tileId, const WallData& wall, int wallIndex,
+                            float perpDist, float u);
+            // Forgets lines kept for ray `ray`, rays must be started in order
+            void startSamples(int ray);
+            #ifdef DEBUG
+            // Draws ends of draw exclusions `drawExcls` of pixel column `column`
+            void drawExclusions(int column, const FrameList<pair<int, int>>& drawExcls);
+            #endif
+            // Draws the enabled parts of the cost overlay for the last frame of `rayCount` rays over the screen
+            void drawOverlay(int rayCount);
+            // Sets heatmap cost of ray `ray` which made `steps` ray steps, tested `wallTests` walls and drew `lines` lines,
+            // and whose column was started at `start`
+            void keepColumnCost(int ray, int steps, int wallTests, int lines, const time_point<steady_clock>& start);
+            // Writes depths of the lines drawn in the last frame into the framebuffer, they are taken from the kept samples
+            void fillDepths();
+            // Makes streaming texture `texture` (ARGB8888) be `width` x `height` pixels, it is created again when its size
+            // differs; returns false if it fails
+            bool fitTexture(SDL_Texture*& texture, int width, int height);
+            // Tells whether some wall other than wall `wall` of the tile at `tile` crosses triangle `wedge`
+            bool isWedgeBlocked(const Vector2& tile, int wall, const Vector2 wedge[3]) const;
+            // Calls `visit` with coordinates of every tile triangle `tri` covers, row after row, until it returns true;
+            // returns whether it did
+            template<typename Visit>
+            static bool visitTiles(const Vector2 tri[3], Visit visit);
+            // Marks key of scancode `sc` to have its state completed in the next frame
+            void markKeyDirty(int sc);
+            // Updates key states using input event `event`
+            void processInput(const InputEvent& event);
+            // SDL event watch which timestamps input events and puts them into the input queue of engine `userdata`
+            static int watchEvent(void* userdata, SDL_Event* event);
 
             const Camera* mainCamera;
             DDA*          walker;
             SDL_Renderer* sdlRend;
             SDL_Window*   sdlWindow;
+            SDL_Surface*  sdlSurface; // Screen of the headless engine, null pointer when it has a window
 
         public:
             static const float SAFE_LINE_HEIGHT;
@@ -68,24 +329,96 @@ namespace rpge {
             };
 
             Engine(int screenWidth, int screenHeight);
+            /* The `headless` flag makes the engine draw into a surface through the SDL software renderer instead of a
+               window, so it runs without a display (see `readFrame` method) */
+            Engine(int screenWidth, int screenHeight, bool headless);
             ~Engine();
 
             /* Sets all render area pixels' color to the one set before using `setClearColor` method */
             void                   clear();
 
+            /* Returns columns per ray used by the renderer, it differs from the value set using `setColumnsPerRay`
+               method when the resolution governor lowered the resolution. */
+            int                    getColumnsPerRay() const;
+
+            /* Returns the nearest wall line drawn in screen column `x` of the last drawn frame, it does not hit anything
+               when no wall was drawn there (or the column is outside of the render area). */
+            ColumnSample           getColumnSample(int x) const;
+
+            /* Returns `i`-th of the wall lines drawn in screen column `x` of the last drawn frame, they are ordered from
+               the nearest one; lines seen past partial or translucent walls are there too. */
+            ColumnSample           getColumnSpan(int x, int i) const;
+
+            /* Returns amount of wall lines drawn in screen column `x` of the last drawn frame */
+            int                    getColumnSpanCount(int x) const;
+
             /* Returns an overall error code that in binary form represents whether some error occurred (1) or not (0),
                see `E_<error_name>` constants for more details about individual errors. */ 
             int                    getError() const;
 
+            /* Returns amount of pixel columns of the last frame which were filled as parts of wall runs instead of
+               having their own rays cast, see `setSpanCoherence` method */
+            int                    getCoherentColumns() const;
+
             /* Returns time in seconds telling how long processing of the last frame has taken */
             float                  getElapsedTime() const;
 
+            /* Returns amount of heap allocations made during the last `tick` call, it is always 0 when the library is
+               built without allocation tracking (see `isAllocationTracked` function). Allocations made by SDL itself
+               are not counted. */
+            uint64_t               getFrameAllocations() const;
+
+            /* Returns pointer to the framebuffer the software render mode draws into, it covers the render area. It is
+               valid only while that mode is used (see `setRenderMode` method). */
+            Framebuffer*           getFramebuffer();
+
+            /* Returns pointer to the arena providing working memory of the current frame, anything allocated from it
+               lives until the next `tick` call. */
+            FrameArena*            getFrameArena();
+
             /* Returns total amount of processed frames (or `tick` method calls) */
             int                    getFrameCount() const;
             
-            /* Returns state of a keyboard key having scancode `sc` (see `KeyState` for more details) */
+            /* Returns average (exponential moving average) of the input latency, see `getInputLatency` method */
+            float                  getAverageInputLatency() const;
+
+            /* Returns `i`-th of the input events processed during the last frame, they are ordered from the oldest.
+               Use their timestamps to react to input at finer granularity than the frame rate. */
+            const InputEvent&      getInputEvent(int i) const;
+
+            /* Returns amount of input events processed during the last frame */
+            int                    getInputEventCount() const;
+
+            /* Returns time in seconds between the oldest input event of the last frame having any and the moment that
+               frame was presented. Pipelined frames (see `setSimulation` method) count it from the oldest event handled
+               by the tick they draw. */
+            float                  getInputLatency() const;
+
+            /* Returns state of a keyboard key having scancode `sc` (see `KeyState` for more details). Key pressed and
+               released within one frame is still reported as DOWN in that frame and UP in the next one. */
             KeyState               getKeyState(int sc) const;
 
+            /* Returns pointer to the resolution governor, use it to tune how it reacts (see `FrameGovernor` class) */
+            FrameGovernor*         getGovernor();
+
+            /* Returns pointer to the cost overlay, enable its heatmap or minimap to see which columns and tiles make the
+               frames expensive; they are drawn over the frames in any build (see `CostOverlay` class). A part of the
+               overlay SDL fails to draw gets disabled, the engine keeps running. */
+            CostOverlay*           getOverlay();
+
+            /* Returns opacity at which translucent walls hide walls behind them, see `setOpacityThreshold` method */
+            float                  getOpacityThreshold() const;
+
+            /* Returns pointer to the post processor, use it to configure passes run over frames of the software render
+               mode or to read how long they take (see `PostProcessor` class) */
+            PostProcessor*         getPostProcessor();
+
+            /* Returns backend which drew the last frame, it is never RB_AUTO */
+            RenderBackend          getRenderBackend() const;
+
+            /* Returns where wall pixels are drawn, see `setRenderMode` method */
+            RenderMode             getRenderMode() const;
+
             /* Returns mouse position in the screen coordinates */
             Vector2                getMousePosition() const;
 
@@ -93,6 +426,21 @@ namespace rpge {
                set using `setRenderFitMode` method. */
             SDL_Rect               getRenderArea() const;
 
+            /* Returns rows interval used by the renderer, the value set using `setRowsInterval` method */
+            int                    getRowsInterval() const;
+
+            /* Returns time in seconds between the moment the snapshot drawn by the last frame was published by the
+               simulation and the moment that frame was presented, 0 when frames are not pipelined (see `setSimulation`
+               method) */
+            float                  getSnapshotLatency() const;
+
+            /* Returns average (exponential moving average) of the snapshot latency, see `getSnapshotLatency` method */
+            float                  getAverageSnapshotLatency() const;
+
+            /* Returns pointer to the frame pacer, use it to tune waiting or read the achieved frame-time jitter
+               (see `FramePacer` class) */
+            FramePacer*            getPacer();
+
             /* Returns pointer to the SDL renderer structure */
             SDL_Renderer*          getRendererHandle();
 
@@ -109,6 +457,19 @@ namespace rpge {
             /* Returns pointer to the SDL window structure, you can use it to do things not supported by the engine */
             SDL_Window*            getWindowHandle();
 
+            /* Returns whether the engine draws into a surface instead of a window */
+            bool                   isHeadless() const;
+
+            /* Returns the wall seen at screen position `screenPos` (e.g. `getMousePosition()`) in the last drawn frame. It
+               is looked up in the lines kept by the renderer, so it costs about the same no matter how far the wall is;
+               it does not hit anything when no wall was drawn there. */
+            ColumnSample           pick(const Vector2& screenPos) const;
+
+            /* Copies pixels of the screen (ARGB8888, `getScreenWidth()` x `getScreenHeight()` of them, rows going down)
+               to `pixels`, returns false if SDL fails to read them. Headless engines keep the last presented frame,
+               windows may not keep anything after presenting. */
+            bool                   readFrame(uint32_t* pixels) const;
+
             /* Allows for drawing process on the entire render area once per frame */
             void                   render();
             
@@ -128,18 +489,55 @@ namespace rpge {
             void                   setCursorVisibility(bool visible);
 
             /* Makes the next calls to `tick` method try to execute at constant `fps` frames per second either
-               by delaying (when execution is too fast) or maxing (when execution is too slow). */
+               by waiting for frame deadlines (when execution is too fast) or maxing (when execution is too slow). */
             void                   setFrameRate(int fps);
 
             /* Configures the global light source. The `enabled` flag tells whether it should be turned on/off
                and the `angle` value in radians, an angle which right vector ([1, 0]) should be rotated counter-
-               -clockwisely by; the source emmits light linearly in that direction. */
+               -clockwisely by; the source emmits light linearly in that direction. Walls are shaded only while the
+               light is on, it is off by default. */
             void                   setLightBehavior(bool enabled, float angle);
 
+            /* Translucent walls (ones with translucent color or texture pixels) are blended over the walls behind them. Their
+               opacity is accumulated per row from the nearest one, and rows reaching `threshold` (0 - 1) hide the farther
+               walls, a ray stops walking once its whole column is hidden. Lower values save work, values below 1 may
+               leave out walls showing through a little. Default is 0.99. */
+            void                   setOpacityThreshold(float threshold);
+
+            /* The `enabled` flag turns on/off the resolution governor, which raises columns per ray when frames take
+               longer than the budget set using `setFrameRate` method, and brings it back when there is enough spare
+               time. Value set using `setColumnsPerRay` is the best resolution it can reach, rows interval is left as
+               set using `setRowsInterval`. */
+            void                   setResolutionGovernor(bool enabled);
+
             /* Updates the main camera pointer so it points the `camera` instance of class `Camera`. It is used
                in rendering process. */
             void                   setMainCamera(const Camera* camera);
 
+            /* Makes frames pipelined with simulation `simulation` (see `Simulation` class), or serial again if null
+               pointer is given. Pipelined frames hand input events over to the simulation and draw its latest snapshot
+               instead of the main camera and the target scene of the walker, with the camera moved between the two
+               latest ticks by the time passed since the last one. The walker views scene of the drawn snapshot, so it
+               can be queried between frames; it gets its previous target scene back when going back to serial frames. */
+            void                   setSimulation(Simulation* simulation);
+
+            /* Selects how frames are drawn (see `RenderBackend`), both backends draw the same image. With RB_AUTO
+               (the default) the engine measures how long each of them takes per unit of work in the current scene (each
+               draws one frame of it first) and uses the one whose estimate for the frame is lower: raycasting suits
+               dense scenes where rays stop early, object order suits big sparse scenes with few walls. */
+            void                   setRenderBackend(RenderBackend backend);
+
+            /* Selects where wall pixels are drawn (see `RenderMode`). RM_HARDWARE (the default) draws them with the SDL
+               renderer. RM_SOFTWARE draws them into the framebuffer on the CPU, which is uploaded to a streaming texture
+               once per frame; only this mode runs the post passes (see `getPostProcessor` method). */
+            void                   setRenderMode(RenderMode mode);
+
+            /* The `enabled` flag turns on/off drawing of wall runs: when a few columns ahead of a ray hit the same
+               wall in the same way and nothing stands in between, they are filled at once from the wall's screen
+               endpoints instead of casting a ray per column. Runs are only used with rows interval of 1, the hardware
+               render mode draws solid-color ones as geometry and the others column by column. */
+            void                   setSpanCoherence(bool enabled);
+
             /* Specifies which part of the screen should be cleared when calling `clear` method */
             void                   setClearArea(const SDL_Rect& rect);
 
@@ -147,7 +545,9 @@ namespace rpge {
              * This method resets clear area set previously using `setClearArea` method to the whole render area. */
             void                   setRenderArea(const SDL_Rect& rect);
 
-            /* Makes one column pixel provide data for next `n` of them, so there will be total of `columnHeight / n` pixels */
+            /* Makes one column pixel provide data for next `n` of them, so there will be total of `columnHeight / n` pixels.
+               The software mode samples textures and shades once per such block of rows, which is what saves work;
+               the hardware mode only aligns lines to the blocks, SDL draws every pixel anyway. */
             void                   setRowsInterval(int n);
 
             /* Function responsible for handling user input and drawing the render area. You should call it as often
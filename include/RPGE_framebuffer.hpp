@@ -0,0 +1,83 @@
+
+#ifndef _RPGE_FRAMEBUFFER_HPP
+#define _RPGE_FRAMEBUFFER_HPP
+
+#include <vector>
+#include "RPGE_globals.hpp"
+
+namespace rpge {
+    using ::std::vector;
+
+    /**
+     * Frame drawn on the CPU by the software render mode. Pixels are 32-bit ARGB values (the same as `enColor`
+     * makes) stored row after row, every pixel also has depth (perpendicular distance from the camera plane) of what
+     * it shows, so passes run over the finished frame can tell how far things are.
+     *
+     * Walls are drawn column by column, which makes every pixel write of a row-major buffer jump a whole row ahead.
+     * In the column-major layout they are drawn into a separate buffer whose columns are contiguous instead, and
+     * `resolve` method transposes it into the rows once the frame is finished. Whether the transpose pays off depends
+     * on the resolution and the cache sizes, so the row-major layout is the default and the column-major one has to
+     * be measured first (see the framebuffer benchmark).
+     */
+    class Framebuffer {
+        private:
+            bool             columnMajor;
+            int              width;
+            int              height;
+            vector<uint32_t> pixels;
+            vector<float>    depths;
+            vector<uint32_t> columnPixels; // Pixels stored column after column (column-major layout)
+            vector<float>    columnDepths; // Depths stored column after column (column-major layout)
+        public:
+            static const int TRANSPOSE_STRIP; // Amount of columns the transpose goes through at once
+
+            Framebuffer();
+
+            /* Sets color of pixels in rectangle at ( `x`, `y` ) of size `w` x `h` to `color`, the rectangle is cut to
+               the framebuffer bounds. It fills the buffer walls are drawn into. */
+            void            fill(int x, int y, int w, int h, uint32_t color);
+
+            /* Returns pointer to the top pixel of column `x` of the buffer walls are drawn into, pixels below it are
+               `getDrawStep()` values apart. */
+            uint32_t*       getDrawColumn(int x);
+
+            /* Returns pointer to the top depth of column `x` of the buffer walls are drawn into, depths below it are
+               `getDrawStep()` values apart. */
+            float*          getDrawDepthColumn(int x);
+
+            /* Returns distance between vertically neighbouring values of the buffer walls are drawn into, it is 1 in
+               the column-major layout and the width otherwise. */
+            int             getDrawStep() const;
+
+            /* Returns pointer to depths of row `y`, values are infinite where nothing is seen */
+            float*          getDepthRow(int y);
+            const float*    getDepthRow(int y) const;
+
+            /* Returns height of the framebuffer in pixels */
+            int             getHeight() const;
+
+            /* Returns pointer to pixels of row `y` */
+            uint32_t*       getRow(int y);
+            const uint32_t* getRow(int y) const;
+
+            /* Returns width of the framebuffer in pixels */
+            int             getWidth() const;
+
+            /* Returns whether walls are drawn into the column-major buffer */
+            bool            isColumnMajor() const;
+
+            /* Changes size of the framebuffer to `width` x `height` pixels, contents are kept only when the size stays
+               the same; memory is reallocated only when it grows. */
+            void            resize(int width, int height);
+
+            /* Makes the rows (see `getRow` and `getDepthRow` methods) hold what was drawn, in the column-major layout
+               it transposes the drawn pixels, and the depths too when `withDepths` flag is set. */
+            void            resolve(bool withDepths);
+
+            /* The `enabled` flag selects the column-major (true) or row-major (false, the default) layout of the
+               buffer walls are drawn into */
+            void            setColumnMajor(bool enabled);
+    };
+}
+
+#endif
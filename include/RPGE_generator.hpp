@@ -0,0 +1,88 @@
+
+#ifndef _RPGE_GENERATOR_HPP
+#define _RPGE_GENERATOR_HPP
+
+#include <ostream>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "RPGE_globals.hpp"
+#include "RPGE_scene.hpp"
+
+namespace rpge {
+    using ::std::ostream;
+    using ::std::vector;
+
+    /**
+     * Parameters of a generated scene, the defaults make a 256 x 256 scene of single-wall tiles covering a fifth of
+     * it. The same settings (seed included) always make the same scene, on every platform.
+     */
+    struct GeneratorSettings {
+        int      width;             // Size of the scene in tiles
+        int      height;
+        uint32_t seed;
+        float    wallDensity;       // Part of the tiles which have walls, from 0 to 1
+        int      wallsPerTile;      // Walls of every tile kind
+        int      tileKinds;         // Amount of distinct tile IDs with walls
+        float    transparentRatio;  // Part of the walls which are translucent and let rays through, from 0 to 1
+        float    solidRatio;        // Part of the tiles with walls which are solid boxes like the border, from 0 to 1
+        int      textureCount;      // Textures the walls are spread over, solid colors are used when it is 0
+        string   texturePrefix;     // Texture `i` is file `texturePrefix` + i + ".bmp"
+        int      sightlineSpacing;  // Every `sightlineSpacing`-th row and column is kept empty, 0 keeps none
+        bool     bordered;          // Whether the scene is enclosed by solid tiles, so rays can not leave it
+
+        GeneratorSettings();
+    };
+
+    /**
+     * Makes scenes for scaling and stress tests from `GeneratorSettings`. Every tile is decided only by the seed and
+     * its position, so scenes of any size are written row by row without keeping them in memory.
+     *
+     * Tile kinds get their walls from a few shapes: full tile sides, diagonals and random segments inside the tile,
+     * with endpoints on a 1/16 grid so they survive the RPS text exactly. Solid walls stop rays, translucent ones (see
+     * `transparentRatio`) do not, which makes rays walk farther.
+     */
+    class SceneGenerator {
+        private:
+            GeneratorSettings settings;
+
+            // Returns random number made of the seed and values `a`, `b` and `c`
+            uint64_t hash(uint64_t a, uint64_t b, uint64_t c) const;
+        public:
+            static const int SOLID_KIND; // Tile ID of the border, a box made of solid tile sides
+
+            SceneGenerator(const GeneratorSettings& settings);
+
+            /* Sets up scene `scene` (of the generator size) with the generated tiles and walls, textures are loaded
+               from their files when there are any */
+            void                     fill(Scene& scene) const;
+
+            /* Returns settings the scenes are made with */
+            const GeneratorSettings& getSettings() const;
+
+            /* Returns name of the file of texture `index` (from 0) */
+            string                   getTextureFile(int index) const;
+
+            /* Returns ID of the tile at ( `x`, `y` ), 0 when it has no walls */
+            int                      getTileId(int x, int y) const;
+
+            /* Returns walls of tiles with ID `tileId`, which is `SOLID_KIND` or one of the kinds (from 2 to
+               `tileKinds` + 1). Their texture IDs are texture index + 1, or 0 for solid color. */
+            vector<WallData>         getTileWalls(int tileId) const;
+
+            /* Returns new surface (ARGB8888) of `size` x `size` pixels with texture `index` drawn in it, textures
+               differ by pattern and colors. Returns null pointer when SDL fails to make it. */
+            SDL_Surface*             makeTexture(int index, int size) const;
+
+            /* Writes the scene in RPS format to stream `stream` */
+            void                     writeRps(ostream& stream) const;
+
+            /* Writes the scene in RPS format to file `file`, returns false if it can not be written */
+            bool                     writeRps(const string& file) const;
+
+            /* Writes all textures (`size` x `size` pixels) to their files as BMP images, returns false if any can not
+               be written */
+            bool                     writeTextures(int size) const;
+    };
+}
+
+#endif
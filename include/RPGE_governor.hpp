@@ -0,0 +1,79 @@
+
+#ifndef _RPGE_GOVERNOR_HPP
+#define _RPGE_GOVERNOR_HPP
+
+#include "RPGE_globals.hpp"
+
+namespace rpge {
+
+    /**
+     * Keeps rendering cost within the frame budget by lowering or raising the horizontal render resolution, which is
+     * described by columns per ray known from the engine. Rows interval is not touched: in the hardware mode it saves
+     * no work at all, so the cost could not be predicted from it.
+     *
+     * Every frame feed it with the measured work time (time spent on a frame without any delaying) using
+     * `update` method. Resolution is lowered after work time stays above `upperRatio` of the budget for some
+     * frames, and raised after it stays below `lowerRatio` for much longer, but only when the predicted cost of
+     * the better resolution still fits the budget. After each change the governor waits a few frames, so the
+     * resolution does not oscillate.
+     *
+     * Every resolution level adds a column per ray to the base value (level 0) until the maximum is reached; cost of
+     * a level is taken as inversely proportional to its columns per ray, the amount of rays cast.
+     */
+    class FrameGovernor {
+        private:
+            bool  enabled;
+            int   level;            // Current resolution level, 0 is the best one
+            int   baseColumns;      // Columns per ray at level 0
+            int   maxColumns;
+            int   overFrames;       // Consecutive frames above the upper ratio
+            int   underFrames;      // Consecutive frames below the lower ratio
+            int   cooldown;         // Frames left until the next change is allowed
+            float averageTime;      // Exponential moving average of the work time
+            float upperRatio;
+            float lowerRatio;
+
+            // Returns amount of levels available for the current base and maximum values
+            int maxLevel() const;
+            // Returns columns per ray of resolution level `lvl`
+            int levelColumns(int lvl) const;
+        public:
+            static const int   DEGRADE_FRAMES; // Frames over budget needed to lower the resolution
+            static const int   IMPROVE_FRAMES; // Frames under budget needed to raise the resolution
+            static const int   COOLDOWN_FRAMES;
+            static const float AVERAGE_WEIGHT; // Weight of the newest sample in the moving average
+
+            FrameGovernor();
+
+            /* Returns columns per ray of the current resolution level */
+            int   getColumnsPerRay() const;
+
+            /* Returns the current resolution level, 0 means the base resolution */
+            int   getLevel() const;
+
+            /* Returns moving average of the work time in seconds */
+            float getAverageTime() const;
+
+            /* Returns whether the governor is allowed to change the resolution */
+            bool  isEnabled() const;
+
+            /* Resets the governor to level 0, which is described by columns per ray `columns` */
+            void  reset(int columns);
+
+            /* The `enabled` flag allows/disallows changing the resolution */
+            void  setEnabled(bool enabled);
+
+            /* Sets maximum columns per ray the governor can reach */
+            void  setLimits(int maxColumns);
+
+            /* Sets ratios of the budget above which the resolution is lowered (`upper`) and below which it may be
+               raised (`lower`), the gap between them is what keeps the resolution steady. */
+            void  setThresholds(float lower, float upper);
+
+            /* Feeds the work time `workTime` of the last frame and frame `budget` (both in seconds), returns whether
+               the resolution level has changed. */
+            bool  update(float workTime, float budget);
+    };
+}
+
+#endif
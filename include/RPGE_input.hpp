@@ -0,0 +1,84 @@
+
+#ifndef _RPGE_INPUT_HPP
+#define _RPGE_INPUT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "RPGE_globals.hpp"
+#include "RPGE_math.hpp"
+
+namespace rpge {
+    using ::std::atomic;
+    using ::std::chrono::steady_clock;
+    using ::std::chrono::time_point;
+    using ::std::vector;
+
+    enum InputEventType {
+        IE_KEY_DOWN,
+        IE_KEY_UP,
+        IE_MOUSE_DOWN,
+        IE_MOUSE_UP,
+        IE_MOUSE_MOTION
+    };
+
+    /**
+     * Single input event with the moment it happened at.
+     */
+    struct InputEvent {
+        int                      type;     // One of `InputEventType` values
+        int                      code;     // SDL scancode for key events, SDL mouse button for mouse button events
+        Vector2                  position; // Mouse position in the screen coordinates (mouse events)
+        Vector2                  motion;   // Mouse position change since the previous motion event (motion events)
+        time_point<steady_clock> time;
+
+        InputEvent();
+        InputEvent(int type, int code, time_point<steady_clock> time);
+    };
+
+    /**
+     * Lock-free queue of input events for exactly one producing and one consuming thread. Its ring has fixed capacity,
+     * but no event is ever lost: mouse motion may take only `MOTION_CAPACITY` slots of it, so key and button
+     * transitions always find room, and events which do not fit wait on the producer side until `flush` moves them
+     * in. Motion events waiting there one after another are merged into one, with their motion summed up.
+     */
+    class InputQueue {
+        private:
+            atomic<uint32_t>   head;    // Index the next event is written at (producer)
+            atomic<uint32_t>   tail;    // Index the next event is read from (consumer)
+            uint32_t           merged;  // Motion events merged into the previous ones (producer)
+            vector<InputEvent> events;
+            vector<InputEvent> waiting; // Events with no room in the ring yet, in order (producer)
+
+            // Puts `event` into the ring when it has room for it, `beforeTransition` flag lets motion take the slots
+            // kept for transitions. Returns whether it did (producer).
+            bool write(const InputEvent& event, bool beforeTransition);
+        public:
+            static const int CAPACITY;        // Power of two
+            static const int MOTION_CAPACITY; // Slots of the ring motion events may take
+
+            InputQueue();
+
+            /* Moves events waiting for room into the ring, as many as it fits; the producer calls it every now and then
+               so the consumer gets them even when no new events come (producer) */
+            void     flush();
+
+            /* Returns amount of motion events merged into the previous ones because the ring had no room for them
+               (producer) */
+            uint32_t getMergedCount() const;
+
+            /* Returns amount of events waiting in the ring */
+            int      getSize() const;
+
+            /* Returns amount of events waiting for room in the ring (producer) */
+            int      getWaitingCount() const;
+
+            /* Takes the oldest event from the ring and writes it to `event`, returns false if there was none (consumer) */
+            bool     pop(InputEvent& event);
+
+            /* Puts `event` at the end of the queue, it waits for room when the ring has none (producer) */
+            void     push(const InputEvent& event);
+    };
+}
+
+#endif
@@ -1,17 +1,21 @@
 
 #ifndef _RPGE_MATH_HPP
-#define _RPGE_MATH_HPP 
+#define _RPGE_MATH_HPP
 
 #include <cmath>
 #include <vector>
 #include "RPGE_globals.hpp"
 
+/**
+ * Math layer is header-only, so that every vector operation can be inlined into loops using it.
+ */
+
 namespace rpge {
     using ::std::abs;
     using ::std::sqrt;
 
-    extern const float SQRT2;
-    extern const float INV_SQRT2;
+    inline constexpr float SQRT2     = 1.41421356f;
+    inline constexpr float INV_SQRT2 = 0.70710678f;
 
     class LinearFunc;
     class Vector2;
@@ -22,13 +26,20 @@ namespace rpge {
         float xMin, xMax; // Domain range
         float yMin, yMax; // Values range
 
-        LinearFunc();
-        LinearFunc(float slope, float height);
-        LinearFunc(float slope, float height, float xMin, float xMax);
-        LinearFunc(float slope, float height, float xMin, float xMax, float yMin, float yMax);
+        constexpr LinearFunc() : slope(0), height(0), xMin(0), xMax(1), yMin(0), yMax(1) {}
+        constexpr LinearFunc(float slope, float height) : slope(slope), height(height), xMin(0), xMax(1), yMin(0), yMax(1) {}
+        constexpr LinearFunc(float slope, float height, float xMin, float xMax)
+            : slope(slope), height(height), xMin(xMin), xMax(xMax), yMin(0), yMax(1) {}
+        constexpr LinearFunc(float slope, float height, float xMin, float xMax, float yMin, float yMax)
+            : slope(slope), height(height), xMin(xMin), xMax(xMax), yMin(yMin), yMax(yMax) {}
     };
     #ifdef DEBUG
-    ostream& operator<<(ostream& stream, const LinearFunc& func);
+    inline ostream& operator<<(ostream& stream, const LinearFunc& func)
+    {
+        stream << "LinearFunc(slope=" << func.slope << ", height=" << func.height << ", xMin=" << func.xMin;
+        stream << ", xMax=" << func.xMax << ", yMin=" << func.yMin << ", yMax=" << func.yMax << ")";
+        return stream;
+    }
     #endif
 
     struct Vector2 {
@@ -37,31 +48,98 @@ namespace rpge {
         static const Vector2 RIGHT;
         static const Vector2 DOWN;
         static const Vector2 LEFT;
-        
+
         float x, y;
 
-        Vector2();
-        Vector2(float x, float y);
+        constexpr Vector2() : x(0), y(0) {}
+        constexpr Vector2(float x, float y) : x(x), y(y) {}
 
-        float   dot(const Vector2& other) const;
-        float   magnitude() const;
-        Vector2 normalized() const;
-        Vector2 orthogonal() const;  // Vector that is clockwisely-perpendicular
-        Vector2 rotate(float radians) const;  // Vector rotated anti-clockwisely
+        constexpr float dot(const Vector2& other) const
+        {
+            return x * other.x + y * other.y;
+        }
+        float magnitude() const
+        {
+            return sqrtf(x * x + y * y);
+        }
+        Vector2 normalized() const
+        {
+            float mag = magnitude();
+            return mag == 0 ? Vector2(0, 0) : Vector2(x / mag, y / mag);
+        }
+        // Vector that is clockwisely-perpendicular
+        constexpr Vector2 orthogonal() const
+        {
+            return Vector2(y, -1 * x);
+        }
+        // Vector rotated anti-clockwisely
+        Vector2 rotate(float radians) const
+        {
+            float sin = sinf(radians);
+            float cos = cosf(radians);
+            return Vector2(cos * x - sin * y, sin * x + cos * y);
+        }
     };
-    void operator+=(Vector2& a, const Vector2& b);
-    void operator-=(Vector2& a, const Vector2& b);
-    void operator*=(Vector2& vec, float scalar);
-    void operator/=(Vector2& vec, float scalar);
-    bool operator==(const Vector2& a, const Vector2& b);
-    bool operator!=(const Vector2& a, const Vector2& b);
-    Vector2 operator+(const Vector2& a, const Vector2& b);
-    Vector2 operator-(const Vector2& a, const Vector2& b);
-    Vector2 operator*(const Vector2& vec, float scalar);
-    Vector2 operator*(float scalar, const Vector2& vec);
-    Vector2 operator/(const Vector2& vec, float scalar);
+    inline constexpr Vector2 Vector2::ZERO  = Vector2(0, 0);
+    inline constexpr Vector2 Vector2::UP    = Vector2(0, 1);
+    inline constexpr Vector2 Vector2::RIGHT = Vector2(1, 0);
+    inline constexpr Vector2 Vector2::DOWN  = Vector2(0, -1);
+    inline constexpr Vector2 Vector2::LEFT  = Vector2(-1, 0);
+
+    constexpr void operator+=(Vector2& a, const Vector2& b)
+    {
+        a.x += b.x;
+        a.y += b.y;
+    }
+    constexpr void operator-=(Vector2& a, const Vector2& b)
+    {
+        a.x -= b.x;
+        a.y -= b.y;
+    }
+    constexpr void operator*=(Vector2& vec, float scalar)
+    {
+        vec.x *= scalar;
+        vec.y *= scalar;
+    }
+    constexpr void operator/=(Vector2& vec, float scalar)
+    {
+        vec.x /= scalar;
+        vec.y /= scalar;
+    }
+    constexpr bool operator==(const Vector2& a, const Vector2& b)
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+    constexpr bool operator!=(const Vector2& a, const Vector2& b)
+    {
+        return a.x != b.x || a.y != b.y;
+    }
+    constexpr Vector2 operator+(const Vector2& a, const Vector2& b)
+    {
+        return Vector2(a.x + b.x, a.y + b.y);
+    }
+    constexpr Vector2 operator-(const Vector2& a, const Vector2& b)
+    {
+        return Vector2(a.x - b.x, a.y - b.y);
+    }
+    constexpr Vector2 operator*(const Vector2& vec, float scalar)
+    {
+        return Vector2(vec.x * scalar, vec.y * scalar);
+    }
+    constexpr Vector2 operator*(float scalar, const Vector2& vec)
+    {
+        return vec * scalar;
+    }
+    constexpr Vector2 operator/(const Vector2& vec, float scalar)
+    {
+        return Vector2(vec.x / scalar, vec.y / scalar);
+    }
     #ifdef DEBUG
-    ostream& operator<<(ostream& stream, const Vector2& vec);
+    inline ostream& operator<<(ostream& stream, const Vector2& vec)
+    {
+        stream << "Vector2(x=" << vec.x << ", y=" << vec.y << ")";
+        return stream;
+    }
     #endif
 }
 
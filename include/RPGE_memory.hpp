@@ -0,0 +1,150 @@
+
+#ifndef _RPGE_MEMORY_HPP
+#define _RPGE_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "RPGE_globals.hpp"
+
+namespace rpge {
+    using ::std::size_t;
+    using ::std::vector;
+
+    /* Returns amount of heap allocations made by the whole program so far. Counting works only when the library
+     * is built with `RPGE_TRACK_ALLOCATIONS` defined (see `isAllocationTracked`), otherwise 0 is returned. */
+    uint64_t getAllocationCount();
+
+    /* Returns whether global allocations are counted by the library */
+    bool     isAllocationTracked();
+
+    /**
+     * Linear allocator for memory living no longer than a frame. Allocating is just moving an offset inside
+     * big blocks, and `reset` makes all of the memory available again without freeing it, so once the arena
+     * has grown to the size a frame needs, frames do not touch the heap at all.
+     *
+     * Temporary allocations nested inside a frame can be given back early using `mark` and `rewind` methods.
+     * Arena does not call constructors or destructors, so it is meant for trivial types only.
+     */
+    class FrameArena {
+        private:
+            struct Block {
+                uint8_t* memory; // Memory returned by new[]
+                uint8_t* data;   // The first address of `memory` aligned to `BLOCK_ALIGNMENT` bytes
+                size_t   size;   // Bytes usable from `data` on
+            };
+            int           blockIndex;  // Block the allocations are currently made from
+            size_t        offset;      // Offset of the first free byte in the current block
+            size_t        used;        // Bytes used since the last reset, including the alignment padding
+            size_t        peak;        // The greatest amount of bytes used during a frame
+            size_t        blockSize;   // Minimal size of a newly allocated block
+            vector<Block> blocks;
+
+            // Appends block of at least `size` usable bytes
+            void addBlock(size_t size);
+            // Frees all of the blocks
+            void release();
+        public:
+            static const size_t BLOCK_ALIGNMENT; // Alignment of block addresses, allocations aligned to it or less
+                                                 // need the same padding in any block
+
+            /**
+             * Position in the arena returned by `mark` method.
+             */
+            struct Marker {
+                int    blockIndex;
+                size_t offset;
+                size_t used;
+            };
+
+            FrameArena();
+            FrameArena(size_t blockSize);
+            FrameArena(const FrameArena&) = delete;
+            FrameArena& operator=(const FrameArena&) = delete;
+            ~FrameArena();
+
+            /* Returns `bytes` bytes of memory aligned to `alignment` bytes (power of two) */
+            void*  allocate(size_t bytes, size_t alignment);
+
+            /* Returns uninitialized array of `count` elements of trivial type `T` */
+            template<typename T>
+            T*     allocate(int count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "Arena does not call destructors");
+                return static_cast<T*>(allocate(sizeof(T) * (count < 0 ? 0 : count), alignof(T)));
+            }
+
+            /* Returns total amount of bytes owned by the arena */
+            size_t getCapacity() const;
+
+            /* Returns the greatest amount of bytes used between two resets */
+            size_t getPeakUsage() const;
+
+            /* Returns amount of bytes used since the last reset */
+            size_t getUsage() const;
+
+            /* Returns the current position, allocations made after it can be given back using `rewind` method */
+            Marker mark() const;
+
+            /* Makes every allocation made since the reset available again. When the previous frame needed more than
+               one block, they are replaced with a single one big enough for all of them. */
+            void   reset();
+
+            /* Gives back every allocation made after `marker` was taken */
+            void   rewind(const Marker& marker);
+    };
+
+    /**
+     * Array of at most `capacity` elements of trivial type `T` placed in a `FrameArena`, offering the part of
+     * vector interface needed by per-frame bookkeeping. It never reallocates, pushing past the capacity is
+     * ignored, so the capacity should be an upper bound of the element count.
+     */
+    template<typename T>
+    class FrameList {
+        private:
+            T*  items;
+            int count;
+            int capacity;
+        public:
+            FrameList() : items(nullptr), count(0), capacity(0) {}
+            FrameList(FrameArena& arena, int capacity) : items(arena.allocate<T>(capacity)), count(0), capacity(capacity) {}
+
+            T&       at(int i)       { return items[i]; }
+            const T& at(int i) const { return items[i]; }
+            T*       begin()         { return items; }
+            T*       end()           { return items + count; }
+            const T* begin() const   { return items; }
+            const T* end() const     { return items + count; }
+            void     clear()         { count = 0; }
+            int      getCapacity() const { return capacity; }
+            int      size() const    { return count; }
+
+            /* Removes element at index `i`, keeping order of the others */
+            void erase(int i)
+            {
+                for(int j = i + 1; j < count; j++)
+                    items[j - 1] = items[j];
+                count--;
+            }
+
+            /* Inserts `item` at index `i`, keeping order of the others */
+            void insert(int i, const T& item)
+            {
+                if(count == capacity)
+                    return;
+                for(int j = count; j > i; j--)
+                    items[j] = items[j - 1];
+                items[i] = item;
+                count++;
+            }
+
+            void push_back(const T& item)
+            {
+                if(count != capacity)
+                    items[count++] = item;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,137 @@
+
+#ifndef _RPGE_OVERLAY_HPP
+#define _RPGE_OVERLAY_HPP
+
+#include <vector>
+#include <SDL2/SDL.h>
+#include "RPGE_globals.hpp"
+#include "RPGE_scene.hpp"
+
+namespace rpge {
+    using ::std::vector;
+
+    enum CostMetric {
+        CM_RAY_STEPS,  // Tiles a ray walked through, the object-order backend does not walk rays so its columns have none
+        CM_WALL_TESTS, // Walls tested for intersection with a ray
+        CM_LINES,      // Wall lines drawn (or deferred, when translucent) in a column
+        CM_TIME,       // Nanoseconds spent on a column
+        CM_COUNT
+    };
+
+    /**
+     * Render-cost diagnostics shown over frames, available in every build. The heatmap colors every pixel column by
+     * cost of the ray which drew it (see `CostMetric`), from blue (cheap) through green and yellow to red (costly).
+     * The minimap shows the scene from the top with tiles colored by how many wall lines they make per frame, tiles
+     * nobody sees stay gray, so the ones to simplify stand out. Its sides have at most `MINIMAP_SIZE` pixels, a pixel
+     * of a bigger scene shows the hottest of the tiles it covers.
+     *
+     * The engine records costs only while the overlay is enabled, see `Engine::getOverlay` method.
+     */
+    class CostOverlay {
+        private:
+            bool             heatmapEnabled;
+            bool             minimapEnabled;
+            CostMetric       metric;
+            float            opacity;      // Opacity of the heatmap colors, from 0 to 1
+            float            costScale;    // Cost drawn with red, 0 when it is the average frame maximum
+            float            maxCost;      // Moving average of the highest ray cost of a frame, -1 when unknown
+            SDL_Rect         minimapArea;  // Part of the screen the minimap is drawn over
+            int              sceneWidth;   // Size of the scene the tile heat belongs to
+            int              sceneHeight;
+            vector<float>    rayCosts;     // Ray -> Cost of the last frame
+            vector<uint16_t> tileHits;     // Tile index -> Lines made by the tile in the current frame
+            vector<float>    tileHeat;     // Tile index -> Moving average of lines made by the tile per frame
+            float            maxHeat;      // The highest tile heat
+            int              minimapWidth; // Size of the minimap in pixels
+            int              minimapHeight;
+            vector<int>      minimapColumns; // Tile x -> Minimap column showing it
+            vector<int>      minimapRows;    // Tile y -> Minimap row showing it, rows go from the top of the scene down
+            vector<float>    minimapHeat;    // Minimap pixel -> The highest heat of the tiles it shows
+            vector<uint8_t>  minimapWalls;   // Minimap pixel -> Whether any of the tiles it shows has walls
+            uint64_t         gridRevision;   // Revisions of the tile grid and walls `minimapWalls` were found for
+            uint64_t         wallsRevision;
+        public:
+            static const float AVERAGE_WEIGHT; // Weight of the newest sample in the moving averages
+            static const int   MINIMAP_SIZE;   // The most pixels a side of the minimap has
+
+            CostOverlay();
+
+            /* Starts recording a frame of `rayCount` rays cast into a scene of `sceneWidth` x `sceneHeight` tiles, tile
+               heat starts over when the scene size changes */
+            void            beginFrame(int rayCount, int sceneWidth, int sceneHeight);
+
+            /* Finishes recording of the frame, moving averages are updated with it */
+            void            endFrame();
+
+            /* Records that the tile at ( `x`, `y` ) made a wall line in the current frame */
+            void            countTileHit(int x, int y);
+
+            /* Writes color of every ray's cost (ARGB8888) to `pixels`, which must fit `getRayCount()` of them */
+            void            fillHeatmap(uint32_t* pixels) const;
+
+            /* Writes color of every minimap pixel (ARGB8888) to `pixels`, which must fit `getMinimapSize` of them; rows
+               go from the top of the scene (the highest y) down. Pixels showing no walls are left translucent. */
+            void            fillMinimap(uint32_t* pixels) const;
+
+            /* Finds which minimap pixels show walls of scene `scene`, which has the size given to `beginFrame`. It is
+               done again only when the tiles or walls changed (see `Scene::getGridRevision`), so it can be called
+               every frame. */
+            void            findMinimapWalls(const Scene& scene);
+
+            /* Returns color (ARGB8888 with opacity `alpha`) of cost `t`, from 0 (blue) to 1 (red) */
+            static uint32_t getHeatColor(float t, uint8_t alpha);
+
+            /* Returns cost drawn with red, see `setCostScale` method */
+            float           getCostScale() const;
+
+            /* Returns minimap area set using `setMinimap` method */
+            SDL_Rect        getMinimapArea() const;
+
+            /* Writes size of the minimap in pixels to `width` and `height`, the scene size up to `MINIMAP_SIZE` */
+            void            getMinimapSize(int& width, int& height) const;
+
+            /* Returns metric the heatmap shows */
+            CostMetric      getMetric() const;
+
+            /* Returns opacity of the heatmap colors */
+            float           getOpacity() const;
+
+            /* Returns cost of ray `ray` in the last frame, in units of the metric */
+            float           getRayCost(int ray) const;
+
+            /* Returns amount of rays recorded in the last frame */
+            int             getRayCount() const;
+
+            /* Returns average amount of wall lines made by the tile at ( `x`, `y` ) per frame, it is kept only while the
+               minimap is enabled */
+            float           getTileHeat(int x, int y) const;
+
+            /* Writes position of the tile with the highest heat to `x` and `y`, returns false when no tile has any */
+            bool            getHottestTile(int& x, int& y) const;
+
+            /* Returns whether the heatmap is drawn */
+            bool            isHeatmapEnabled() const;
+
+            /* Returns whether the minimap is drawn */
+            bool            isMinimapEnabled() const;
+
+            /* Returns whether the engine has to record anything */
+            bool            isEnabled() const;
+
+            /* Sets ray `ray` of the current frame to cost `cost` */
+            void            setRayCost(int ray, float cost);
+
+            /* Sets cost which is drawn with red, costs above it are red too. Value of 0 (the default) makes it follow
+               the highest ray cost of recent frames. */
+            void            setCostScale(float scale);
+
+            /* The `enabled` flag shows/hides the heatmap, which shows metric `metric` with opacity `opacity` (0 - 1) */
+            void            setHeatmap(bool enabled, CostMetric metric, float opacity);
+
+            /* The `enabled` flag shows/hides the minimap drawn over screen area `area` (in pixels), the scene is
+               stretched to it */
+            void            setMinimap(bool enabled, const SDL_Rect& area);
+    };
+}
+
+#endif
@@ -0,0 +1,83 @@
+
+#ifndef _RPGE_PACER_HPP
+#define _RPGE_PACER_HPP
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "RPGE_globals.hpp"
+
+namespace rpge {
+    using ::std::chrono::duration;
+    using ::std::chrono::steady_clock;
+    using ::std::chrono::time_point;
+    using ::std::vector;
+
+    /**
+     * Paces frames to a constant rate using monotonic clock, so changes of the system time do not disturb it.
+     *
+     * Instead of delaying every frame by what is left of its own duration, pacer keeps a schedule of frame
+     * deadlines, each one period after the previous. Calling `wait` method sleeps until shortly before the next
+     * deadline and spins for the rest of it (the spin window), which gives precision far better than the sleep
+     * granularity of the system. A frame being late shortens waiting of the next ones so the average rate holds,
+     * but after a stall (for example when the window was frozen) longer than a few periods the schedule starts
+     * over from the current time instead of rushing frames to catch up.
+     *
+     * Intervals between consecutive `wait` returns are collected, their statistics describe achieved jitter.
+     */
+    class FramePacer {
+        private:
+            bool                      started;
+            int                       maxLagFrames;  // Lag (in periods) after which the schedule is reset
+            int                       stallCount;
+            int                       sampleIndex;   // Index in `samples` the next interval is written at
+            int                       sampleCount;
+            duration<double>          period;
+            duration<double>          spinWindow;
+            time_point<steady_clock>  deadline;      // Moment the next frame should start at
+            time_point<steady_clock>  lastFrame;     // Moment the last `wait` call returned
+            vector<float>             samples;       // Recent frame intervals in seconds
+
+        public:
+            static const int STATS_WINDOW; // Amount of the most recent intervals statistics are computed from
+
+            FramePacer();
+            FramePacer(int fps);
+
+            /* Returns mean of the recent frame intervals in seconds */
+            float getAverageInterval() const;
+
+            /* Returns standard deviation of the recent frame intervals in seconds */
+            float getJitter() const;
+
+            /* Returns the longest of the recent frame intervals in seconds */
+            float getMaxInterval() const;
+
+            /* Returns the shortest of the recent frame intervals in seconds */
+            float getMinInterval() const;
+
+            /* Returns how many times the schedule was reset because of a stall */
+            int   getStallCount() const;
+
+            /* Forgets the schedule and statistics, the next `wait` call returns immediately */
+            void  reset();
+
+            /* Sets the target frame rate to `fps` frames per second */
+            void  setFrameRate(int fps);
+
+            /* Sets how many periods a frame can be late before the schedule is reset */
+            void  setMaxLag(int frames);
+
+            /* Sets how long before a deadline the pacer stops sleeping and starts spinning, in seconds. Longer window
+               costs CPU time but protects against coarse sleep granularity. */
+            void  setSpinWindow(float seconds);
+
+            /* Blocks until the next frame deadline, returns time in seconds elapsed since the previous call returned */
+            float wait();
+            /* Works like `wait()`, the interval is left out of the statistics when `recorded` is false */
+            float wait(bool recorded);
+    };
+}
+
+#endif
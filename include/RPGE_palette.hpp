@@ -0,0 +1,102 @@
+
+#ifndef _RPGE_PALETTE_HPP
+#define _RPGE_PALETTE_HPP
+
+#include <vector>
+#include "RPGE_globals.hpp"
+
+namespace rpge {
+    using ::std::vector;
+
+    /**
+     * Shared set of up to 256 colors indexed textures refer to. Index 0 (`TRANSPARENT_INDEX`) is reserved for texels
+     * whose opacity is below `ALPHA_THRESHOLD`, every other texel gets index of the closest color, so indexed textures
+     * are either opaque or fully transparent. Closest colors are looked up in a table covering all colors with 5 bits
+     * per channel, it is built by the constructors, so a palette shared by threads is only ever read.
+     */
+    class Palette {
+        private:
+            uint32_t                colors[256]; // Index -> Opaque color (transparent black at index 0)
+            int                     count;
+            vector<uint8_t>         nearest;     // Color with 5 bits per channel -> Index of the closest color
+
+            // Returns table of the closest ones of `count` colors `colors`, the first of them being the transparent one
+            static vector<uint8_t> findNearest(const uint32_t* colors, int count);
+        public:
+            static const int TRANSPARENT_INDEX;
+            static const int ALPHA_THRESHOLD;   // Texels less opaque than this become transparent
+
+            /* Makes palette of evenly spread colors, 6 levels of red and blue and 7 levels of green */
+            Palette();
+            /* Makes palette of `count` colors `colors` (up to 255 of them, they take indices from 1 up), their opacity is
+               ignored */
+            Palette(const uint32_t* colors, int count);
+
+            /* Returns palette of up to `count` colors (not counting the transparent one) representing `pixelCount`
+               pixels `pixels` well, the color space is split by median cut. Transparent pixels are left out. */
+            static Palette  fromPixels(const uint32_t* pixels, int pixelCount, int count);
+
+            /* Returns color at index `index`, it is transparent black for `TRANSPARENT_INDEX` and unused indices */
+            uint32_t        getColor(int index) const;
+
+            /* Returns number of colors including the transparent one */
+            int             getColorCount() const;
+
+            /* Returns pointer to all 256 colors, indices above `getColorCount()` hold transparent black */
+            const uint32_t* getColors() const;
+
+            /* Returns index of the color closest to color `color` (ARGB8888), or `TRANSPARENT_INDEX` when it is not
+               opaque enough */
+            uint8_t         getIndex(uint32_t color) const;
+
+            /* Writes indices of the closest colors of `width` x `height` pixels `pixels` (ARGB8888) whose rows are
+               `pitch` pixels apart to `indices`, whose rows are `indexPitch` bytes apart */
+            void            quantize(const uint32_t* pixels, int width, int height, int pitch, uint8_t* indices,
+                                     int indexPitch) const;
+    };
+
+    /**
+     * Lookup tables turning palette indices straight into final colors, the way colormaps of old software renderers
+     * do. There is a row for every shade level (how much black covers a color, walls get darker by the light direction)
+     * and fog level (how much of the fog color covers it, by depth), so a wall column picks its row once and then
+     * every texel costs a single lookup.
+     */
+    class Colormap {
+        private:
+            uint32_t         colors[256]; // Palette colors the rows are made of
+            bool             fogged;
+            uint32_t         fogColor;
+            float            fogStart;
+            float            fogScale;    // Fog levels per unit of depth
+            vector<uint32_t> rows;        // Fog level -> Shade level -> Palette index -> Color
+
+            // Returns color `color` with `shade` (0 - 255) of black and `fog` (0 - 256) of fog color over it, the way
+            // the lit software kernels and the fog pass mix them
+            uint32_t mix(uint32_t color, int shade, int fog) const;
+        public:
+            static const int SHADE_LEVELS;
+            static const int FOG_LEVELS;
+
+            Colormap();
+
+            /* Returns color `color` (ARGB8888) shaded and fogged like the row of `shadeLevel` and `fogLevel` would do
+               it, its opacity is kept. It is meant for solid-color walls. */
+            uint32_t        apply(uint32_t color, int shadeLevel, int fogLevel) const;
+
+            /* Returns fog level of pixels at depth `depth`, it is 0 when there is no fog */
+            int             getFogLevel(float depth) const;
+
+            /* Returns row of 256 colors for shade level `shadeLevel` and fog level `fogLevel` */
+            const uint32_t* getRow(int shadeLevel, int fogLevel) const;
+
+            /* Returns shade level closest to opacity `shade` (0 - 255) of black drawn over a color */
+            static int      getShadeLevel(int shade);
+
+            /* Rebuilds the rows if palette `palette` or the fog settings differ from the ones they were built for. The
+               `fogged` flag tells whether there is fog of color `fogColor` (ARGB8888) going from depth `fogStart` to
+               `fogEnd`, rows of fog levels other than 0 are made only when there is. */
+            void            update(const Palette& palette, bool fogged, uint32_t fogColor, float fogStart, float fogEnd);
+    };
+}
+
+#endif
@@ -0,0 +1,34 @@
+
+#ifndef _RPGE_PIXEL_HPP
+#define _RPGE_PIXEL_HPP
+
+#include <cstdint>
+
+/**
+ * Pixel arithmetic of the software render mode, shared by the engine kernels, the reference renderer and the
+ * benchmarks so that all of them compute the very same colors. It is internal to the library, games have no use for
+ * it.
+ */
+
+namespace rpge {
+
+    /* Returns color `source` (ARGB8888) blended over pixel `pixel` with opacity `alpha`, the result is opaque */
+    inline uint32_t blendPixel(uint32_t pixel, uint32_t source, int alpha)
+    {
+        uint32_t result = 0xff000000;
+        for(int shift = 0; shift < 24; shift += 8)
+            result |= ((((source >> shift) & 255) * alpha + ((pixel >> shift) & 255) * (255 - alpha)) / 255) << shift;
+        return result;
+    }
+
+    /* Returns pixel `pixel` darkened the same way black drawn over it with opacity `shade` does, the result is opaque */
+    inline uint32_t shadePixel(uint32_t pixel, int shade)
+    {
+        uint32_t result = 0xff000000;
+        for(int shift = 0; shift < 24; shift += 8)
+            result |= (((pixel >> shift) & 255) * (255 - shade) / 255) << shift;
+        return result;
+    }
+}
+
+#endif
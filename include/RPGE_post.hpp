@@ -0,0 +1,105 @@
+
+#ifndef _RPGE_POST_HPP
+#define _RPGE_POST_HPP
+
+#include <chrono>
+#include <vector>
+#include "RPGE_framebuffer.hpp"
+#include "RPGE_globals.hpp"
+#include "RPGE_simd.hpp"
+#include "RPGE_threads.hpp"
+
+namespace rpge {
+    using ::std::chrono::duration;
+    using ::std::chrono::steady_clock;
+    using ::std::vector;
+
+    enum PostPass {
+        PP_FOG,      // Mixes pixels with the fog color by their depth
+        PP_LUT,      // Maps every color channel through its own table (color grading)
+        PP_GAMMA,    // Applies gamma curve to every color channel
+        PP_VIGNETTE, // Darkens pixels by their distance from the center
+        PP_COUNT
+    };
+
+    /**
+     * Runs passes over a finished framebuffer, in order of `PostPass` values. Every pass goes over rows of pixels
+     * with SIMD kernels where the work allows it (table lookups stay scalar), rows are split among threads of the
+     * worker pool when one is set using `setWorkerPool` method.
+     *
+     * Time of every pass is measured, use `getPassTime` method to keep effects within the frame budget.
+     */
+    class PostProcessor {
+        private:
+            bool          enabled[PP_COUNT];
+            float         passTimes[PP_COUNT]; // Moving averages of the pass times in seconds, -1 when never run
+            uint32_t      fogColor;
+            float         fogStart;            // Depth the fog starts at
+            float         fogEnd;              // Depth the fog hides everything at
+            uint8_t       lut[3][256];         // Channel (red, green, blue) -> Value -> Graded value
+            uint8_t       gammaLut[256];
+            float         gamma;
+            float         vignetteStrength;
+            vector<float> vignetteColumns;     // Column -> Squared distance from the center, normalized to < -1 ; 1 >
+            WorkerPool*   pool;
+
+            // Pass kernels, they process rows from `rowStart` to `rowEnd` of framebuffer `fb`
+            void applyFog(Framebuffer& fb, int rowStart, int rowEnd) const;
+            void applyGamma(Framebuffer& fb, int rowStart, int rowEnd) const;
+            void applyLut(Framebuffer& fb, int rowStart, int rowEnd) const;
+            void applyVignette(Framebuffer& fb, int rowStart, int rowEnd) const;
+            // Runs kernel `kernel` of pass `pass` over all rows of framebuffer `fb` and measures it
+            void runPass(int pass, Framebuffer& fb, void (PostProcessor::*kernel)(Framebuffer&, int, int) const);
+        public:
+            static const int   ROW_GRAIN;      // Amount of rows processed by a worker at once
+            static const float AVERAGE_WEIGHT; // Weight of the newest sample in the moving averages
+
+            PostProcessor();
+
+            /* Returns color of the fog (ARGB8888) */
+            uint32_t getFogColor() const;
+
+            /* Returns depth the fog hides everything at */
+            float    getFogEnd() const;
+
+            /* Returns depth the fog starts at */
+            float    getFogStart() const;
+
+            /* Returns average time in seconds pass `pass` (one of `PostPass` values) took per frame, or -1 if it has
+               not run yet */
+            float    getPassTime(int pass) const;
+
+            /* Returns sum of the average times of the enabled passes in seconds */
+            float    getTotalTime() const;
+
+            /* Returns whether any pass is enabled */
+            bool     isEnabled() const;
+
+            /* Returns whether pass `pass` (one of `PostPass` values) is enabled */
+            bool     isPassEnabled(int pass) const;
+
+            /* Runs the enabled passes over framebuffer `fb`, version with `skipped` argument leaves out passes whose
+               bits (`1 << pass`) are set in it, the ones already done while drawing */
+            void     process(Framebuffer& fb);
+            void     process(Framebuffer& fb, int skipped);
+
+            /* Configures color grading, the `enabled` flag turns it on/off and `red`, `green`, `blue` are tables of
+               256 values each telling what every channel value becomes (they are copied). */
+            void     setColorLut(bool enabled, const uint8_t* red, const uint8_t* green, const uint8_t* blue);
+
+            /* Configures distance fog, the `enabled` flag turns it on/off. Pixels are mixed with color ( `r`, `g`, `b` )
+               linearly from depth `start` where nothing changes to depth `end` and beyond where only fog is seen. */
+            void     setFog(bool enabled, uint8_t r, uint8_t g, uint8_t b, float start, float end);
+
+            /* Sets gamma every color channel is corrected with, value of 1 turns the pass off */
+            void     setGamma(float gamma);
+
+            /* Sets how much the corners get darkened, from 0 (turned off) up; at 1 corners are black */
+            void     setVignette(float strength);
+
+            /* Makes passes split rows among threads of `pool`, null pointer makes them run on the calling thread */
+            void     setWorkerPool(WorkerPool* pool);
+    };
+}
+
+#endif
@@ -0,0 +1,60 @@
+
+#ifndef _RPGE_REFERENCE_HPP
+#define _RPGE_REFERENCE_HPP
+
+#include "RPGE_camera.hpp"
+#include "RPGE_framebuffer.hpp"
+#include "RPGE_globals.hpp"
+#include "RPGE_scene.hpp"
+
+namespace rpge {
+
+    /**
+     * Options of the reference renderer, they mirror the engine ones which change how walls look. Defaults match a
+     * new engine: black clear color and no lighting.
+     */
+    struct ReferenceSettings {
+        int      width;         // Size of the rendered frame in pixels
+        int      height;
+        uint32_t clearColor;    // Color of pixels no wall covers (ARGB8888)
+        bool     lightEnabled;  // Whether walls are shaded by the light direction (see `Engine::setLightBehavior`)
+        float    lightAngle;    // Angle of the light direction in radians
+
+        ReferenceSettings();
+    };
+
+    /**
+     * Renders scenes the way the engine does in the software mode, written as plainly as possible to serve as the
+     * ground truth for its optimized paths (span coherence, the object-order backend, visibility sets, framebuffer
+     * layouts and the opacity early-out). It needs no renderer and keeps no state between frames.
+     *
+     * Every column casts one ray through the tile grid, tests all walls of the tiles it crosses and stops at the first
+     * wall with the ray-termination flag; every pixel then blends the lines covering it from the farthest one over the
+     * clear color. Texture rows and columns are picked with the same formulas the engine uses, so frames match up to
+     * rounding of the ray directions. Indexed textures are drawn in their palette colors, which the engine only
+     * approximates with the colormap levels.
+     */
+    class ReferenceRenderer {
+        private:
+            ReferenceSettings settings;
+        public:
+            ReferenceRenderer(const ReferenceSettings& settings);
+
+            /* Compares `count` pixels (ARGB8888) of images `expected` and `actual`, returns amount of the pixels which
+               differ by more than `tolerance` in any color channel. When `diff` is not a null pointer it receives an
+               image of the differences: matching pixels are dimmed gray, differing ones go from dark to bright red by
+               the largest channel difference. */
+            static int               compare(const uint32_t* expected, const uint32_t* actual, int count, int tolerance,
+                                             uint32_t* diff);
+
+            /* Returns settings the frames are rendered with */
+            const ReferenceSettings& getSettings() const;
+
+            /* Renders scene `scene` seen by camera `camera` into framebuffer `fb`, which is resized to the frame size.
+               Rows of the framebuffer get the pixels, and depths of the nearest line covering them (infinite where
+               nothing is seen), so post passes can run over it. */
+            void                     render(const Scene& scene, const Camera& camera, Framebuffer& fb) const;
+    };
+}
+
+#endif
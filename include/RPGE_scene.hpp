@@ -2,15 +2,20 @@
 #ifndef _RPGE_SCENE_HPP
 #define _RPGE_SCENE_HPP
 
+#include <atomic>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <SDL2/SDL_image.h>
 #include "RPGE_globals.hpp"
 #include "RPGE_math.hpp"
+#include "RPGE_palette.hpp"
+#include "RPGE_threads.hpp"
 
 namespace rpge {
+    using ::std::atomic;
     using ::std::map;
     using ::std::vector;
     using ::std::string;
@@ -19,16 +24,25 @@ namespace rpge {
     using ::std::abs;
     using ::std::make_pair;
     using ::std::stof;
+    using ::std::shared_ptr;
+
+    class VisibilitySet;
 
     /**
      * Defines a wall properties.
-     * You should call `updateMetrics` after changing `func` member, it ensures that variables responsible for
-     * proper wall texturing (`pivot` and `length`) are up to date.
+     * Top-down look of a wall is a segment in local tile coordinates, it can be given directly by its endpoints
+     * or by a linear function clipped to its domain and values ranges. You should call `updateMetrics` after
+     * changing `func` member, or `setSegment` to change the segment, both ensure that variables used for
+     * intersecting and texturing the wall (`start`, `end`, `dir`, `normal`, `length`, `invLength`) are up to date.
      */
     struct WallData {
         LinearFunc func;  // Function describing top-down look of the wall
-        Vector2 pivot;    // Point located in the left half of a tile, indicates the wall beginning
+        Vector2 start;    // Beginning of the wall segment, texture starts here
+        Vector2 end;      // End of the wall segment
+        Vector2 dir;      // Normalized direction from the beginning to the end of the segment
+        Vector2 normal;   // Normalized vector perpendicular to the wall (`dir` rotated clockwisely)
         float length;     // Length of a wall
+        float invLength;  // Inverse of the wall length, 0 for walls of no length
         float hMin, hMax; // Range of wall height to draw
         uint32_t tint;    // Tint color of the wall surface
         uint16_t texId;   // ID number of texture to use (0 indicates no texture)
@@ -36,13 +50,136 @@ namespace rpge {
 
         WallData();
         WallData(const LinearFunc& func, const uint32_t& tint, float hMin, float hMax, uint16_t texId, bool stopsRay);
+        WallData(const Vector2& start, const Vector2& end, const uint32_t& tint, float hMin, float hMax, uint16_t texId, bool stopsRay);
+
+        /* Intersects the wall with a ray entering its tile at local point `localEnter` and going in normalized
+         * direction `direction`. On success returns true, sets `distance` to the distance travelled from the enter
+         * point and `u` to the position of the intersection along the wall, from 0 (`start`) to 1 (`end`). */
+        bool intersect(const Vector2& localEnter, const Vector2& direction, float& distance, float& u) const;
+
+        /* Makes the wall a segment going from `start` to `end` (local tile coordinates), `func` is updated to
+           describe it as well; vertical segments get a steep function like the ones used before segments existed. */
+        void setSegment(const Vector2& start, const Vector2& end);
 
+        /* Computes the wall segment by clipping line of `func` to its domain and values ranges */
         void updateMetrics();
     };
     #ifdef DEBUG
     ostream& operator<<(ostream& stream, const WallData& wd);
     #endif
 
+    /**
+     * Describes a single ray sent through the scene by `Scene::castRay` method, for example a line of sight
+     * or hitscan check. The `direction` does not need to be normalized.
+     */
+    struct RayQuery {
+        Vector2 origin;      // Starting point of the ray in global coordinates
+        Vector2 direction;   // Direction of the ray
+        float   maxDistance; // Ray gives up after travelling this distance
+        bool    solidOnly;   // Flag telling if walls that do not stop rays should be ignored
+
+        RayQuery();
+        RayQuery(const Vector2& origin, const Vector2& direction, float maxDistance);
+        RayQuery(const Vector2& origin, const Vector2& direction, float maxDistance, bool solidOnly);
+    };
+
+    /**
+     * Result of a `RayQuery`, describes the first wall hit by a ray. When `hit` flag is not set, the rest of
+     * members should not be trusted.
+     */
+    struct RayQueryHit {
+        bool    hit;       // Whether any wall was hit
+        bool    blocked;   // Whether the wall hit has ray-termination flag set
+        int     tileId;    // ID of the hit tile
+        int     wallIndex; // Index of the hit wall in vector returned by `Scene::getTileWalls`
+        float   distance;  // Distance from the ray origin to the hit point
+        Vector2 tile;      // Position of the hit tile
+        Vector2 point;     // Global position of the hit point
+
+        RayQueryHit();
+    };
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const RayQueryHit& hit);
+    #endif
+
+    enum TextureStorage {
+        TS_TRUE_COLOR, // Texture pixels are kept in ARGB8888 format
+        TS_INDEXED     // Texture pixels are kept as indices of the scene palette (INDEX8), a quarter of the true color
+                       // size; textures of the renderer made from them still take 4 bytes per pixel
+    };
+
+    /**
+     * Tile grid of `SceneData`.
+     */
+    struct SceneGrid {
+        vector<int>      tiles;     // Tile IDs row after row, from the top of the scene
+        vector<uint64_t> rowHashes; // Row (from the bottom) -> Hash of its RPS line, 0 when unknown
+        uint64_t         revision;  // Stamp taken whenever the tiles change, no other grid has it
+
+        SceneGrid();
+    };
+
+    /**
+     * Walls of the tile IDs of `SceneData`.
+     */
+    struct SceneWalls {
+        map<int, vector<WallData>> tileWalls; // Tile ID -> Array of walls information
+        vector<int>                tileIds;   // All types of tile IDs
+        uint64_t                   revision;  // Stamp taken whenever the walls change, no other walls have it
+
+        SceneWalls();
+    };
+
+    /**
+     * Textures of `SceneData`, their pixels are never changed in place, so even copies of it keep sharing them.
+     */
+    struct SceneTextures {
+        map<int, shared_ptr<SDL_Surface>> texSurfaces; // Texture ID -> Pixels of the texture in format of the storage
+        map<int, bool>                    texOpaque;   // Texture ID -> Whether none of its pixels let walls behind be seen
+        map<string, int>                  texIds;      // File name -> Texture ID
+        map<int, int64_t>                 texTimes;    // Texture ID -> Time its file was written to when it was read
+        TextureStorage                    texStorage;
+        Palette                           texPalette;  // Colors indexed textures refer to
+
+        SceneTextures();
+    };
+
+    /**
+     * Contents of a scene which do not depend on any renderer: the tile grid, walls of the tile IDs and pixels of the
+     * textures. Scenes share it (see `Scene::getData`), and each of the three parts is shared on its own: a scene about
+     * to change one of them copies only that part, so e.g. editing a wall does not copy the tile grid. Any amount of
+     * engines, workers and tools can view the same level while it is kept in memory once.
+     */
+    struct SceneData {
+        int                       width;
+        int                       height;
+        shared_ptr<SceneGrid>     grid;
+        shared_ptr<SceneWalls>    walls;
+        shared_ptr<SceneTextures> textures;
+        string                    rpsFile;  // RPS file the data was read from, empty if none
+        int64_t                   rpsTime;  // Time the RPS file was written to when it was read
+
+        SceneData();
+        SceneData(int width, int height);
+    };
+
+    /**
+     * Result of `Scene::reloadFromFile`, it tells what was changed to make the scene match its file again. Counts are
+     * 0 when the `reloaded` flag is not set.
+     */
+    struct ReloadInfo {
+        bool  reloaded;        // Whether the file was interpreted and applied, the scene stays as it was otherwise
+        int   errorLine;       // Line at which interpretation error occurred (see `Scene::getError`), or the last line
+        int   rowsChanged;     // Rows of the tile grid which got different tile IDs, all of them when the size changed
+        int   tilesChanged;    // Tile IDs whose walls were added, changed or removed
+        int   texturesLoaded;  // Textures read from their files, new ones and the ones whose files were written to
+        int   texturesKept;    // Textures kept resident, their pixels and the renderer textures are reused
+        int   texturesDropped; // Textures no wall refers to anymore
+        float time;            // Seconds the reload took
+
+        ReloadInfo();
+    };
+
     /**
      * Provides a bridge of communication between you and Raycaster Plus Scene (RPS), you can load
      * a scene from file or create it manually. You can also modify scene properties at runtime to
@@ -51,22 +188,58 @@ namespace rpge {
      * RP Scene consists of tile IDs (non-negative numbers) table with `width` columns and `height` rows,
      * each tile ID represents own set of walls, so you can think of them as looks blueprint for every
      * occurrence of that ID. Walls information is stored in structure called `WallData`.
+     *
+     * Scene is a view of `SceneData` for one renderer, the renderer gets its own textures made from the shared pixels
+     * when they are first asked for. Scenes made from data of another one (see `getData`) take no memory of their own
+     * until they are changed; a null renderer is fine for scenes which are never drawn in the hardware mode.
      */
     class Scene {
         private:
             mutable int error;
-            int width;
-            int height;
-            int* tiles;
-            map<int, vector<WallData>> tileWalls; // Tile ID -> Array of walls information
-            map<int, SDL_Texture*> texSources;    // Texture ID -> Pointer to texture structure
-            map<string, int> texIds;              // File name -> Texture ID
-            vector<int> tileIds;                  // All types of tile IDs
+            shared_ptr<SceneData> data;           // Shared with the scenes made from it until one of them changes it
+            mutable atomic<int> shared;           // Parts of the data other scenes may view (`SP_<name>` flags)
+            map<int, SDL_Texture*> texSources;    // Texture ID -> Texture of the renderer, made when first asked for
+            const VisibilitySet* visibility;      // Optional potentially visible set used to bound ray walks, it is
+                                                  // detached when the grid or walls change
             SDL_Renderer* sdlRend;
 
+            // Returns copy of texture pixels `surface` in format of storage `storage`, indexed pixels refer to the
+            // scene palette. Returns null pointer if it fails.
+            SDL_Surface* convertSurface(SDL_Surface* surface, TextureStorage storage) const;
+            // Destroys textures made for the renderer, they are made again from the current pixels when asked for
+            void dropTextures();
+            // Destroys textures made for the renderer whose pixels are not the same in data `next`
+            void dropStaleTextures(const SceneData& next);
+            enum {
+                SP_DATA     = 1 << 0,
+                SP_GRID     = 1 << 1,
+                SP_WALLS    = 1 << 2,
+                SP_TEXTURES = 1 << 3,
+                SP_ALL      = SP_DATA | SP_GRID | SP_WALLS | SP_TEXTURES
+            };
+
+            // Returns data of the scene ready to be changed, it is copied first when other scenes may view it; the
+            // copy still shares all of the parts
+            SceneData* edit();
+            // Return part of the data ready to be changed, the part is copied first when other scenes may view it
+            SceneGrid* editGrid();
+            SceneWalls* editWalls();
+            SceneTextures* editTextures();
+            // Interprets RPS file `rpsFile` into empty data `target`, rows and textures which did not change since data
+            // `previous` was read are taken from it. Returns line at which interpretation error occurred or the last line.
+            int parseRps(const string& rpsFile, SceneData& target, const SceneData& previous);
+            // Returns pixels of image file `file` in format of storage `storage`, or null pointer if it fails
+            SDL_Surface* readTexture(const string& file, TextureStorage storage) const;
+            // Returns ID of texture file `file` in textures `target`, the texture is added to them when it is not there
+            // yet; textures `previous` give its ID, and its pixels unless the file was written to since. Returns 0 if
+            // it fails.
+            int takeTexture(SceneTextures& target, const SceneTextures& previous, const string& file) const;
+            // Returns whether all texture pixels `surface` are fully opaque, transparent index counts as not opaque
+            static bool isSurfaceOpaque(const SDL_Surface* surface);
             // Returns index in the tiles array that corresponds to the specified position
             int posAsDataIndex(int x, int y) const;
         public:
+            static const int QUERY_BATCH_GRAIN; // Amount of ray queries processed by a worker at once
             enum {
                 E_CLEAR,
                 // Raycaster Plus Scene (RPS) file interpreter errors 
@@ -80,22 +253,62 @@ namespace rpge {
             Scene(SDL_Renderer* sdlRend);
             Scene(SDL_Renderer* sdlRend, int width, int height);
             Scene(SDL_Renderer* sdlRend, const string& rpsFile);
+            /* Makes scene viewing data `data` (see `getData`) with renderer `sdlRend`, nothing is copied */
+            Scene(SDL_Renderer* sdlRend, const shared_ptr<const SceneData>& data);
             ~Scene();
 
+            /* Sends a ray described by `query` through the scene and fills `hit` with information about the first
+             * wall it intersects, returns whether any was hit. Method does not modify any state, so it can be called
+             * from multiple threads at once as long as the scene itself is not being modified. */
+            bool               castRay(const RayQuery& query, RayQueryHit& hit) const;
+
+            /* Performs `castRay` for each of `count` queries from `queries` array and stores the results at the
+             * respective indices of `hits` array. Version with `pool` argument splits large batches among its
+             * worker threads. */
+            void               castRays(const RayQuery* queries, RayQueryHit* hits, int count) const;
+            void               castRays(const RayQuery* queries, RayQueryHit* hits, int count, WorkerPool* pool) const;
+
+            /* Returns whether nothing stops a ray going from point `from` to point `to`, only walls with ray-termination
+             * flag set are taken into account. Tiles hidden according to the attached visibility set fail instantly. */
+            bool               checkLineOfSight(const Vector2& from, const Vector2& to) const;
+
             /* Returns if tile location ( `x`, `y` ) is included in the scene bounds */
             bool               checkPosition(int x, int y) const;
 
             /* Appends given wall definition `wd` to collection of walls for tile with ID `tileId`, returns wall
              * index assigned to the created wall that can be later used to obtain it back from vector returned
-             * by `getTileWalls` method. */
+             * by `getTileWalls` method. Attached visibility set is detached. */
             int                createTileWall(int tileId, const WallData& wd);
+
+            /* Replaces wall of index `index` among walls of tile ID `tileId` (see `getTileWalls`) with wall `wd`,
+             * returns whether there is such a wall. Attached visibility set is detached. */
+            bool               setTileWall(int tileId, int index, const WallData& wd);
             
             /* Sets ID of a tile localized at ( `x`, `y` ) to `tileId`, returns whether operation was
-            * successfull. This function does not override source file.  */
+            * successfull. This function does not override source file. Attached visibility set is detached. */
             bool               setTileId(int x, int y, int tileId);
                 
+            /* Returns data of the scene for other scenes to share, it stays the same even when this scene changes
+             * afterwards (the scene gets a copy then). Whether to copy is decided by the thread changing the scene
+             * alone: any part of the data handed out once is copied before its next change, however long the
+             * others keep it. */
+            shared_ptr<const SceneData> getData() const;
+
+            /* Makes the scene view data `data` (see `getData`) instead of its own, nothing is copied. Textures of the
+             * renderer whose pixels are the same in both are kept, so switching between versions of one level (e.g.
+             * snapshots of a running simulation) costs almost nothing. Attached visibility set is detached when the
+             * grid or walls are not the same. */
+            void               setData(const shared_ptr<const SceneData>& data);
+
             /* Returns latest error code set by the class instance */
             int                getError() const;
+
+            /* Returns revision of the tile grid, it changes whenever any tile changes and scenes viewing different
+             * grids never have the same one, so it tells whether what was found from the tiles still holds */
+            uint64_t           getGridRevision() const;
+
+            /* Returns revision of the walls of the tile IDs, it works the same as `getGridRevision` */
+            uint64_t           getWallsRevision() const;
                 
             /* Returns ID of a tile localized at ( `x`, `y` ) if possible, otherwise returns 0 */
             int                getTileId(int x, int y) const;
@@ -114,23 +327,82 @@ namespace rpge {
             * returns empty string. */
             string             getTextureName(int texId) const;
 
+            /* Returns texture of the renderer with array index of `texId`, it is made from the texture pixels the first
+            * time it is asked for. Returns null pointer if it is not loaded or the scene has no renderer. */
             SDL_Texture*       getTextureSource(int texId);
 
+            /* Returns pixels of a texture with array index of `texId` in ARGB8888 format (the same as `enColor`
+            * makes), or INDEX8 format referring to colors of `getTexturePalette()` in the indexed storage. They are
+            * used by the software render mode. Returns null pointer if it is not loaded. */
+            SDL_Surface*       getTextureSurface(int texId) const;
+
+            /* Returns amount of bytes taken by pixels of all textures returned by `getTextureSurface`, textures of the
+             * renderer are not counted */
+            size_t             getTextureMemory() const;
+
+            /* Returns palette the indexed textures refer to */
+            const Palette&     getTexturePalette() const;
+
+            /* Returns format texture pixels are kept in */
+            TextureStorage     getTextureStorage() const;
+
+            /* Returns whether all pixels of a texture with array index of `texId` are fully opaque, so walls using it
+             * hide everything behind them. Returns false if it is not loaded. */
+            bool               isTextureOpaque(int texId) const;
+
+            /* Returns pointer to the attached potentially visible set, or null pointer if there is none */
+            const VisibilitySet* getVisibilitySet() const;
+
 	        /* Returns pointer to a vector holding all types of tile IDs */
             const vector<int>* getTileIds() const;
 
 	        /* Returns pointer to a vector filled with wall definitions for tile with ID `tileId`, or null
-             * pointer if there are no walls defined. You really should not change vector structure, but feel
-             * free to edit its elements by reference. */
-            vector<WallData>*  getTileWalls(int tileId);
+             * pointer if there are no walls defined. It is valid until walls of the scene change, change them with
+             * `createTileWall` and `setTileWall` methods. */
+            const vector<WallData>* getTileWalls(int tileId) const;
 
 	        /* Loads texture from file `file` to an array. Returns array index at which the texture was
 	         * loaded but incremented by one, if failed returns 0. */
             int                loadTexture(const string& file);
 
+            /* Replaces the texture palette with one of up to `count` colors made from pixels of all loaded textures (see
+             * `Palette::fromPixels`), indexed textures get requantized to it. It is best called while the textures
+             * are still kept in true color. */
+            void               fitTexturePalette(int count);
+
+            /* Sets palette `palette` the indexed textures refer to, indexed textures already loaded get requantized
+             * to it. Scene starts with palette of evenly spread colors. */
+            void               setTexturePalette(const Palette& palette);
+
+            /* Sets format texture pixels are kept in, all loaded textures are converted to it. Textures of the indexed
+             * storage are quantized to the texture palette, so it should be set before (see `setTexturePalette` and
+             * `fitTexturePalette`); going back to true color does not bring the lost colors back. Only the pixels kept
+             * by the scene get smaller, they replace the true color ones; textures of the renderer are made from them
+             * in its own format, which has 4 bytes per pixel, so the hardware render mode does not save any memory.
+             * Returns whether all textures were converted. */
+            bool               setTextureStorage(TextureStorage storage);
+
+            /* Attaches potentially visible set `pvs` built for this scene (or detaches it if null pointer is given),
+             * the renderer and ray queries will use it to skip hidden tiles. Set is not owned by the scene. Returns
+             * false and detaches the set when it was not built for the scene as it is (see `VisibilitySet::matches`).
+             * Changes of the tile grid or walls detach the set, rebuild it and attach it again then. */
+            bool               setVisibilitySet(const VisibilitySet* pvs);
+
 	        /* Loads scene from RPS (Raycaster Plus Scene) file `rpsFile`, returns line at which interpretation
 	         * error occurred or the last line with error not set. */ 
             int                loadFromFile(const string& rpsFile);
+
+            /* Reads RPS file `rpsFile` again and changes only what differs: rows of the tile grid, walls of tile IDs
+             * and textures. Rows whose lines did not change are not interpreted again, textures whose file names and
+             * files stayed the same keep their IDs and pixels (and textures of the renderer). The scene stays as it
+             * was when the file can not be interpreted, check `getError` then. Visibility set attached to the scene
+             * is detached when any rows or walls changed. */
+            ReloadInfo         reloadFromFile(const string& rpsFile);
+
+            /* Reloads the RPS file the scene was read from (see `reloadFromFile`) when it or any texture file was
+             * written to since, otherwise it does nothing; `reloaded` flag of the result tells which happened. It
+             * checks times of the files, so call it now and then (e.g. once a second) while the files are edited. */
+            ReloadInfo         reloadIfChanged();
     };
     #ifdef DEBUG
     ostream& operator<<(ostream& stream, const Scene& scene);
@@ -0,0 +1,223 @@
+
+#ifndef _RPGE_SIMD_HPP
+#define _RPGE_SIMD_HPP
+
+#include <cfloat>
+#include "RPGE_math.hpp"
+
+// Instruction sets are picked from the ones targeted by the compiler, define `RPGE_NO_SIMD` to use scalar code only
+#if !defined(RPGE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define RPGE_SIMD_SSE
+    #include <emmintrin.h>
+#endif
+#if !defined(RPGE_NO_SIMD) && defined(__AVX__)
+    #define RPGE_SIMD_AVX
+    #include <immintrin.h>
+#endif
+
+namespace rpge {
+
+    /**
+     * Batch of `N` floats processed at once. This generic version works lane after lane (and leaves the rest to the
+     * compiler), batches of 4 and 8 floats use SSE and AVX registers respectively when these are available.
+     */
+    template<int N>
+    struct FloatBatch {
+        float v[N];
+
+        FloatBatch()
+        {
+            for(int i = 0; i < N; i++)
+                v[i] = 0;
+        }
+        explicit FloatBatch(float value)
+        {
+            for(int i = 0; i < N; i++)
+                v[i] = value;
+        }
+
+        /* Returns batch made of `N` floats read from `src` */
+        static FloatBatch load(const float* src)
+        {
+            FloatBatch result;
+            for(int i = 0; i < N; i++)
+                result.v[i] = src[i];
+            return result;
+        }
+
+        /* Returns value of lane `i` */
+        float get(int i) const
+        {
+            return v[i];
+        }
+
+        /* Writes all `N` lanes to `dst` */
+        void  store(float* dst) const
+        {
+            for(int i = 0; i < N; i++)
+                dst[i] = v[i];
+        }
+    };
+
+    // Applies operator `OP` lane by lane in the generic batch operations
+    #define RPGE_BATCH_LANES(OP)                   \
+        FloatBatch<N> result;                      \
+        for(int i = 0; i < N; i++)                 \
+            result.v[i] = OP;                      \
+        return result;
+
+    template<int N>
+    FloatBatch<N> operator+(const FloatBatch<N>& a, const FloatBatch<N>& b) { RPGE_BATCH_LANES(a.v[i] + b.v[i]) }
+    template<int N>
+    FloatBatch<N> operator-(const FloatBatch<N>& a, const FloatBatch<N>& b) { RPGE_BATCH_LANES(a.v[i] - b.v[i]) }
+    template<int N>
+    FloatBatch<N> operator*(const FloatBatch<N>& a, const FloatBatch<N>& b) { RPGE_BATCH_LANES(a.v[i] * b.v[i]) }
+    template<int N>
+    FloatBatch<N> operator/(const FloatBatch<N>& a, const FloatBatch<N>& b) { RPGE_BATCH_LANES(a.v[i] / b.v[i]) }
+    template<int N>
+    FloatBatch<N> max(const FloatBatch<N>& a, const FloatBatch<N>& b)       { RPGE_BATCH_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+    template<int N>
+    FloatBatch<N> min(const FloatBatch<N>& a, const FloatBatch<N>& b)       { RPGE_BATCH_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+    template<int N>
+    FloatBatch<N> sqrt(const FloatBatch<N>& a)                              { RPGE_BATCH_LANES(sqrtf(a.v[i])) }
+
+    #undef RPGE_BATCH_LANES
+
+    /* Returns bit mask having bit `i` set when lane `i` of `a` is less than lane `i` of `b` */
+    template<int N>
+    int maskLess(const FloatBatch<N>& a, const FloatBatch<N>& b)
+    {
+        int mask = 0;
+        for(int i = 0; i < N; i++)
+            mask |= (a.v[i] < b.v[i]) << i;
+        return mask;
+    }
+
+    #ifdef RPGE_SIMD_SSE
+    template<>
+    struct FloatBatch<4> {
+        __m128 v;
+
+        FloatBatch() : v(_mm_setzero_ps()) {}
+        explicit FloatBatch(float value) : v(_mm_set1_ps(value)) {}
+        FloatBatch(__m128 v) : v(v) {}
+
+        static FloatBatch load(const float* src) { return FloatBatch(_mm_loadu_ps(src)); }
+        float get(int i) const
+        {
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, v);
+            return lanes[i];
+        }
+        void  store(float* dst) const { _mm_storeu_ps(dst, v); }
+    };
+    inline FloatBatch<4> operator+(const FloatBatch<4>& a, const FloatBatch<4>& b) { return _mm_add_ps(a.v, b.v); }
+    inline FloatBatch<4> operator-(const FloatBatch<4>& a, const FloatBatch<4>& b) { return _mm_sub_ps(a.v, b.v); }
+    inline FloatBatch<4> operator*(const FloatBatch<4>& a, const FloatBatch<4>& b) { return _mm_mul_ps(a.v, b.v); }
+    inline FloatBatch<4> operator/(const FloatBatch<4>& a, const FloatBatch<4>& b) { return _mm_div_ps(a.v, b.v); }
+    inline FloatBatch<4> max(const FloatBatch<4>& a, const FloatBatch<4>& b)       { return _mm_max_ps(a.v, b.v); }
+    inline FloatBatch<4> min(const FloatBatch<4>& a, const FloatBatch<4>& b)       { return _mm_min_ps(a.v, b.v); }
+    inline FloatBatch<4> sqrt(const FloatBatch<4>& a)                              { return _mm_sqrt_ps(a.v); }
+    inline int maskLess(const FloatBatch<4>& a, const FloatBatch<4>& b) { return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v)); }
+    #endif
+
+    #ifdef RPGE_SIMD_AVX
+    template<>
+    struct FloatBatch<8> {
+        __m256 v;
+
+        FloatBatch() : v(_mm256_setzero_ps()) {}
+        explicit FloatBatch(float value) : v(_mm256_set1_ps(value)) {}
+        FloatBatch(__m256 v) : v(v) {}
+
+        static FloatBatch load(const float* src) { return FloatBatch(_mm256_loadu_ps(src)); }
+        float get(int i) const
+        {
+            alignas(32) float lanes[8];
+            _mm256_store_ps(lanes, v);
+            return lanes[i];
+        }
+        void  store(float* dst) const { _mm256_storeu_ps(dst, v); }
+    };
+    inline FloatBatch<8> operator+(const FloatBatch<8>& a, const FloatBatch<8>& b) { return _mm256_add_ps(a.v, b.v); }
+    inline FloatBatch<8> operator-(const FloatBatch<8>& a, const FloatBatch<8>& b) { return _mm256_sub_ps(a.v, b.v); }
+    inline FloatBatch<8> operator*(const FloatBatch<8>& a, const FloatBatch<8>& b) { return _mm256_mul_ps(a.v, b.v); }
+    inline FloatBatch<8> operator/(const FloatBatch<8>& a, const FloatBatch<8>& b) { return _mm256_div_ps(a.v, b.v); }
+    inline FloatBatch<8> max(const FloatBatch<8>& a, const FloatBatch<8>& b)       { return _mm256_max_ps(a.v, b.v); }
+    inline FloatBatch<8> min(const FloatBatch<8>& a, const FloatBatch<8>& b)       { return _mm256_min_ps(a.v, b.v); }
+    inline FloatBatch<8> sqrt(const FloatBatch<8>& a)                              { return _mm256_sqrt_ps(a.v); }
+    inline int maskLess(const FloatBatch<8>& a, const FloatBatch<8>& b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+    #endif
+
+    /**
+     * Batch of `N` two-dimensional vectors stored as structure of arrays (one batch of x components and one of
+     * y components), so every operation processes all of the vectors at once.
+     */
+    template<int N>
+    struct Vector2Batch {
+        FloatBatch<N> x, y;
+
+        Vector2Batch() {}
+        explicit Vector2Batch(const Vector2& vec) : x(vec.x), y(vec.y) {}
+        Vector2Batch(const FloatBatch<N>& x, const FloatBatch<N>& y) : x(x), y(y) {}
+
+        /* Returns batch of vectors whose components are read from `xs` and `ys` (`N` of each) */
+        static Vector2Batch load(const float* xs, const float* ys)
+        {
+            return Vector2Batch(FloatBatch<N>::load(xs), FloatBatch<N>::load(ys));
+        }
+
+        FloatBatch<N> dot(const Vector2Batch& other) const
+        {
+            return x * other.x + y * other.y;
+        }
+        /* Returns vector of lane `i` */
+        Vector2       get(int i) const
+        {
+            return Vector2(x.get(i), y.get(i));
+        }
+        FloatBatch<N> magnitude() const
+        {
+            return sqrt(x * x + y * y);
+        }
+        /* Returns normalized vectors, zero vectors stay zero like in case of `Vector2` */
+        Vector2Batch  normalized() const
+        {
+            FloatBatch<N> mag = max(magnitude(), FloatBatch<N>(FLT_MIN));
+            return Vector2Batch(x / mag, y / mag);
+        }
+        /* Writes x components to `xs` and y components to `ys` (`N` of each) */
+        void          store(float* xs, float* ys) const
+        {
+            x.store(xs);
+            y.store(ys);
+        }
+    };
+    template<int N>
+    Vector2Batch<N> operator+(const Vector2Batch<N>& a, const Vector2Batch<N>& b)
+    {
+        return Vector2Batch<N>(a.x + b.x, a.y + b.y);
+    }
+    template<int N>
+    Vector2Batch<N> operator-(const Vector2Batch<N>& a, const Vector2Batch<N>& b)
+    {
+        return Vector2Batch<N>(a.x - b.x, a.y - b.y);
+    }
+    template<int N>
+    Vector2Batch<N> operator*(const Vector2Batch<N>& vec, const FloatBatch<N>& scalars)
+    {
+        return Vector2Batch<N>(vec.x * scalars, vec.y * scalars);
+    }
+    template<int N>
+    Vector2Batch<N> operator*(const Vector2Batch<N>& vec, float scalar)
+    {
+        return vec * FloatBatch<N>(scalar);
+    }
+
+    typedef FloatBatch<4>   Floatx4;
+    typedef FloatBatch<8>   Floatx8;
+    typedef Vector2Batch<4> Vector2x4;
+    typedef Vector2Batch<8> Vector2x8;
+}
+
+#endif
@@ -0,0 +1,171 @@
+
+#ifndef _RPGE_SIMULATION_HPP
+#define _RPGE_SIMULATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "RPGE_camera.hpp"
+#include "RPGE_globals.hpp"
+#include "RPGE_input.hpp"
+#include "RPGE_pacer.hpp"
+#include "RPGE_scene.hpp"
+
+namespace rpge {
+    using ::std::atomic;
+    using ::std::chrono::duration;
+    using ::std::chrono::steady_clock;
+    using ::std::chrono::time_point;
+    using ::std::function;
+    using ::std::shared_ptr;
+    using ::std::thread;
+    using ::std::vector;
+
+    /**
+     * State of a running simulation published at the end of one of its ticks, everything a frame is drawn from. Scene
+     * data is shared with the simulated scene until it changes again (see `Scene::getData`), so it costs nothing.
+     */
+    struct SimulationSnapshot {
+        uint64_t                    tick;       // Ticks done before it was published
+        Camera                      previous;   // Camera at the end of the tick before, frames go from it to `camera`
+        Camera                      camera;     // Camera at the end of the tick
+        shared_ptr<const SceneData> scene;
+        const VisibilitySet*        visibility; // Visibility set attached to the simulated scene
+        time_point<steady_clock>    time;       // Moment it was published at
+        time_point<steady_clock>    inputTime;  // Moment the oldest input event handled in the tick happened at
+        bool                        hasInput;   // Whether any input event was handled in the tick
+
+        SimulationSnapshot();
+    };
+
+    /**
+     * Triple buffer passing snapshots from exactly one writing thread to exactly one reading thread without locks.
+     * The writer fills its back slot and publishes it, the reader takes the latest published one into its front slot;
+     * neither of them ever waits for the other, and snapshots the reader was too slow to take are overwritten.
+     */
+    class SnapshotBuffer {
+        private:
+            SimulationSnapshot slots[3];
+            atomic<int>        middle; // Slot between the writer and the reader, with FRESH flag set while not taken
+            int                back;   // Slot the writer fills
+            int                front;  // Slot the reader views
+
+            enum {
+                FRESH = 1 << 2 // Middle slot holds a snapshot published since the reader last took one
+            };
+        public:
+            SnapshotBuffer();
+
+            /* Takes the latest published snapshot into the front slot, returns false when none was published since
+               the last call and the front slot stays the same (reader) */
+            bool                      acquire();
+
+            /* Returns snapshot in the back slot, it is filled before calling `publish` method (writer) */
+            SimulationSnapshot&       getBack();
+
+            /* Returns snapshot in the front slot, see `acquire` method (reader) */
+            const SimulationSnapshot& getFront() const;
+
+            /* Makes the back slot the latest snapshot, the writer gets another slot to fill (writer) */
+            void                      publish();
+    };
+
+    /**
+     * Runs game logic on a thread of its own at a fixed rate, apart from the frames. Every tick calls the update
+     * function with the tick period, then publishes camera and scene as a snapshot; an engine given the simulation
+     * (see `Engine::setSimulation`) draws the latest one while the next ticks run, so logic and rendering overlap
+     * instead of taking turns. Frames move the camera smoothly between the two latest ticks, which makes them lag one
+     * tick behind.
+     *
+     * While the simulation runs, the camera and the scene belong to its thread: change them only in the update
+     * function. Scene changes copy the changed part of its data (see `SceneData`) once per tick they happen in, the
+     * snapshots keep viewing the old one. Visibility sets attached to the scene must not be rebuilt in place, attach
+     * a new set instead.
+     */
+    class Simulation {
+        private:
+            atomic<bool>             bRun;
+            int                      iTicksPerSecond;
+            atomic<uint64_t>         tickCount;
+            atomic<float>            fMeanTickTime;     // Average (exponential moving average) of the update time
+            atomic<float>            fMeanTickInterval; // Average (exponential moving average) of the time between ticks
+            Camera*                  camera;
+            Scene*                   scene;
+            function<void(float)>    update;
+            Camera                   lastCamera;        // Camera published by the last tick
+            FramePacer               pacer;
+            SnapshotBuffer           snapshots;
+            InputQueue               inputQueue;        // Events handed over by the engine
+            vector<InputEvent>       tickInputs;        // Events handled during the current tick
+            bool                     keysHeld[SDL_NUM_SCANCODES];
+            thread                   worker;
+
+            // Fills the back snapshot with the current state and publishes it
+            void publish();
+            // Body of the simulation thread
+            void loop();
+        public:
+            Simulation(Scene* scene, Camera* camera, int ticksPerSecond);
+            ~Simulation();
+
+            /* Takes the latest published snapshot, see `getSnapshot` method. Returns false when there is no new one,
+               the previous snapshot stays then. Called by the thread drawing the frames. */
+            bool                      acquireSnapshot();
+
+            /* Hands over input events which were waiting for the ticks to take the earlier ones, engine calls it every
+               frame when given the simulation */
+            void                      flushInput();
+
+            /* Returns average time in seconds between starts of consecutive ticks, it is longer than the tick period
+               when the update function can not keep up */
+            float                     getAverageTickInterval() const;
+
+            /* Returns average time in seconds the update function takes per tick */
+            float                     getAverageTickTime() const;
+
+            /* Returns `i`-th of the input events handled during the current tick, they are ordered from the oldest.
+               Called from the update function. */
+            const InputEvent&         getInputEvent(int i) const;
+
+            /* Returns amount of input events handled during the current tick */
+            int                       getInputEventCount() const;
+
+            /* Returns snapshot taken by the last `acquireSnapshot` call, there is always one: the simulation publishes
+               its starting state when it is made */
+            const SimulationSnapshot& getSnapshot() const;
+
+            /* Returns amount of ticks done */
+            uint64_t                  getTickCount() const;
+
+            /* Returns length of a tick in seconds */
+            float                     getTickPeriod() const;
+
+            /* Returns whether key of scancode `sc` is held down according to the input events handled so far.
+               Called from the update function. */
+            bool                      isKeyHeld(int sc) const;
+
+            /* Returns whether the simulation thread runs */
+            bool                      isRunning() const;
+
+            /* Hands input event `event` over to the next tick, or to a later one when too many of them are waiting
+               (see `InputQueue`). Engine calls it for every event when given the simulation. */
+            void                      pushInput(const InputEvent& event);
+
+            /* Sets function called on every tick with the tick period in seconds, it can not be changed while the
+               simulation runs */
+            void                      setUpdate(const function<void(float)>& update);
+
+            /* Starts the simulation thread, does nothing when it already runs */
+            void                      start();
+
+            /* Stops the simulation thread after the tick it is in, the camera and the scene can be changed from any
+               thread again */
+            void                      stop();
+    };
+}
+
+#endif
@@ -0,0 +1,93 @@
+
+#ifndef _RPGE_THREADS_HPP
+#define _RPGE_THREADS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "RPGE_globals.hpp"
+
+namespace rpge {
+    using ::std::atomic;
+    using ::std::condition_variable;
+    using ::std::mutex;
+    using ::std::thread;
+    using ::std::unique_lock;
+    using ::std::vector;
+
+    /**
+     * Reference to a callable taking range of items < `begin` ; `end` ), such as a lambda, which does not own it.
+     * Unlike `function` it never allocates however much the callable captures, so jobs can be given to a worker pool
+     * every frame for free. It is valid only while the callable lives.
+     */
+    class RangeJob {
+        private:
+            const void* callable;
+            void        (*invoker)(const void* callable, int begin, int end);
+
+            // Calls callable of type `Callable` at `callable` with range < `begin` ; `end` )
+            template<typename Callable>
+            static void invoke(const void* callable, int begin, int end)
+            {
+                (*static_cast<const Callable*>(callable))(begin, end);
+            }
+        public:
+            template<typename Callable>
+            RangeJob(const Callable& callable)
+            {
+                this->callable = &callable;
+                this->invoker  = &invoke<Callable>;
+            }
+
+            /* Calls the callable with range < `begin` ; `end` ) */
+            void operator()(int begin, int end) const
+            {
+                invoker(callable, begin, end);
+            }
+    };
+
+    /**
+     * Keeps a fixed set of worker threads alive and lends them to data-parallel jobs, so engine subsystems
+     * do not have to spawn threads every frame.
+     *
+     * A job is a range of `count` items split into chunks of `grain` items, call `run` method and it will
+     * return after every chunk was processed; the calling thread takes part in the work too. Jobs submitted
+     * from several threads at once are executed one after another.
+     */
+    class WorkerPool {
+        private:
+            bool                             stopping;
+            int                              jobCount;
+            int                              jobGrain;
+            int                              doneWorkers; // Workers that finished the current job
+            uint64_t                         generation;  // Incremented every time a new job is published
+            atomic<int>                      nextItem;    // First item of the next unclaimed chunk
+            const RangeJob*                  job;
+            mutex                            runLock;     // Serializes `run` callers
+            mutex                            stateLock;
+            condition_variable               wakeSignal;
+            condition_variable               doneSignal;
+            vector<thread>                   workers;
+
+            // Claims and processes chunks of the current job until there are none left
+            void processChunks();
+            // Body of worker thread `index` (from 1, the calling thread is 0)
+            void workerLoop(int index);
+        public:
+            WorkerPool();
+            WorkerPool(int threadCount);
+            ~WorkerPool();
+
+            /* Returns amount of threads taking part in jobs, including the one calling `run` */
+            int  getThreadCount() const;
+
+            /* Calls `job(begin, end)` for consecutive chunks of range < 0 ; `count` ) having at most `grain` items,
+               chunks are distributed among all pool threads. Returns after all of them are done. Any callable can
+               be given (see `RangeJob`), nothing is allocated for it. */
+            void run(int count, int grain, const RangeJob& job);
+    };
+}
+
+#endif
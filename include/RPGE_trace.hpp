@@ -0,0 +1,126 @@
+
+#ifndef _RPGE_TRACE_HPP
+#define _RPGE_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "RPGE_globals.hpp"
+
+/**
+ * Scoped spans are recorded with these macros, they compile to nothing when the library is built without
+ * `RPGE_TRACING` defined (see `RPGE_ENABLE_TRACING` option). Names must be string literals (or live as long as the
+ * program does), only their pointers are kept.
+ *
+ * `RPGE_TRACE_SCOPE(name)` records span lasting until the end of the enclosing scope, `RPGE_TRACE_SPAN(span, name)`
+ * starts span `span` which `RPGE_TRACE_END(span)` ends earlier (or the end of scope, when it is not called).
+ */
+#ifdef RPGE_TRACING
+    #define RPGE_TRACE_JOIN_(a, b)       a##b
+    #define RPGE_TRACE_JOIN(a, b)        RPGE_TRACE_JOIN_(a, b)
+    #define RPGE_TRACE_SCOPE(name)       ::rpge::TraceScope RPGE_TRACE_JOIN(rpgeTraceScope, __LINE__)(name)
+    #define RPGE_TRACE_SPAN(span, name)  ::rpge::TraceScope span(name)
+    #define RPGE_TRACE_END(span)         span.end()
+#else
+    #define RPGE_TRACE_SCOPE(name)       ((void)0)
+    #define RPGE_TRACE_SPAN(span, name)  ((void)0)
+    #define RPGE_TRACE_END(span)         ((void)0)
+#endif
+
+namespace rpge {
+    using ::std::atomic;
+    using ::std::ostream;
+    using ::std::memory_order_relaxed;
+
+    /**
+     * Records timeline of named spans from every thread into its own ring buffer, which keeps the newest
+     * `RING_CAPACITY` spans. Recording takes no locks (a thread locks once, when it records its first span) and
+     * does not allocate, so it can stay on in shipped builds; while tracing is disabled a span costs a single relaxed
+     * load of a flag.
+     *
+     * Rings are written as Chrome trace-event JSON (open it in `chrome://tracing` or Perfetto) on demand using
+     * `writeChromeJson`, or by a background thread when a frame takes longer than the spike threshold (see
+     * `setSpikeTrigger`). Rings can be written while their threads keep recording.
+     */
+    class Tracer {
+        private:
+            static atomic<bool> enabled;
+        public:
+            static const int RING_CAPACITY; // Spans kept per thread
+
+            /* Returns whether spans are recorded */
+            static bool    isEnabled()
+            {
+                return enabled.load(memory_order_relaxed);
+            }
+
+            /* Returns current time in nanoseconds on the clock spans are measured with */
+            static int64_t now()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            /* Tells the tracer a frame which took `frameTime` seconds has ended, the rings are written to a new file when
+               it exceeds the spike threshold. Returns whether it did; the file is written by a background thread, so
+               it holds the spans recorded up to a moment later. */
+            static bool    checkSpike(float frameTime);
+
+            /* Forgets spans recorded by all threads so far */
+            static void    clear();
+
+            /* Records span `name` of the calling thread going from time `start` to `end` (see `now` method) */
+            static void    record(const char* name, int64_t start, int64_t end);
+
+            /* The `enabled` flag turns on/off recording, it is off by default */
+            static void    setEnabled(bool enabled);
+
+            /* Makes frames longer than `frameTime` seconds write the rings to files `prefix` + number + ".json" (see
+               `checkSpike` method), only the first frame of every spike does. Value of 0 turns it off (the default). */
+            static void    setSpikeTrigger(float frameTime, const string& prefix);
+
+            /* Names the calling thread `name` in the written traces */
+            static void    setThreadName(const string& name);
+
+            /* Writes spans kept in the rings of all threads to stream `stream` as Chrome trace-event JSON */
+            static void    writeChromeJson(ostream& stream);
+
+            /* Writes spans kept in the rings of all threads to file `file` as Chrome trace-event JSON, returns false if
+               the file can not be written */
+            static bool    writeChromeJson(const string& file);
+    };
+
+    /**
+     * Span recorded from its construction to its destruction (or `end` call), use it through `RPGE_TRACE_SCOPE` and
+     * `RPGE_TRACE_SPAN` macros so it gets compiled out with the rest of tracing.
+     */
+    class TraceScope {
+        private:
+            const char* name; // Null pointer once recorded, or when tracing was disabled at the start
+            int64_t     start;
+        public:
+            TraceScope(const char* name)
+            {
+                this->name  = Tracer::isEnabled() ? name : nullptr;
+                this->start = this->name != nullptr ? Tracer::now() : 0;
+            }
+            TraceScope(const TraceScope&) = delete;
+            TraceScope& operator=(const TraceScope&) = delete;
+            ~TraceScope()
+            {
+                end();
+            }
+
+            /* Records the span now, later calls do nothing */
+            void end()
+            {
+                if(name == nullptr)
+                    return;
+                Tracer::record(name, start, Tracer::now());
+                name = nullptr;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,128 @@
+
+#ifndef _RPGE_VISIBILITY_HPP
+#define _RPGE_VISIBILITY_HPP
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "RPGE_globals.hpp"
+#include "RPGE_math.hpp"
+#include "RPGE_scene.hpp"
+#include "RPGE_threads.hpp"
+
+namespace rpge {
+    using ::std::ifstream;
+    using ::std::ofstream;
+    using ::std::pair;
+    using ::std::string;
+    using ::std::vector;
+
+    /**
+     * Potentially visible set (PVS) of a scene: for every tile it stores which other tiles can be seen from
+     * any point inside of it, together with the distance to the farthest of them (tile reach).
+     *
+     * Sets are computed by `build` method and are conservative: a tile is left out only when every line from every
+     * point of the source tile towards it is blocked. Only opaque tiles block lines, that is tiles closed on all four
+     * sides by walls having ray-termination flag set, each side by one wall going from corner to corner; any other
+     * walls never hide anything. Visibility bits of each tile are kept run-length
+     * encoded, so large maps stay small in memory. The result can be saved next to the scene file using
+     * `saveToFile` method and loaded back instead of rebuilding.
+     *
+     * Attach the set to a scene using `Scene::setVisibilitySet`, both the renderer and ray queries will then
+     * skip invisible tiles and stop rays that walked past the tile reach.
+     */
+    class VisibilitySet {
+        private:
+            mutable int      error;
+            int              width;
+            int              height;
+            uint32_t         checksum; // Checksum of the scene grid the set was built for
+            int              revision; // Amount of times the set was built or loaded
+            vector<uint32_t> offsets;  // Tile index -> Offset of its encoded runs, with one extra element at the end
+            vector<uint8_t>  runs;     // Alternating lengths of invisible and visible tile runs, stored as varints
+            vector<float>    reach;    // Tile index -> Distance to the farthest visible tile
+
+            // Computes checksum of tile IDs and wall counts of `scene`, so stale sets can be detected
+            static uint32_t computeChecksum(const Scene& scene);
+            // Returns whether offsets, reach and runs describe `width` x `height` tiles, each run staying in the grid
+            bool isEncodingValid() const;
+            // Reads variable-length number from `data` at `offset` (not exceeding `end`) and moves the offset past it,
+            // numbers longer than MAX_VARINT_SIZE bytes are cut off there
+            static uint32_t readVarint(const vector<uint8_t>& data, uint32_t& offset, uint32_t end);
+            // Returns whether tile ( `x`, `y` ) of `scene` is closed on all four sides by ray-stopping walls
+            static bool isOpaque(const Scene& scene, int x, int y);
+            // Fills `blockers` with rectangles (x0, x1, y0, y1) of opaque tile ( `x`, `y` ) shrunk by EROSION on its
+            // sides and inner corners facing tiles which are not opaque, returns how many rectangles there are
+            static int  getBlockers(const vector<uint8_t>& opaque, int width, int height, int x, int y, float blockers[2][4]);
+            // Casts shadows of opaque tiles from points around the edge of tile ( `x`, `y` ) and appends indices of tiles
+            // with walls left in light to `touched` (with no repeats)
+            static void sweepTile(const Scene& scene, const vector<uint8_t>& opaque, int x, int y, float maxDistance, vector<uint8_t>& marks, vector<int>& touched);
+            // Removes slopes from `low` to `high` out of sorted slope ranges `open`
+            static void subtractRange(vector<pair<float, float>>& open, float low, float high);
+        public:
+            static const int   FILE_VERSION;
+            static const int   MAX_VARINT_SIZE; // Bytes a 32-bit number takes at most
+            static const int   MAX_TILES;       // Sets loaded from files cover at most this many tiles
+            static const float SAMPLE_SPACING;  // Distance between points along tile edges which shadows are cast from
+            static const float EROSION;         // Margin taken off opaque tiles, over half of SAMPLE_SPACING so that
+                                                // lines from points between the samples are covered too
+            enum {
+                E_CLEAR,
+                E_PVS_FAILED_TO_READ,
+                E_PVS_FAILED_TO_WRITE,
+                E_PVS_INVALID_FORMAT,  // File is not a visibility set, was written by other version or is damaged
+                E_PVS_INVALID_SCENE    // Scene has no tiles
+            };
+
+            VisibilitySet();
+
+            /* Computes the set for `scene`, considering only tiles not farther than `maxDistance` from each other.
+               Shadows of opaque tiles are cast from points every SAMPLE_SPACING along the edges of each tile, with
+               opaque tiles shrunk by EROSION so that nothing seen from the points in between is missed. Version with
+               `pool` argument splits work among its worker threads. */
+            void  build(const Scene& scene, float maxDistance);
+            void  build(const Scene& scene, float maxDistance, WorkerPool* pool);
+
+            /* Fills `visible` (one element per tile, indexed the same way as `getTileIndex`) with visibility flags of
+               tiles seen from tile ( `x`, `y` ), returns false if that tile is out of bounds. */
+            bool  decode(int x, int y, vector<uint8_t>& visible) const;
+
+            /* Returns latest error code set by the class instance */
+            int   getError() const;
+
+            /* Returns size of the encoded visibility data in bytes */
+            int   getEncodedSize() const;
+
+            /* Returns height of the scene the set was built for, in tiles */
+            int   getHeight() const;
+
+            /* Returns number which changes every time the set is built or loaded, so anything kept from the set can be
+               told to be stale */
+            int   getRevision() const;
+
+            /* Returns distance to the farthest tile visible from tile ( `x`, `y` ), or -1 if it is out of bounds */
+            float getReach(int x, int y) const;
+
+            /* Returns index of tile ( `x`, `y` ) in vectors filled by `decode` method */
+            int   getTileIndex(int x, int y) const;
+
+            /* Returns width of the scene the set was built for, in tiles */
+            int   getWidth() const;
+
+            /* Returns whether tile ( `toX`, `toY` ) is visible from tile ( `fromX`, `fromY` ) */
+            bool  isVisible(int fromX, int fromY, int toX, int toY) const;
+
+            /* Returns whether the set was built for a scene looking like `scene` */
+            bool  matches(const Scene& scene) const;
+
+            /* Loads the set from binary file `file`, returns whether it succeeded. Files whose sizes, offsets or
+               runs do not fit the grid they claim are rejected and the set stays as it was. */
+            bool  loadFromFile(const string& file);
+
+            /* Saves the set to binary file `file`, returns whether it succeeded */
+            bool  saveToFile(const string& file) const;
+    };
+}
+
+#endif
@@ -65,6 +65,23 @@ namespace rpge
     {
         return direction;
     }
+    Camera Camera::interpolate(const Camera& next, float t) const
+    {
+        float angle = atan2f(direction.y, direction.x);
+        float turn  = atan2f(next.direction.y, next.direction.x) - angle;
+        if(turn > M_PI)
+            turn -= 2 * M_PI;
+        else if(turn < -M_PI)
+            turn += 2 * M_PI;
+
+        // Camera is turned instead of made from the angle, so it stays exactly the same when nothing changes
+        Camera result = *this;
+        result.position = position + (next.position - position) * t;
+        if(next.fieldOfView != fieldOfView)
+            result.setFieldOfView(fieldOfView + (next.fieldOfView - fieldOfView) * t);
+        result.changeDirection(turn * t);
+        return result;
+    }
     #ifdef DEBUG
     ostream& operator<<(ostream& stream, const Camera& cam)
     {
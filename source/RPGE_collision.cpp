@@ -0,0 +1,261 @@
+
+#include <RPGE_collision.hpp>
+
+namespace rpge
+{
+
+    /***********************************************/
+    /********** STRUCTURE: COLLISION BODY **********/
+    /***********************************************/
+
+    CollisionBody::CollisionBody()
+    {
+        this->position = Vector2::ZERO;
+        this->radius = 0.25f;
+        this->hMin = 0;
+        this->hMax = 1;
+    }
+    CollisionBody::CollisionBody(const Vector2& position, float radius) : CollisionBody()
+    {
+        this->position = position;
+        this->radius = radius;
+    }
+    CollisionBody::CollisionBody(const Vector2& position, float radius, float hMin, float hMax) : CollisionBody(position, radius)
+    {
+        this->hMin = hMin;
+        this->hMax = hMax;
+    }
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const CollisionBody& body)
+    {
+        stream << "CollisionBody(position=" << body.position << ", radius=" << body.radius << ", hMin=" << body.hMin;
+        stream << ", hMax=" << body.hMax << ")";
+        return stream;
+    }
+    #endif
+
+    /**************************************************/
+    /********** STRUCTURE: COLLISION SEGMENT **********/
+    /**************************************************/
+
+    CollisionSegment::CollisionSegment()
+    {
+        this->start = Vector2::ZERO;
+        this->end = Vector2::ZERO;
+    }
+    CollisionSegment::CollisionSegment(const Vector2& start, const Vector2& end)
+    {
+        this->start = start;
+        this->end = end;
+    }
+
+    /*************************************/
+    /********** CLASS: COLLIDER **********/
+    /*************************************/
+
+    const int Collider::BATCH_GRAIN = 32;
+
+    Collider::Collider()
+    {
+        this->solidOnly = false;
+        this->maxIterations = 4;
+        this->skinWidth = 0.001f;
+        this->scene = nullptr;
+    }
+    Collider::Collider(const Scene* scene) : Collider()
+    {
+        setTargetScene(scene);
+    }
+    void Collider::setMaxIterations(int n)
+    {
+        maxIterations = n < 1 ? 1 : n;
+    }
+    void Collider::setSkinWidth(float width)
+    {
+        skinWidth = width < 0 ? 0 : width;
+    }
+    void Collider::setSolidOnly(bool solidOnly)
+    {
+        this->solidOnly = solidOnly;
+    }
+    void Collider::setTargetScene(const Scene* scene)
+    {
+        this->scene = scene;
+    }
+    const Scene* Collider::getTargetScene() const
+    {
+        return scene;
+    }
+    bool Collider::sweep(const Vector2& position, const Vector2& delta, float radius, const CollisionSegment& segment, float& time, Vector2& normal)
+    {
+        bool found = false;
+        time = 1;
+
+        // Test against the segment body, which is the line shifted towards the circle by its radius
+        Vector2 ab = segment.end - segment.start;
+        float len2 = ab.dot(ab);
+        if(len2 > 0)
+        {
+            Vector2 n = ab.orthogonal() / sqrt(len2);
+            float dist = (position - segment.start).dot(n);
+            if(dist < 0)
+            {
+                n *= -1;
+                dist *= -1;
+            }
+            float approach = delta.dot(n);
+            if(approach < 0)
+            {
+                // Circle already touching the line is stopped immediately
+                float t = dist <= radius ? 0 : (radius - dist) / approach;
+                if(t <= time)
+                {
+                    Vector2 contact = position + delta * t - n * radius;
+                    float along = (contact - segment.start).dot(ab) / len2;
+                    if(along >= 0 && along <= 1)
+                    {
+                        time = t;
+                        normal = n;
+                        found = true;
+                    }
+                }
+            }
+        }
+
+        // Test against both segment ends, which are circles of the same radius when looked from the moving circle
+        const Vector2* ends[2] = { &segment.start, &segment.end };
+        float a = delta.dot(delta);
+        for(int i = 0; i != 2; i++)
+        {
+            Vector2 m = position - *ends[i];
+            float b = m.dot(delta);
+            float c = m.dot(m) - radius * radius;
+            if(b >= 0 || c < 0) // Moving away or overlapping already (left for depenetration)
+                continue;
+            float disc = b * b - a * c;
+            if(disc < 0)
+                continue;
+            float t = (-b - sqrt(disc)) / a;
+            if(t >= 0 && t < time)
+            {
+                time = t;
+                normal = (m + delta * t).normalized();
+                found = true;
+            }
+        }
+        return found;
+    }
+    Vector2 Collider::closestPoint(const Vector2& point, const CollisionSegment& segment)
+    {
+        Vector2 ab = segment.end - segment.start;
+        float len2 = ab.dot(ab);
+        if(len2 == 0)
+            return segment.start;
+        float along = clamp((point - segment.start).dot(ab) / len2, 0.0f, 1.0f);
+        return segment.start + ab * along;
+    }
+    void Collider::gatherSegments(const CollisionBody& body, const Vector2& boundMin, const Vector2& boundMax, vector<CollisionSegment>& segments) const
+    {
+        int xMin = floorf(boundMin.x), xMax = floorf(boundMax.x);
+        int yMin = floorf(boundMin.y), yMax = floorf(boundMax.y);
+        for(int y = yMin; y <= yMax; y++)
+            for(int x = xMin; x <= xMax; x++)
+            {
+                const vector<WallData>* walls = scene->getTileWalls(scene->getTileId(x, y));
+                if(walls == nullptr)
+                    continue;
+
+                Vector2 origin(x, y);
+                for(const WallData& wd : *walls)
+                {
+                    if(solidOnly && !wd.stopsRay)
+                        continue;
+                    if(wd.hMax <= body.hMin || wd.hMin >= body.hMax)
+                        continue;
+                    segments.push_back(CollisionSegment(origin + wd.start, origin + wd.end));
+                }
+            }
+    }
+    Vector2 Collider::move(CollisionBody& body, const Vector2& delta) const
+    {
+        vector<CollisionSegment> segments;
+        return move(body, delta, segments);
+    }
+    Vector2 Collider::move(CollisionBody& body, const Vector2& delta, vector<CollisionSegment>& segments) const
+    {
+        Vector2 start = body.position;
+        if(scene == nullptr)
+        {
+            body.position += delta;
+            return delta;
+        }
+
+        // Sliding never takes the body farther than the full move, so walls around that area are enough
+        float reach = delta.magnitude() + body.radius + skinWidth;
+        segments.clear();
+        gatherSegments(body, start - Vector2(reach, reach), start + Vector2(reach, reach), segments);
+
+        Vector2 position  = start;
+        Vector2 remaining = delta;
+        for(int i = 0; i < maxIterations && remaining != Vector2::ZERO; i++)
+        {
+            // Find the first wall hit along the remaining path
+            bool hit = false;
+            float time = 1;
+            Vector2 normal;
+            for(const CollisionSegment& segment : segments)
+            {
+                float t;
+                Vector2 n;
+                if(sweep(position, remaining, body.radius, segment, t, n) && (!hit || t < time))
+                {
+                    hit = true;
+                    time = t;
+                    normal = n;
+                }
+            }
+            if(!hit)
+            {
+                position += remaining;
+                break;
+            }
+
+            // Stop slightly before the contact, then slide along the wall with what is left of the move
+            float length = remaining.magnitude();
+            float safeTime = time - skinWidth / length;
+            safeTime = safeTime < 0 ? 0 : safeTime;
+            position += remaining * safeTime;
+            remaining *= 1 - safeTime;
+            remaining -= normal * remaining.dot(normal);
+        }
+
+        // Push the body out of walls it still overlaps (for example when it was spawned inside one)
+        for(const CollisionSegment& segment : segments)
+        {
+            Vector2 away = position - closestPoint(position, segment);
+            float dist = away.magnitude();
+            if(dist > 0 && dist < body.radius)
+                position += away * ((body.radius - dist) / dist);
+        }
+
+        body.position = position;
+        return position - start;
+    }
+    void Collider::moveAll(CollisionBody* bodies, const Vector2* deltas, int count) const
+    {
+        vector<CollisionSegment> segments;
+        for(int i = 0; i < count; i++)
+            move(bodies[i], deltas[i], segments);
+    }
+    void Collider::moveAll(CollisionBody* bodies, const Vector2* deltas, int count, WorkerPool* pool) const
+    {
+        if(pool == nullptr || count <= BATCH_GRAIN)
+        {
+            moveAll(bodies, deltas, count);
+            return;
+        }
+        pool->run(count, BATCH_GRAIN, [&](int begin, int end) {
+            moveAll(bodies + begin, deltas + begin, end - begin);
+        });
+    }
+}
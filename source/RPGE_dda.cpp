@@ -62,6 +62,25 @@ namespace rpge
     {
         return scene;
     }
+    Vector2 DDA::getLocalEnter(const RayHitInfo& hit) const
+    {
+        // Keep the point pivoted to the bottom-left corner of a tile when looking at it from the top. If hit distance
+        // is exactly 0 it indicates that hit occurred inside the origin tile.
+        Vector2 localEnter;
+        float localX = hit.point.x - (int)hit.point.x;
+        float localY = hit.point.y - (int)hit.point.y;
+        if(rayFlag & RF_SIDE)
+        {
+            localEnter.x = !hit.distance ? localX : (direction.x < 0);
+            localEnter.y = localY;
+        }
+        else
+        {
+            localEnter.x = localX;
+            localEnter.y = !hit.distance ? localY : (direction.y < 0);
+        }
+        return localEnter;
+    }
     void DDA::init(const Vector2& start, const Vector2& direction)
     {
         if(scene == nullptr)
@@ -1,22 +1,108 @@
 
 #include <RPGE_engine.hpp>
+#include <RPGE_pixel.hpp>
+
+// Returns distance along ray going from `origin` in direction `dir` at which it enters tile `tile`, measured the way
+// DDA measures distances of the hits (0 inside the tile)
+static inline float getTileEnterDistance(const rpge::Vector2& origin, const rpge::Vector2& dir, const rpge::Vector2& tile)
+{
+    float enter = 0;
+    if(dir.x != 0)
+    {
+        float t0 = (tile.x - origin.x) / dir.x, t1 = (tile.x + 1 - origin.x) / dir.x;
+        enter = t0 < t1 ? t0 : t1;
+    }
+    if(dir.y != 0)
+    {
+        float t0 = (tile.y - origin.y) / dir.y, t1 = (tile.y + 1 - origin.y) / dir.y;
+        float enterY = t0 < t1 ? t0 : t1;
+        enter = enterY > enter ? enterY : enter;
+    }
+    return enter > 0 ? enter : 0;
+}
 
 namespace rpge
 {    
 
+    /**********************************************/
+    /********** STRUCTURE: COLUMN SAMPLE **********/
+    /**********************************************/
+
+    ColumnSample::ColumnSample()
+    {
+        this->hit = false;
+        this->tileId = 0;
+        this->wallIndex = -1;
+        this->drawStart = 0;
+        this->drawEnd = 0;
+        this->depth = -1;
+        this->u = 0;
+        this->tile = Vector2::ZERO;
+        this->point = Vector2::ZERO;
+    }
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const ColumnSample& sample)
+    {
+        stream << "ColumnSample(hit=" << sample.hit << ", tileId=" << sample.tileId << ", wallIndex=" << sample.wallIndex;
+        stream << ", drawStart=" << sample.drawStart << ", drawEnd=" << sample.drawEnd << ", depth=" << sample.depth;
+        stream << ", u=" << sample.u << ", tile=" << sample.tile << ", point=" << sample.point << ")";
+        return stream;
+    }
+    #endif
+
     /***********************************/
     /********** CLASS: ENGINE **********/
     /***********************************/
 
-    const float Engine::SAFE_LINE_HEIGHT = 0.0001f;
-
-    Engine::Engine(int screenWidth, int screenHeight)
+    const float Engine::SAFE_LINE_HEIGHT   = 0.0001f;
+    const int   Engine::TRANSLUCENT_LAYERS = 16;
+
+    const Engine::ColumnKernel Engine::COLUMN_KERNELS[32] = {
+        &Engine::drawColumn<false, false, false, false, false>,
+        &Engine::drawColumn<true,  false, false, false, false>,
+        &Engine::drawColumn<false, true,  false, false, false>,
+        &Engine::drawColumn<true,  true,  false, false, false>,
+        &Engine::drawColumn<false, false, true,  false, false>,
+        &Engine::drawColumn<true,  false, true,  false, false>,
+        &Engine::drawColumn<false, true,  true,  false, false>,
+        &Engine::drawColumn<true,  true,  true,  false, false>,
+        &Engine::drawColumn<false, false, false, true,  false>,
+        &Engine::drawColumn<true,  false, false, true,  false>,
+        &Engine::drawColumn<false, true,  false, true,  false>,
+        &Engine::drawColumn<true,  true,  false, true,  false>,
+        &Engine::drawColumn<false, false, true,  true,  false>,
+        &Engine::drawColumn<true,  false, true,  true,  false>,
+        &Engine::drawColumn<false, true,  true,  true,  false>,
+        &Engine::drawColumn<true,  true,  true,  true,  false>,
+        &Engine::drawColumn<false, false, false, false, true>,
+        &Engine::drawColumn<true,  false, false, false, true>,
+        &Engine::drawColumn<false, true,  false, false, true>,
+        &Engine::drawColumn<true,  true,  false, false, true>,
+        &Engine::drawColumn<false, false, true,  false, true>,
+        &Engine::drawColumn<true,  false, true,  false, true>,
+        &Engine::drawColumn<false, true,  true,  false, true>,
+        &Engine::drawColumn<true,  true,  true,  false, true>,
+        &Engine::drawColumn<false, false, false, true,  true>,
+        &Engine::drawColumn<true,  false, false, true,  true>,
+        &Engine::drawColumn<false, true,  false, true,  true>,
+        &Engine::drawColumn<true,  true,  false, true,  true>,
+        &Engine::drawColumn<false, false, true,  true,  true>,
+        &Engine::drawColumn<true,  false, true,  true,  true>,
+        &Engine::drawColumn<false, true,  true,  true,  true>,
+        &Engine::drawColumn<true,  true,  true,  true,  true>
+    };
+
+    Engine::Engine(int screenWidth, int screenHeight) : Engine(screenWidth, screenHeight, false)
+    {
+    }
+    Engine::Engine(int screenWidth, int screenHeight, bool headless)
     {
         this->bClear             = false;
         this->bIsCursorLocked    = false;
         this->bLightEnabled      = false;
         this->bRedraw            = false;
         this->bRun               = true;
+        this->bSpanCoherence     = true;
         this->iError             = E_CLEAR;
         this->iColumnsPerRay     = 1;
         this->iFramesPerSecond   = 60;
@@ -24,45 +110,113 @@ namespace rpge
         this->iScreenWidth       = screenWidth < 1 ? 1 : screenWidth;
         this->iScreenHeight      = screenHeight < 1 ? 1 : screenHeight;
         this->fAspectRatio       = iScreenHeight / (float)iScreenWidth;
+        this->fOpacityThreshold  = 0.99f;
         this->cClearColor        = { 0, 0, 0, 255 };
         this->frameIndex         = 0;
+        this->frameAllocations   = 0;
         this->vLightDir          = Vector2::RIGHT;
-        this->tpLast             = system_clock::now();
+        this->tpLast             = steady_clock::now();
         this->elapsedTime        = duration<float>(0);
         this->rClearArea         = { 0, 0, iScreenWidth, iScreenHeight };
         this->rRenderArea        = rClearArea;
-        this->keyStates          = map<int, KeyState>();
-
-        if(SDL_InitSubSystem(SDL_INIT_VIDEO) == 0)
+        this->dirtyCount         = 0;
+        this->frameInputs        = vector<InputEvent>();
+        this->fInputLatency      = 0;
+        this->fMeanInputLatency  = 0;
+        this->simulation         = nullptr;
+        this->serialScene        = nullptr;
+        this->bFreshSnapshot     = false;
+        this->fSnapshotLatency   = 0;
+        this->fMeanSnapshotLatency = 0;
+        for(int sc = 0; sc < SDL_NUM_SCANCODES; sc++)
+        {
+            this->keyStates[sc] = KeyState::NONE;
+            this->keyFlags[sc]  = 0;
+        }
+        // Events of a frame are taken from the input queue, so there are never more of them than it can hold
+        this->frameInputs.reserve(InputQueue::CAPACITY);
+        this->iPvsTile           = -1;
+        this->pvsSource          = nullptr;
+        this->iPvsRevision       = 0;
+        this->iCoherentColumns   = 0;
+        this->backend            = RB_AUTO;
+        this->frameBackend       = RB_RAYCAST;
+        this->fRaycastCost       = -1;
+        this->fObjectCost        = -1;
+        this->costScene          = nullptr;
+        this->costGridRevision   = 0;
+        this->costWallsRevision  = 0;
+        this->fStopDensity       = 0;
+        this->fWallDensity       = 0;
+        this->bProbeFrame        = false;
+        this->rSampleArea        = { 0, 0, 0, 0 };
+        this->iSampleColumnsPerRay = 1;
+        this->renderMode         = RM_HARDWARE;
+        this->frameTexture       = nullptr;
+        this->heatTexture        = nullptr;
+        this->minimapTexture     = nullptr;
+        this->layerExclusions    = nullptr;
+        this->transmittance      = nullptr;
+        this->sdlRend            = nullptr;
+        this->sdlWindow          = nullptr;
+        this->sdlSurface         = nullptr;
+
+        // Headless engine draws into a surface with the software renderer, which needs no video device
+        if(SDL_InitSubSystem(headless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO) == 0)
         {
             this->mainCamera = nullptr;
             this->walker     = new DDA();
-            this->sdlWindow  = SDL_CreateWindow("Raycaster Plus Engine", 0, 0, screenWidth, screenHeight, SDL_WINDOW_SHOWN);
-            if(sdlWindow != nullptr)
+            if(headless)
             {
-                this->sdlRend = SDL_CreateRenderer(sdlWindow, -1, SDL_RENDERER_ACCELERATED);
-                if(sdlRend != nullptr)
-                {
-                    // Everything is OK
-                    SDL_SetRenderDrawBlendMode(sdlRend, SDL_BLENDMODE_BLEND);
-                    SDL_SetRenderDrawColor(sdlRend, 0, 0, 0, 255);
-                    SDL_RenderClear(sdlRend);
+                this->sdlSurface = SDL_CreateRGBSurfaceWithFormat(0, iScreenWidth, iScreenHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+                if(sdlSurface != nullptr)
+                    this->sdlRend = SDL_CreateSoftwareRenderer(sdlSurface);
+            }
+            else
+            {
+                this->sdlWindow = SDL_CreateWindow("Raycaster Plus Engine", 0, 0, screenWidth, screenHeight, SDL_WINDOW_SHOWN);
+                if(sdlWindow != nullptr)
+                    this->sdlRend = SDL_CreateRenderer(sdlWindow, -1, SDL_RENDERER_ACCELERATED);
+            }
+            if(sdlRend != nullptr)
+            {
+                // Everything is OK
+                SDL_SetRenderDrawBlendMode(sdlRend, SDL_BLENDMODE_BLEND);
+                SDL_SetRenderDrawColor(sdlRend, 0, 0, 0, 255);
+                SDL_RenderClear(sdlRend);
 
+                if(sdlWindow != nullptr)
                     SDL_SetWindowResizable(this->sdlWindow, SDL_FALSE);
-                    return;
-                }
+                SDL_AddEventWatch(watchEvent, this);
+                return;
             }
         }
         iError |= E_SDL;
     }
     Engine::~Engine()
     {
+        // Textures of the snapshot scene belong to the renderer
+        frameScene.reset();
+        if(frameTexture != nullptr)
+            SDL_DestroyTexture(frameTexture);
+        if(heatTexture != nullptr)
+            SDL_DestroyTexture(heatTexture);
+        if(minimapTexture != nullptr)
+            SDL_DestroyTexture(minimapTexture);
         if(walker != nullptr)
             delete walker;
         if(sdlWindow != nullptr)
             SDL_DestroyWindow(sdlWindow);
+        if(sdlSurface != nullptr)
+        {
+            // Renderer of a window goes away with it, the one of a surface does not
+            if(sdlRend != nullptr)
+                SDL_DestroyRenderer(sdlRend);
+            SDL_FreeSurface(sdlSurface);
+        }
         if(iError != E_SDL) {
-            SDL_QuitSubSystem(SDL_INIT_VIDEO);
+            SDL_DelEventWatch(watchEvent, this);
+            SDL_QuitSubSystem(sdlSurface != nullptr ? SDL_INIT_EVENTS : SDL_INIT_VIDEO);
             SDL_Quit();
         }
     }
@@ -92,20 +246,40 @@ namespace rpge
     void Engine::setColumnsPerRay(int n)
     {
         iColumnsPerRay = clamp(n, 1, rRenderArea.w);
+        governor.reset(iColumnsPerRay);
     }
     void Engine::setFrameRate(int fps)
     {
         iFramesPerSecond = fps < 1 ? 1 : fps;
+        pacer.setFrameRate(iFramesPerSecond);
     }
     void Engine::setLightBehavior(bool enabled, float angle)
     {
         bLightEnabled = enabled;
         vLightDir = (Vector2::RIGHT).rotate(angle);
     }
+    void Engine::setOpacityThreshold(float threshold)
+    {
+        fOpacityThreshold = clamp(threshold, 0.0f, 1.0f);
+    }
     void Engine::setMainCamera(const Camera* camera)
     {
         mainCamera = camera;
     }
+    void Engine::setSimulation(Simulation* simulation)
+    {
+        // Snapshot scene is not viewed by anything after going back to serial frames
+        if(this->simulation == nullptr && simulation != nullptr)
+            serialScene = walker->getTargetScene();
+        else if(this->simulation != nullptr && simulation == nullptr)
+        {
+            walker->setTargetScene(serialScene);
+            frameScene.reset();
+        }
+        this->simulation = simulation;
+        fSnapshotLatency = 0;
+        fMeanSnapshotLatency = 0;
+    }
     void Engine::setClearArea(const SDL_Rect& rect)
     {
         rClearArea.w = clamp(rect.w, 0, rRenderArea.w);
@@ -125,10 +299,39 @@ namespace rpge
     {
         iRowsInterval = clamp(n, 1, rRenderArea.h);
     }
+    void Engine::setRenderBackend(RenderBackend backend)
+    {
+        this->backend = backend;
+    }
+    void Engine::setRenderMode(RenderMode mode)
+    {
+        this->renderMode = mode;
+    }
+    void Engine::setSpanCoherence(bool enabled)
+    {
+        bSpanCoherence = enabled;
+    }
+    void Engine::setResolutionGovernor(bool enabled)
+    {
+        governor.reset(iColumnsPerRay);
+        governor.setEnabled(enabled);
+    }
     void Engine::render()
     {
         bRedraw = true;
     }
+    int Engine::getColumnsPerRay() const
+    {
+        return governor.isEnabled() ? clamp(governor.getColumnsPerRay(), 1, rRenderArea.w) : iColumnsPerRay;
+    }
+    int Engine::getRowsInterval() const
+    {
+        return iRowsInterval;
+    }
+    int Engine::getCoherentColumns() const
+    {
+        return iCoherentColumns;
+    }
     int Engine::getError() const
     {
         return iError;
@@ -153,13 +356,142 @@ namespace rpge
     {
         return rRenderArea;
     }
+    Framebuffer* Engine::getFramebuffer()
+    {
+        return &framebuffer;
+    }
+    FrameArena* Engine::getFrameArena()
+    {
+        return &frameArena;
+    }
+    uint64_t Engine::getFrameAllocations() const
+    {
+        return frameAllocations;
+    }
+    FramePacer* Engine::getPacer()
+    {
+        return &pacer;
+    }
     SDL_Renderer* Engine::getRendererHandle()
     {
         return sdlRend;
     }
+    float Engine::getAverageInputLatency() const
+    {
+        return fMeanInputLatency;
+    }
+    const InputEvent& Engine::getInputEvent(int i) const
+    {
+        return frameInputs.at(i);
+    }
+    int Engine::getInputEventCount() const
+    {
+        return frameInputs.size();
+    }
+    float Engine::getInputLatency() const
+    {
+        return fInputLatency;
+    }
+    float Engine::getSnapshotLatency() const
+    {
+        return fSnapshotLatency;
+    }
+    float Engine::getAverageSnapshotLatency() const
+    {
+        return fMeanSnapshotLatency;
+    }
     KeyState Engine::getKeyState(int sc) const
     {
-        return keyStates.count(sc) == 0 ? KeyState::NONE : keyStates.at(sc);
+        return (sc < 0 || sc >= SDL_NUM_SCANCODES) ? KeyState::NONE : keyStates[sc];
+    }
+    void Engine::markKeyDirty(int sc)
+    {
+        if(keyFlags[sc] & KF_DIRTY)
+            return;
+        keyFlags[sc] |= KF_DIRTY;
+        dirtyKeys[dirtyCount++] = sc;
+    }
+    void Engine::processInput(const InputEvent& event)
+    {
+        int sc = event.code;
+        if((event.type != IE_KEY_DOWN && event.type != IE_KEY_UP) || sc < 0 || sc >= SDL_NUM_SCANCODES)
+            return;
+
+        if(event.type == IE_KEY_DOWN)
+        {
+            if(keyStates[sc] == KeyState::NONE || keyStates[sc] == KeyState::UP)
+            {
+                keyStates[sc] = KeyState::DOWN;
+                markKeyDirty(sc);
+            }
+            keyFlags[sc] &= ~KF_UP_PENDING;
+        }
+        else if(keyStates[sc] == KeyState::DOWN)
+        {
+            // Key got released before its DOWN state was seen for a whole frame, release it in the next one
+            keyFlags[sc] |= KF_UP_PENDING;
+        }
+        else if(keyStates[sc] == KeyState::PRESS)
+        {
+            keyStates[sc] = KeyState::UP;
+            markKeyDirty(sc);
+        }
+    }
+    int Engine::watchEvent(void* userdata, SDL_Event* event)
+    {
+        Engine* engine = (Engine*)userdata;
+
+        // SDL timestamps are in milliseconds of its own clock, move them to the steady clock
+        Uint32 timestamp = event->common.timestamp;
+        Uint32 ticks     = SDL_GetTicks();
+        time_point<steady_clock> time = steady_clock::now();
+        if(ticks >= timestamp)
+            time -= std::chrono::milliseconds(ticks - timestamp);
+
+        InputEvent input;
+        switch(event->type)
+        {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+                if(event->key.repeat)
+                    return 1;
+                input = InputEvent(event->type == SDL_KEYDOWN ? IE_KEY_DOWN : IE_KEY_UP, event->key.keysym.scancode, time);
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+                input = InputEvent(event->type == SDL_MOUSEBUTTONDOWN ? IE_MOUSE_DOWN : IE_MOUSE_UP, event->button.button, time);
+                input.position = Vector2(event->button.x, event->button.y);
+                break;
+            case SDL_MOUSEMOTION:
+                input = InputEvent(IE_MOUSE_MOTION, 0, time);
+                input.position = Vector2(event->motion.x, event->motion.y);
+                input.motion   = Vector2(event->motion.xrel, event->motion.yrel);
+                break;
+            default:
+                return 1;
+        }
+        engine->inputQueue.push(input);
+        return 1;
+    }
+    CostOverlay* Engine::getOverlay()
+    {
+        return &overlay;
+    }
+    float Engine::getOpacityThreshold() const
+    {
+        return fOpacityThreshold;
+    }
+    PostProcessor* Engine::getPostProcessor()
+    {
+        return &postProcessor;
+    }
+    RenderBackend Engine::getRenderBackend() const
+    {
+        return frameBackend;
+    }
+    RenderMode Engine::getRenderMode() const
+    {
+        return renderMode;
     }
     Vector2 Engine::getMousePosition() const
     {
@@ -167,6 +499,47 @@ namespace rpge
         SDL_GetMouseState(&x, &y);
         return Vector2(x, y);
     }
+    int Engine::getSampleRay(int x) const
+    {
+        if(x < rSampleArea.x || x >= rSampleArea.x + rSampleArea.w)
+            return -1;
+        int ray = (x - rSampleArea.x) / iSampleColumnsPerRay;
+        return ray < (int)columnSamples.size() ? ray : -1;
+    }
+    ColumnSample Engine::getColumnSample(int x) const
+    {
+        int ray = getSampleRay(x);
+        return ray < 0 ? ColumnSample() : columnSamples[ray];
+    }
+    ColumnSample Engine::getColumnSpan(int x, int i) const
+    {
+        int ray = getSampleRay(x);
+        if(ray < 0 || i < 0 || i >= spanOffsets[ray + 1] - spanOffsets[ray])
+            return ColumnSample();
+        return spanSamples.at(spanOffsets[ray] + i);
+    }
+    int Engine::getColumnSpanCount(int x) const
+    {
+        int ray = getSampleRay(x);
+        return ray < 0 ? 0 : spanOffsets[ray + 1] - spanOffsets[ray];
+    }
+    ColumnSample Engine::pick(const Vector2& screenPos) const
+    {
+        int ray = getSampleRay(screenPos.x);
+        if(ray < 0)
+            return ColumnSample();
+
+        // Lines are kept from the nearest one, so the first covering the row is the one seen there
+        int y = floorf(screenPos.y);
+        for(int i = spanOffsets[ray]; i < spanOffsets[ray + 1]; i++)
+            if(y >= spanSamples.at(i).drawStart && y < spanSamples.at(i).drawEnd)
+                return spanSamples.at(i);
+        return ColumnSample();
+    }
+    FrameGovernor* Engine::getGovernor()
+    {
+        return &governor;
+    }
     DDA* Engine::getWalker()
     {
         return walker;
@@ -175,6 +548,829 @@ namespace rpge
     {
         return sdlWindow;
     }
+    bool Engine::isHeadless() const
+    {
+        return sdlSurface != nullptr;
+    }
+    bool Engine::readFrame(uint32_t* pixels) const
+    {
+        return SDL_RenderReadPixels(sdlRend, NULL, SDL_PIXELFORMAT_ARGB8888, pixels, iScreenWidth * sizeof(uint32_t)) == 0;
+    }
+    template<bool Textured, bool Lit, bool SingleColumn, bool Software>
+    void Engine::drawSpan(const ColumnSpan& span, int lineStart, int lineEnd)
+    {
+        if(Software)
+        {
+            // Framebuffer covers just the render area, so the span is cut to it
+            int top    = lineStart > rRenderArea.y ? lineStart : rRenderArea.y;
+            int bottom = lineEnd < rRenderArea.y + rRenderArea.h ? lineEnd : rRenderArea.y + rRenderArea.h;
+            int left   = span.column - rRenderArea.x;
+            int width  = SingleColumn ? 1 : (left + span.width < rRenderArea.w ? span.width : rRenderArea.w - left);
+
+            uint32_t source = enColor(span.color.r, span.color.g, span.color.b, span.color.a);
+            int alpha       = span.color.a;
+            int texColumn   = Textured ? clamp((int)(span.texWidth * span.texX), 0, span.texWidth - 1) : 0;
+            float texStep   = Textured ? span.texHeight / (float)(span.drawEnd - span.drawStart) : 0;
+            const int step  = framebuffer.getDrawStep();
+            // Texel and shade are computed once for every block of rows, blocks lie on the rows interval grid
+            const int interval = frameView.rowsInterval;
+            const int firstEnd = top + interval - (top - rRenderArea.y) % interval;
+            for(int c = 0; c < width; c++)
+            {
+                // Column goes down the draw buffer, which is contiguous in the column-major layout
+                uint32_t* pixel = framebuffer.getDrawColumn(left + c) + (top - rRenderArea.y) * step;
+                for(int y = top, blockEnd = firstEnd; y < bottom; blockEnd += interval)
+                {
+                    if(Textured)
+                    {
+                        // Texture row is sampled at the pixel center
+                        int texRow = clamp((int)((y + 0.5f - span.drawStart) * texStep), 0, span.texHeight - 1);
+                        // Indexed texels get final colors from the colormap row, which has shaded them already
+                        source = span.indices != nullptr ? span.colors[span.indices[texRow * span.texPitch + texColumn]]
+                                                         : span.texels[texRow * span.texPitch + texColumn];
+                        alpha  = source >> 24;
+                    }
+                    int end = blockEnd < bottom ? blockEnd : bottom;
+                    if(alpha == 255)
+                    {
+                        uint32_t color = Lit ? shadePixel(source, span.shade) : source;
+                        for(; y < end; y++, pixel += step)
+                            *pixel = color;
+                    }
+                    else
+                        for(; y < end; y++, pixel += step)
+                        {
+                            uint32_t color = blendPixel(*pixel, source, alpha);
+                            *pixel = Lit ? shadePixel(color, span.shade) : color;
+                        }
+                }
+            }
+            return;
+        }
+
+        SDL_Rect rendRect = { span.column, lineStart, SingleColumn ? 1 : span.width, lineEnd - lineStart };
+        if(Textured)
+        {
+            // Draw part of a texture
+            float offset   = (rendRect.y - span.drawStart);
+            float length   = rendRect.h;
+
+            // THIS BLOCK REMOVES PARTIAL PIXELS = FIXES WRONG PIXELS STRETCH
+            if(lineStart == span.drawStart)
+                rendRect.h = floorf(rendRect.h / span.texelHeight) * span.texelHeight;
+            else if(lineEnd == span.drawEnd)
+            {
+                float dist = rendRect.y - span.drawStart;
+                dist = ceilf(dist / span.texelHeight) * span.texelHeight;
+                rendRect.y = span.drawStart + dist;
+                rendRect.h = floorf(rendRect.h / span.texelHeight) * span.texelHeight;
+            }
+
+            offset /= (float)(span.drawEnd - span.drawStart);
+            length /= (float)(span.drawEnd - span.drawStart);
+
+            SDL_Rect texRect  = { span.texWidth * span.texX, span.texHeight * offset, 1, span.texHeight * length };
+
+            SDL_RenderCopy(sdlRend, span.texture, &texRect, &rendRect);
+        }
+        else
+        {
+            // Draw solid-color column
+            SDL_SetRenderDrawColor(sdlRend, span.color.r, span.color.g, span.color.b, span.color.a);
+            SDL_RenderFillRect(sdlRend, &rendRect);
+        }
+        if(Lit)
+        {
+            // Shade the drawn column by drawing black color with appropriate opacity over it
+            SDL_SetRenderDrawColor(sdlRend, 0, 0, 0, span.shade);
+            SDL_RenderFillRect(sdlRend, &rendRect);
+        }
+    }
+    template<bool Textured, bool Lit, bool Excluded, bool SingleColumn, bool Software>
+    void Engine::drawColumn(const ColumnSpan& span, const FrameList<pair<int, int>>& drawExcls)
+    {
+        if(!Excluded)
+        {
+            drawSpan<Textured, Lit, SingleColumn, Software>(span, span.drawStart, span.drawEnd);
+            return;
+        }
+
+        // Draw parts of the line which are not covered by exclusions
+        bool beg = false;
+        int exclCount = drawExcls.size();
+        int lineStart = span.drawStart;
+        int lineEnd   = span.drawEnd;
+        int e = 0;
+
+        pair<int, int> ex;
+        while(true)
+        {
+            if(e != exclCount)
+            {
+                ex = drawExcls.at(e);
+                if(ex.second > span.drawStart)
+                {
+                    if(beg || span.drawStart > ex.first)
+                    {
+                        lineStart = ex.second;
+                        if(++e != exclCount)
+                            ex = drawExcls.at(e);
+                    }
+                    lineEnd = (e == exclCount || span.drawEnd <= ex.first) ? span.drawEnd : ex.first;
+                    beg = true;
+                    if(lineStart > lineEnd)
+                        break;
+                }
+                else
+                {
+                    e++;
+                    continue;
+                }
+            }
+
+            // Draw drawable part of the line drawing range if possible
+            drawSpan<Textured, Lit, SingleColumn, Software>(span, lineStart, lineEnd);
+
+            if(e == exclCount || lineEnd == span.drawEnd || ex.second >= span.drawEnd)
+                break;
+        }
+    }
+    bool Engine::drawWallLine(const WallData& wall, const Vector2& rayDir, int column, float perpDist, float u,
+                              FrameList<pair<int, int>>& drawExcls, ColumnSpan& span)
+    {
+        Scene* scene = walker->getTargetScene();
+
+        // Wall is seen from its back when the ray goes along the normal, it is textured backwards then
+        bool flipped = rayDir.dot(wall.normal) > 0;
+
+        // Find out range describing how column should be drawn for the current wall
+        int drawStart, drawEnd;
+        getLineRange(wall, perpDist, drawStart, drawEnd);
+
+        // Describe the wall column for the kernel
+        span.column    = column;
+        span.width     = frameView.columnsPerRay;
+        span.drawStart = drawStart;
+        span.drawEnd   = drawEnd;
+        span.texture   = scene->getTextureSource(wall.texId);
+        span.texels    = nullptr;
+        span.indices   = nullptr;
+        deColor(wall.tint, span.color.r, span.color.g, span.color.b, span.color.a);
+        SDL_Surface* surface = span.texture != nullptr ? scene->getTextureSurface(wall.texId) : nullptr;
+        if(span.texture != nullptr && (frameView.kernel & CK_SOFTWARE))
+        {
+            // Software mode reads pixels kept by the scene, walls whose texture has none are drawn with their color
+            span.texture = surface != nullptr ? span.texture : nullptr;
+            if(surface != nullptr)
+            {
+                bool indexed   = surface->format->format == SDL_PIXELFORMAT_INDEX8;
+                span.texels    = indexed ? nullptr : (const uint32_t*)surface->pixels;
+                span.indices   = indexed ? (const uint8_t*)surface->pixels : nullptr;
+                span.texPitch  = indexed ? surface->pitch : surface->pitch / sizeof(uint32_t);
+                span.texWidth  = surface->w;
+                span.texHeight = surface->h;
+            }
+        }
+        else if(span.texture != nullptr)
+            SDL_QueryTexture(span.texture, NULL, NULL, &span.texWidth, &span.texHeight);
+        if(span.texture != nullptr)
+        {
+            // Normalized horizontal position on the wall plane
+            span.texX = flipped ? 1 - u : u;
+            // Texture pixel height in screen pixels
+            span.texelHeight = (drawEnd - drawStart) / (float)span.texHeight;
+        }
+        if(bLightEnabled)
+        {
+            // Normal of the side facing the camera
+            Vector2 normal = wall.normal * (flipped ? -1 : 1);
+            span.shade = (normal.dot(vLightDir) + 1.0f) / 2.0f * 128;
+        }
+        if(frameView.colormap != nullptr)
+        {
+            // Colormap shades and fogs the wall instead of the kernel, indexed texels through the row of its levels and
+            // solid color right away
+            int shadeLevel = bLightEnabled ? Colormap::getShadeLevel(span.shade) : 0;
+            int fogLevel   = frameView.colormap->getFogLevel(perpDist);
+            if(span.indices != nullptr)
+                span.colors = frameView.colormap->getRow(shadeLevel, fogLevel);
+            else if(span.texture == nullptr)
+                deColor(frameView.colormap->apply(wall.tint, shadeLevel, fogLevel), span.color.r, span.color.g, span.color.b,
+                        span.color.a);
+        }
+
+        // Opaque lines are drawn right away and hide everything behind them, translucent ones wait for the farther walls
+        // to be drawn first; the kernel has only the needed features
+        int kernel = frameView.kernel | (span.texture != nullptr ? CK_TEXTURED : 0);
+        bool opaque = span.texture != nullptr ? scene->isTextureOpaque(wall.texId) : span.color.a == 255;
+        if(opaque)
+        {
+            kernel |= drawExcls.size() != 0 ? CK_EXCLUDED : 0;
+            (this->*COLUMN_KERNELS[kernel])(span, drawExcls);
+            exclude(drawExcls, drawStart, drawEnd);
+        }
+        else if(!deferLine(span, kernel, span.texture != nullptr ? surface : nullptr, drawExcls))
+            return true;
+        return isColumnOccluded(drawExcls);
+    }
+    bool Engine::deferLine(const ColumnSpan& span, int kernel, const SDL_Surface* surface, FrameList<pair<int, int>>& drawExcls)
+    {
+        // Column has too many translucent lines, walls behind them are given up
+        int layer = translucentLayers.size();
+        if(layer == TRANSLUCENT_LAYERS)
+            return false;
+
+        // Line is drawn later, exclusions it has to respect are the ones present now
+        FrameList<pair<int, int>>& exclusions = layerExclusions[layer];
+        exclusions.clear();
+        for(const pair<int, int>& ex : drawExcls)
+            exclusions.push_back(ex);
+        translucentLayers.push_back({ span, kernel | (exclusions.size() != 0 ? CK_EXCLUDED : 0) });
+
+        // Opacity of the line is taken from its texture pixels (or color) for every block of rows, walls behind it are
+        // hidden where little enough of them would be seen
+        int top    = span.drawStart > rRenderArea.y ? span.drawStart : rRenderArea.y;
+        int bottom = span.drawEnd < rRenderArea.y + rRenderArea.h ? span.drawEnd : rRenderArea.y + rRenderArea.h;
+        if(top >= bottom)
+            return true;
+        const float seenLimit = 1 - fOpacityThreshold;
+        bool indexed  = surface != nullptr && surface->format->format == SDL_PIXELFORMAT_INDEX8;
+        int texColumn = surface != nullptr ? clamp((int)(surface->w * span.texX), 0, surface->w - 1) : 0;
+        float texStep = surface != nullptr ? surface->h / (float)(span.drawEnd - span.drawStart) : 0;
+        float opacity = span.color.a / 255.0f;
+        int hiddenStart = -1;
+        for(int y = top; y < bottom; y += frameView.rowsInterval)
+        {
+            if(surface != nullptr)
+            {
+                // Texture row is sampled at the pixel center, like the software kernels do
+                int texRow = clamp((int)((y + 0.5f - span.drawStart) * texStep), 0, surface->h - 1);
+                const uint8_t* row = (const uint8_t*)surface->pixels + texRow * surface->pitch;
+                opacity = indexed ? (row[texColumn] == Palette::TRANSPARENT_INDEX ? 0 : 1)
+                                  : (((const uint32_t*)row)[texColumn] >> 24) / 255.0f;
+            }
+            float& seen = transmittance[y - rRenderArea.y];
+            bool hides = seen > seenLimit && seen * (1 - opacity) <= seenLimit;
+            seen *= 1 - opacity;
+
+            // Rows which got hidden by this line are excluded in runs
+            if(hides && hiddenStart < 0)
+                hiddenStart = y;
+            else if(!hides && hiddenStart >= 0)
+            {
+                exclude(drawExcls, hiddenStart, y);
+                hiddenStart = -1;
+            }
+        }
+        if(hiddenStart >= 0)
+            exclude(drawExcls, hiddenStart, bottom);
+        return true;
+    }
+    void Engine::drawTranslucentLines()
+    {
+        // Lines are blended from the farthest one, so each of them goes over the walls behind it
+        for(int i = translucentLayers.size() - 1; i >= 0; i--)
+        {
+            const TranslucentLayer& layer = translucentLayers.at(i);
+            (this->*COLUMN_KERNELS[layer.kernel])(layer.span, layerExclusions[i]);
+
+            int top    = layer.span.drawStart > rRenderArea.y ? layer.span.drawStart : rRenderArea.y;
+            int bottom = layer.span.drawEnd < rRenderArea.y + rRenderArea.h ? layer.span.drawEnd
+                                                                             : rRenderArea.y + rRenderArea.h;
+            for(int y = top; y < bottom; y++)
+                transmittance[y - rRenderArea.y] = 1;
+        }
+        translucentLayers.clear();
+    }
+    void Engine::exclude(FrameList<pair<int, int>>& drawExcls, int start, int end)
+    {
+        // Prepare exclusions vector for the new exclusion, every range in that vector must stay separated from each other.
+        int exclCount = drawExcls.size();
+        int varStart = start;
+        int varEnd   = end;
+        int e = -1;
+        while(++e < exclCount)
+        {
+            pair<int, int>& ex = drawExcls.at(e);
+
+            if(ex.first <= varEnd && ex.second >= varStart)
+            {
+                varStart = ex.first  < varStart ? ex.first  : varStart;
+                varEnd   = ex.second > varEnd   ? ex.second : varEnd  ;
+                drawExcls.erase(e);
+                exclCount--;
+                e = -1;
+            }
+        }
+        // Add the range as new exclusion, perform it in such way that will remain the vector sorted ascendingly by start
+        // coordinate.
+        int t = exclCount;
+        for(int e = 0; e < exclCount; e++)
+            if(varStart <= drawExcls.at(e).first)
+            {
+                t = e;
+                break;
+            }
+        drawExcls.insert(t, make_pair(varStart, varEnd));
+    }
+    bool Engine::isColumnOccluded(const FrameList<pair<int, int>>& drawExcls) const
+    {
+        // Exclusions never touch each other, so the whole column can only be covered by a single one
+        return drawExcls.size() != 0 && drawExcls.at(0).first <= rRenderArea.y
+               && drawExcls.at(0).second >= rRenderArea.y + rRenderArea.h;
+    }
+    void Engine::getLineRange(const WallData& wall, float perpDist, int& drawStart, int& drawEnd) const
+    {
+        // Both ends are snapped down to the grid of rows interval so every drawn row block is exactly `rowsInterval`
+        // pixels high
+        float lineHeight = rRenderArea.h * (frameView.pcmDist / perpDist);
+        float lineTop    = (rRenderArea.h - lineHeight) / 2 + lineHeight * (1 - wall.hMax);
+        float lineBottom = (rRenderArea.h + lineHeight) / 2 - lineHeight * wall.hMin;
+        drawStart = rRenderArea.y + floorf(lineTop / frameView.rowsInterval) * frameView.rowsInterval;
+        drawEnd   = rRenderArea.y + floorf(lineBottom / frameView.rowsInterval) * frameView.rowsInterval;
+    }
+    void Engine::drawOverlay(int rayCount)
+    {
+        // Overlay is a diagnostic, so a part of it SDL fails to draw is turned off instead of stopping the engine
+        FrameArena::Marker overlayMark = frameArena.mark();
+        if(overlay.isHeatmapEnabled())
+        {
+            // Every ray covers its columns, the last one may cover less of them
+            uint32_t* pixels = frameArena.allocate<uint32_t>(rayCount);
+            overlay.fillHeatmap(pixels);
+            int fullRays = rRenderArea.w / frameView.columnsPerRay;
+            SDL_Rect fullSource  = { 0, 0, fullRays, 1 };
+            SDL_Rect fullTarget  = { rRenderArea.x, rRenderArea.y, fullRays * frameView.columnsPerRay, rRenderArea.h };
+            SDL_Rect lastSource  = { fullRays, 0, 1, 1 };
+            SDL_Rect lastTarget  = { fullTarget.x + fullTarget.w, rRenderArea.y, rRenderArea.w - fullTarget.w, rRenderArea.h };
+            if(!fitTexture(heatTexture, rayCount, 1) || SDL_SetTextureBlendMode(heatTexture, SDL_BLENDMODE_BLEND) != 0
+               || SDL_UpdateTexture(heatTexture, NULL, pixels, rayCount * sizeof(uint32_t)) != 0
+               || (fullRays > 0 && SDL_RenderCopy(sdlRend, heatTexture, &fullSource, &fullTarget) != 0)
+               || (lastTarget.w > 0 && SDL_RenderCopy(sdlRend, heatTexture, &lastSource, &lastTarget) != 0))
+                overlay.setHeatmap(false, overlay.getMetric(), overlay.getOpacity());
+        }
+        const Scene* scene = walker->getTargetScene();
+        if(overlay.isMinimapEnabled() && scene->getWidth() > 0 && scene->getHeight() > 0)
+        {
+            // Minimap has at most `CostOverlay::MINIMAP_SIZE` pixels a side whatever the scene size, which of them show
+            // walls is found again only when the scene changes
+            int width, height;
+            overlay.getMinimapSize(width, height);
+            overlay.findMinimapWalls(*scene);
+            uint32_t* pixels = frameArena.allocate<uint32_t>(width * height);
+            overlay.fillMinimap(pixels);
+            SDL_Rect area = overlay.getMinimapArea();
+            if(!fitTexture(minimapTexture, width, height) || SDL_SetTextureBlendMode(minimapTexture, SDL_BLENDMODE_BLEND) != 0
+               || SDL_UpdateTexture(minimapTexture, NULL, pixels, width * sizeof(uint32_t)) != 0
+               || SDL_RenderCopy(sdlRend, minimapTexture, NULL, &area) != 0)
+                overlay.setMinimap(false, area);
+            else
+            {
+                // Camera is marked with a white square, the scene's y axis goes up the screen
+                SDL_Rect camera = {
+                    area.x + (int)(frameView.position.x / scene->getWidth() * area.w) - 1,
+                    area.y + (int)((scene->getHeight() - frameView.position.y) / scene->getHeight() * area.h) - 1,
+                    3, 3
+                };
+                SDL_SetRenderDrawColor(sdlRend, 255, 255, 255, 255);
+                SDL_RenderFillRect(sdlRend, &camera);
+            }
+        }
+        frameArena.rewind(overlayMark);
+    }
+    bool Engine::fitTexture(SDL_Texture*& texture, int width, int height)
+    {
+        int texWidth = 0, texHeight = 0;
+        if(texture != nullptr)
+            SDL_QueryTexture(texture, NULL, NULL, &texWidth, &texHeight);
+        if(texWidth != width || texHeight != height)
+        {
+            if(texture != nullptr)
+                SDL_DestroyTexture(texture);
+            texture = SDL_CreateTexture(sdlRend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+        }
+        return texture != nullptr;
+    }
+    void Engine::keepColumnCost(int ray, int steps, int wallTests, int lines, const time_point<steady_clock>& start)
+    {
+        if(!overlay.isHeatmapEnabled())
+            return;
+        switch(overlay.getMetric())
+        {
+            case CM_RAY_STEPS:
+                overlay.setRayCost(ray, steps);
+                break;
+            case CM_WALL_TESTS:
+                overlay.setRayCost(ray, wallTests);
+                break;
+            case CM_LINES:
+                overlay.setRayCost(ray, lines);
+                break;
+            default:
+                overlay.setRayCost(ray, duration<float, std::nano>(steady_clock::now() - start).count());
+                break;
+        }
+    }
+    void Engine::fillDepths()
+    {
+        const int width  = framebuffer.getWidth();
+        const int height = framebuffer.getHeight();
+        const int step   = framebuffer.getDrawStep();
+
+        // Lines of a ray are kept from the nearest one, going backwards leaves depth of the nearest line in every pixel
+        for(int x = 0; x < width; x++)
+        {
+            float* depth = framebuffer.getDrawDepthColumn(x);
+            for(int y = 0; y < height; y++)
+                depth[y * step] = INFINITY;
+
+            int ray = x / iSampleColumnsPerRay;
+            for(int i = spanOffsets[ray + 1] - 1; i >= spanOffsets[ray]; i--)
+            {
+                const ColumnSample& sample = spanSamples.at(i);
+                int top    = sample.drawStart - rSampleArea.y;
+                int bottom = sample.drawEnd - rSampleArea.y;
+                top    = top > 0 ? top : 0;
+                bottom = bottom < height ? bottom : height;
+                for(int y = top; y < bottom; y++)
+                    depth[y * step] = sample.depth;
+            }
+        }
+    }
+    void Engine::startSamples(int ray)
+    {
+        columnSamples[ray] = ColumnSample();
+        spanOffsets[ray] = spanSamples.size();
+    }
+    void Engine::keepSample(int ray, const Vector2& rayDir, const Vector2& tile, int tileId, const WallData& wall, int wallIndex,
+                            float perpDist, float u)
+    {
+        // Frame drawing more lines than its storage was reserved for moves them to a twice bigger one, the arena keeps
+        // room for it in the next frames
+        if(spanSamples.size() == spanSamples.getCapacity())
+        {
+            FrameList<ColumnSample> grown(sampleArena, 2 * spanSamples.getCapacity());
+            for(const ColumnSample& kept : spanSamples)
+                grown.push_back(kept);
+            spanSamples = grown;
+        }
+
+        ColumnSample sample;
+        sample.hit       = true;
+        sample.tileId    = tileId;
+        sample.wallIndex = wallIndex;
+        sample.depth     = perpDist;
+        sample.u         = u;
+        sample.tile      = tile;
+        sample.point     = frameView.position + rayDir * (perpDist / rayDir.dot(frameView.direction));
+        getLineRange(wall, perpDist, sample.drawStart, sample.drawEnd);
+
+        if(!columnSamples[ray].hit)
+            columnSamples[ray] = sample;
+        spanSamples.push_back(sample);
+        if(overlay.isMinimapEnabled())
+            overlay.countTileHit(tile.x, tile.y);
+    }
+    #ifdef DEBUG
+    void Engine::drawExclusions(int column, const FrameList<pair<int, int>>& drawExcls)
+    {
+        for(const pair<int, int>& excl : drawExcls)
+        {
+            SDL_SetRenderDrawColor(sdlRend, 0, 255, 0, 255);
+            SDL_RenderDrawPoint(sdlRend, column, excl.first);
+            SDL_SetRenderDrawColor(sdlRend, 255, 0, 0, 255);
+            SDL_RenderDrawPoint(sdlRend, column, excl.second + 1);
+        }
+    }
+    #endif
+    template<typename Visit>
+    bool Engine::visitTiles(const Vector2 tri[3], Visit visit)
+    {
+        // Part of the triangle inside a row of tiles is spanned by the parts of its edges inside that row
+        float yMin = fminf(tri[0].y, fminf(tri[1].y, tri[2].y));
+        float yMax = fmaxf(tri[0].y, fmaxf(tri[1].y, tri[2].y));
+        for(int y = floorf(yMin); y <= (int)floorf(yMax); y++)
+        {
+            float xMin = INFINITY, xMax = -INFINITY;
+            for(int e = 0; e < 3; e++)
+            {
+                const Vector2& p = tri[e];
+                const Vector2& q = tri[(e + 1) % 3];
+                float t0 = 0, t1 = 1;
+                if(p.y != q.y)
+                {
+                    float ta = (y - p.y) / (q.y - p.y), tb = (y + 1 - p.y) / (q.y - p.y);
+                    t0 = fmaxf(0, fminf(ta, tb));
+                    t1 = fminf(1, fmaxf(ta, tb));
+                }
+                else if(p.y < y || p.y > y + 1)
+                    continue;
+                if(t0 > t1)
+                    continue;
+                float x0 = p.x + (q.x - p.x) * t0, x1 = p.x + (q.x - p.x) * t1;
+                xMin = fminf(xMin, fminf(x0, x1));
+                xMax = fmaxf(xMax, fmaxf(x0, x1));
+            }
+            for(int x = floorf(xMin); xMin <= xMax && x <= (int)floorf(xMax); x++)
+                if(visit(x, y))
+                    return true;
+        }
+        return false;
+    }
+    bool Engine::isWedgeBlocked(const Vector2& tile, int wall, const Vector2 wedge[3]) const
+    {
+        const Scene* scene = walker->getTargetScene();
+
+        // Orientation of point `p` relative to line going from `a` to `b`
+        auto side = [](const Vector2& a, const Vector2& b, const Vector2& p) {
+            return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+        };
+        // Whether closed segments `ab` and `cd` share any point
+        auto crosses = [&side](const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d) {
+            float sc = side(a, b, c), sd = side(a, b, d);
+            float sa = side(c, d, a), sb = side(c, d, b);
+            if(sc == 0 && sd == 0)
+            {
+                // Collinear segments, compare their extents along the line
+                Vector2 ab = b - a;
+                float tc = (c - a).dot(ab), td = (d - a).dot(ab);
+                return (tc < td ? td : tc) >= 0 && (tc < td ? tc : td) <= ab.dot(ab);
+            }
+            return sc * sd <= 0 && sa * sb <= 0;
+        };
+
+        // Every tile the wedge covers is checked
+        return visitTiles(wedge, [&](int x, int y) {
+            if(!scene->checkPosition(x, y))
+                return false;
+            const vector<WallData>* walls = scene->getTileWalls(scene->getTileId(x, y));
+            if(walls == nullptr)
+                return false;
+
+            Vector2 position(x, y);
+            for(int i = 0; i < (int)walls->size(); i++)
+            {
+                if(i == wall && position == tile)
+                    continue;
+                Vector2 a = position + walls->at(i).start;
+                Vector2 b = position + walls->at(i).end;
+
+                // Wall lying entirely inside the wedge has its start there, otherwise it crosses one of the edges
+                float s0 = side(wedge[0], wedge[1], a), s1 = side(wedge[1], wedge[2], a), s2 = side(wedge[2], wedge[0], a);
+                bool inside = !((s0 < 0 || s1 < 0 || s2 < 0) && (s0 > 0 || s1 > 0 || s2 > 0));
+                if(inside || crosses(a, b, wedge[0], wedge[1]) || crosses(a, b, wedge[1], wedge[2]) || crosses(a, b, wedge[2], wedge[0]))
+                    return true;
+            }
+            return false;
+        });
+    }
+    float Engine::estimateWallWork(RenderBackend backend, int rayCount) const
+    {
+        const Scene* scene = walker->getTargetScene();
+        float reach = fminf(walker->getMaxTileDistance(), fmaxf(scene->getWidth(), scene->getHeight()));
+        if(backend == RB_RAYCAST)
+        {
+            // Rays walk until a wall stops them, which takes about as many tiles as one of them is apart from another
+            float steps = fStopDensity * reach > 1 ? 1 / fStopDensity : reach;
+            return rayCount * steps * (1 + fWallDensity);
+        }
+
+        // Object order visits every tile of the frustum within the reach (a circular sector) and projects its walls,
+        // then resolves every ray
+        float halfAngle = atanf(frameView.plane.magnitude() / frameView.direction.magnitude());
+        float tiles = fminf(reach * reach * halfAngle, (float)scene->getWidth() * scene->getHeight());
+        return tiles * (1 + fWallDensity) + rayCount;
+    }
+    void Engine::sampleDensities(const Scene* scene)
+    {
+        // Up to 64 x 64 tiles evenly spread over the scene are enough for the averages
+        int strideX = scene->getWidth() / 64 > 1 ? scene->getWidth() / 64 : 1;
+        int strideY = scene->getHeight() / 64 > 1 ? scene->getHeight() / 64 : 1;
+        int tiles = 0, stopping = 0, walls = 0;
+        for(int y = 0; y < scene->getHeight(); y += strideY)
+            for(int x = 0; x < scene->getWidth(); x += strideX)
+            {
+                tiles++;
+                int tileId = scene->getTileId(x, y);
+                const vector<WallData>* tileWalls = tileId == 0 ? nullptr : scene->getTileWalls(tileId);
+                if(tileWalls == nullptr)
+                    continue;
+                walls += tileWalls->size();
+                for(const WallData& wall : *tileWalls)
+                    if(wall.stopsRay)
+                    {
+                        stopping++;
+                        break;
+                    }
+            }
+        fStopDensity      = tiles > 0 ? (float)stopping / tiles : 0;
+        fWallDensity      = tiles > 0 ? (float)walls / tiles : 0;
+        costGridRevision  = scene->getGridRevision();
+        costWallsRevision = scene->getWallsRevision();
+    }
+    void Engine::drawObjectOrder(const float* rayDirsX, const float* rayDirsY, int rayCount,
+                                 FrameList<pair<int, int>>& drawExcls, bool usePvs)
+    {
+        const Scene* scene = walker->getTargetScene();
+        const VisibilitySet* pvs = scene->getVisibilitySet();
+        const FrameView& view = frameView;
+        const float maxTileDist = walker->getMaxTileDistance();
+        const float nearDepth = 0.0001f;
+
+        // Gather tiles with walls in the view frustum, it is cut a bit past where rays stop walking; tiles count as too
+        // far the same way they do for rays, so there are no more of them than tiles within that distance
+        int reach = fminf(maxTileDist, fmaxf(scene->getWidth(), scene->getHeight()));
+        int tileBound = (2 * reach + 1) * (2 * reach + 1);
+        tileBound = tileBound < scene->getWidth() * scene->getHeight() ? tileBound : scene->getWidth() * scene->getHeight();
+        struct WallTile {
+            Vector2                 tile;
+            int                     tileId;
+            const vector<WallData>* walls;
+        };
+        FrameList<WallTile> wallTiles(frameArena, tileBound);
+        int wallBound = 0;
+        Vector2 frustum[3] = {
+            view.position,
+            view.position + (view.direction - view.plane) * (maxTileDist + 2),
+            view.position + (view.direction + view.plane) * (maxTileDist + 2)
+        };
+        visitTiles(frustum, [&](int x, int y) {
+            int deltaX = x - view.position.x;
+            int deltaY = y - view.position.y;
+            if(!scene->checkPosition(x, y) || deltaX * deltaX + deltaY * deltaY > maxTileDist * maxTileDist)
+                return false;
+            if(usePvs && !pvsVisible[pvs->getTileIndex(x, y)])
+                return false;
+            int tileId = scene->getTileId(x, y);
+            const vector<WallData>* walls = tileId == 0 ? nullptr : scene->getTileWalls(tileId);
+            if(walls != nullptr)
+            {
+                wallTiles.push_back({ Vector2(x, y), tileId, walls });
+                wallBound += walls->size();
+            }
+            return false;
+        });
+
+        // Walls of the gathered tiles become candidates when some of them is in front of the camera
+        FrameList<WallCandidate> wallCandidates(frameArena, wallBound);
+        for(const WallTile& wallTile : wallTiles)
+        {
+            const Vector2& tile = wallTile.tile;
+            const vector<WallData>* walls = wallTile.walls;
+            for(int w = 0; w < (int)walls->size(); w++)
+            {
+                const WallData& wall = walls->at(w);
+                // Project the part of the wall in front of the camera onto the camera plane
+                Vector2 relStart = tile + wall.start - view.position;
+                Vector2 relEnd   = tile + wall.end - view.position;
+                float depthStart = relStart.dot(view.direction), depthEnd = relEnd.dot(view.direction);
+                if(depthStart <= nearDepth && depthEnd <= nearDepth)
+                    continue;
+                if(depthStart < nearDepth)
+                {
+                    relStart = relStart + (relEnd - relStart) * ((nearDepth - depthStart) / (depthEnd - depthStart));
+                    depthStart = nearDepth;
+                }
+                else if(depthEnd < nearDepth)
+                {
+                    relEnd = relEnd + (relStart - relEnd) * ((nearDepth - depthEnd) / (depthStart - depthEnd));
+                    depthEnd = nearDepth;
+                }
+                float planeSq  = view.plane.dot(view.plane);
+                float cameraX0 = clamp(relStart.dot(view.plane) / planeSq / depthStart, -2.0f, 2.0f);
+                float cameraX1 = clamp(relEnd.dot(view.plane) / planeSq / depthEnd, -2.0f, 2.0f);
+
+                // Rays around the projected ends are included too, exact hits are decided later
+                float toRay = rRenderArea.w / (2.0f * view.columnsPerRay);
+                int firstRay = floorf((fminf(cameraX0, cameraX1) + 1) * toRay) - 1;
+                int lastRay  = ceilf((fmaxf(cameraX0, cameraX1) + 1) * toRay) + 1;
+                firstRay = firstRay < 0 ? 0 : firstRay;
+                lastRay  = lastRay < rayCount ? lastRay : rayCount - 1;
+                if(firstRay <= lastRay)
+                    wallCandidates.push_back({ &wall, w, wallTile.tileId, tile, firstRay, lastRay });
+            }
+        }
+
+        // Every ray gets space for all walls it may hit, then the hit ones are stored there
+        int* offsets = frameArena.allocate<int>(rayCount + 1);
+        int* counts  = frameArena.allocate<int>(rayCount);
+        for(int r = 0; r <= rayCount; r++)
+            offsets[r] = 0;
+        for(const WallCandidate& candidate : wallCandidates)
+            for(int r = candidate.firstRay; r <= candidate.lastRay; r++)
+                offsets[r + 1]++;
+        for(int r = 0; r < rayCount; r++)
+        {
+            offsets[r + 1] += offsets[r];
+            counts[r] = 0;
+        }
+        WallFragment* fragments = frameArena.allocate<WallFragment>(offsets[rayCount]);
+        for(const WallCandidate& candidate : wallCandidates)
+        {
+            Vector2 localPos = view.position - candidate.tile;
+            Vector2 center   = candidate.tile + Vector2(0.5f, 0.5f) - view.position;
+            for(int r = candidate.firstRay; r <= candidate.lastRay; r++)
+            {
+                Vector2 rayDir(rayDirsX[r], rayDirsY[r]);
+                float dist, u;
+                if(!candidate.wall->intersect(localPos, rayDir, dist, u))
+                    continue;
+                fragments[offsets[r] + counts[r]++] = { rayDir.dot(view.direction) * dist, u, center.dot(rayDir), &candidate };
+            }
+        }
+
+        // Draw walls of every column from the nearest one, like a ray walking through the tiles would; the overlay gets
+        // walls which could be hit by the ray as its tests
+        const bool recordCosts = overlay.isEnabled();
+        const bool timeColumns = overlay.isHeatmapEnabled() && overlay.getMetric() == CM_TIME;
+        for(int r = 0; r < rayCount; r++)
+        {
+            time_point<steady_clock> columnStart = timeColumns ? steady_clock::now() : time_point<steady_clock>();
+            WallFragment* columnFragments = fragments + offsets[r];
+            int count = counts[r];
+
+            // Walls of touching tiles can be hit at the same distance, the one of the tile entered first goes first then,
+            // and walls of one tile go in their order
+            for(int i = 1; i < count; i++)
+            {
+                WallFragment fragment = columnFragments[i];
+                int j = i - 1;
+                while(j >= 0)
+                {
+                    const WallFragment& other = columnFragments[j];
+                    bool sameDist = fabsf(other.perpDist - fragment.perpDist) <= 0.00001f * fragment.perpDist;
+                    if(sameDist ? (other.order < fragment.order || (other.order == fragment.order && other.candidate < fragment.candidate))
+                                : other.perpDist < fragment.perpDist)
+                        break;
+                    columnFragments[j + 1] = other;
+                    j--;
+                }
+                columnFragments[j + 1] = fragment;
+            }
+
+            int column = rRenderArea.x + r * view.columnsPerRay;
+            Vector2 rayDir(rayDirsX[r], rayDirsY[r]);
+            drawExcls.clear();
+            startSamples(r);
+            int lineCount = 0;
+            for(int i = 0; i < count; i++)
+            {
+                const WallFragment& fragment = columnFragments[i];
+                ColumnSpan span;
+                bool occluded = drawWallLine(*fragment.candidate->wall, rayDir, column, fragment.perpDist, fragment.u,
+                                             drawExcls, span);
+                lineCount++;
+                keepSample(r, rayDir, fragment.candidate->tile, fragment.candidate->tileId, *fragment.candidate->wall,
+                           fragment.candidate->wallIndex, fragment.perpDist, fragment.u);
+                if(fragment.candidate->wall->stopsRay || occluded)
+                    break;
+            }
+            drawTranslucentLines();
+            if(recordCosts)
+                keepColumnCost(r, 0, offsets[r + 1] - offsets[r], lineCount, columnStart);
+
+            #ifdef DEBUG
+
+            // Draw exclusion ranges
+            drawExclusions(column, drawExcls);
+
+            #endif
+        }
+    }
+    void Engine::drawRun(const ColumnSpan& span, const WallData& wall, const Vector2& tile, int xStart, int xEnd)
+    {
+        // Shade darkens the color the same way black drawn over it does
+        SDL_Color color = span.color;
+        if(bLightEnabled)
+        {
+            color.r = color.r * (255 - span.shade) / 255;
+            color.g = color.g * (255 - span.shade) / 255;
+            color.b = color.b * (255 - span.shade) / 255;
+        }
+
+        // Wall ends project to straight lines, so the run is a single quad. Its corners are taken half a pixel to the
+        // left and up, so pixel centers get what columns cast from their top-left corners would.
+        SDL_Vertex vertices[4];
+        float side = (tile + wall.start - frameView.position).dot(wall.normal);
+        for(int e = 0; e < 2; e++)
+        {
+            int x = e == 0 ? xStart : xEnd;
+            float cameraX = 2 * (x - 0.5f - rRenderArea.x) / rRenderArea.w - 1;
+            Vector2 ray = frameView.direction + frameView.plane * cameraX;
+
+            float perpDist   = side / ray.dot(wall.normal) * ray.dot(frameView.direction);
+            float lineHeight = rRenderArea.h * (frameView.pcmDist / perpDist);
+            float lineTop    = (rRenderArea.h - lineHeight) / 2 + lineHeight * (1 - wall.hMax);
+            float lineBottom = (rRenderArea.h + lineHeight) / 2 - lineHeight * wall.hMin;
+            vertices[2 * e]     = { { (float)x, rRenderArea.y + lineTop - 0.5f },    color, { 0, 0 } };
+            vertices[2 * e + 1] = { { (float)x, rRenderArea.y + lineBottom - 0.5f }, color, { 0, 0 } };
+        }
+        const int indices[6] = { 0, 1, 2, 1, 3, 2 };
+
+        // Renderers unable to draw geometry get every column cast again from the next frame on
+        if(SDL_RenderGeometry(sdlRend, NULL, vertices, 4, indices, 6) != 0)
+            bSpanCoherence = false;
+    }
     bool Engine::tick()
     {
         if(iError)
@@ -182,11 +1378,20 @@ namespace rpge
             stop();
             return bRun;
         }
+        RPGE_TRACE_SCOPE("frame");
 
-        // Compute the time duration elapsed since the last method call
-        time_point<system_clock> tpCurrent = system_clock::now();
+        // Compute the time duration elapsed since the last method call, the trace is dumped when the previous frame
+        // was a spike
+        time_point<steady_clock> tpCurrent = steady_clock::now();
         elapsedTime = tpCurrent - tpLast;
         tpLast = tpCurrent;
+        #ifdef RPGE_TRACING
+        Tracer::checkSpike(elapsedTime.count());
+        #endif
+        uint64_t allocations = getAllocationCount();
+
+        // Memory of the previous frame is no longer needed
+        frameArena.reset();
 
 
         /************************************/
@@ -196,38 +1401,69 @@ namespace rpge
         /************************************/
 
 
-        // Complete the key states
-        auto ksCopy = keyStates; // To avoid iteration through dynamicly-sized map
-        for(auto& p : ksCopy)
+        RPGE_TRACE_SPAN(inputSpan, "input");
+
+        // Complete states of the keys which changed in the previous frame, those still changing stay in the dirty list
+        int kept = 0;
+        for(int i = 0; i < dirtyCount; i++)
         {
-            if(p.second == KeyState::DOWN)
-                keyStates.at(p.first) = KeyState::PRESS;
-            else if(p.second == KeyState::UP)
-                keyStates.erase(p.first);
+            int sc = dirtyKeys[i];
+            if(keyStates[sc] == KeyState::DOWN)
+                keyStates[sc] = (keyFlags[sc] & KF_UP_PENDING) ? KeyState::UP : KeyState::PRESS;
+            else if(keyStates[sc] == KeyState::UP)
+                keyStates[sc] = KeyState::NONE;
+            keyFlags[sc] &= ~KF_UP_PENDING;
+
+            if(keyStates[sc] == KeyState::UP)
+                dirtyKeys[kept++] = sc;
+            else
+                keyFlags[sc] &= ~KF_DIRTY;
         }
+        dirtyCount = kept;
 
-        // Interpret SDL events
+        // Pump SDL events, input ones are captured by the event watch as they arrive; events which had to wait for room
+        // in the queue go in after them
         SDL_Event event;
         while(SDL_PollEvent(&event))
         {
-            int sc;
-            switch(event.type)
-            {
-                case SDL_QUIT:
-                    bRun = false;
-                    break;
-                case SDL_KEYDOWN:
-                    sc = event.key.keysym.scancode;
-                    if(keyStates.count(sc) == 0)
-                        keyStates.insert(pair<int, KeyState>(sc, KeyState::DOWN));
-                    break;
-                case SDL_KEYUP:
-                    sc = event.key.keysym.scancode;
-                    if(keyStates.count(sc) != 0)
-                        keyStates.at(sc) = KeyState::UP;
-                    break;
-            }
+            if(event.type == SDL_QUIT)
+                bRun = false;
         }
+        inputQueue.flush();
+
+        // Process input events in the order they happened, at most as many as the queue holds so it can not starve
+        // the frame when events keep coming
+        InputEvent input;
+        frameInputs.clear();
+        while((int)frameInputs.size() < InputQueue::CAPACITY && inputQueue.pop(input))
+        {
+            processInput(input);
+            frameInputs.push_back(input);
+        }
+
+        // Pipelined frames hand the input over to the simulation and draw its latest snapshot, which is a tick behind:
+        // camera goes from the previous tick to the snapshot one as the next tick approaches
+        const Camera* camera = mainCamera;
+        if(simulation != nullptr)
+        {
+            simulation->flushInput();
+            for(const InputEvent& handed : frameInputs)
+                simulation->pushInput(handed);
+            bFreshSnapshot = simulation->acquireSnapshot();
+            const SimulationSnapshot& snapshot = simulation->getSnapshot();
+            float progress = duration<float>(tpCurrent - snapshot.time).count() / simulation->getTickPeriod();
+            frameCamera = snapshot.previous.interpolate(snapshot.camera, clamp(progress, 0.0f, 1.0f));
+            camera = &frameCamera;
+
+            if(frameScene == nullptr)
+                frameScene = unique_ptr<Scene>(new Scene(sdlRend, snapshot.scene));
+            else
+                frameScene->setData(snapshot.scene);
+            if(frameScene->getVisibilitySet() != snapshot.visibility)
+                frameScene->setVisibilitySet(snapshot.visibility);
+            walker->setTargetScene(frameScene.get());
+        }
+        RPGE_TRACE_END(inputSpan);
 
 
         /********************************************/
@@ -236,40 +1472,178 @@ namespace rpge
         /********************************************/
         /********************************************/
 
+        RPGE_TRACE_SPAN(wallsSpan, "walls");
+
         // Perspective-correct minimum distance; if you stand this distance from the cube looking at it orthogonally,
         // entire vertical view of the camera should be occupied by the cube front wall. This assumes that camera is
         // located at height of 1/2.
-        const float pcmDist = 1 / (2 * tan(mainCamera->getFieldOfView() / 2));
-        Scene* mainScene = walker->getTargetScene();
-        Vector2 camDir   = mainCamera->getDirection();
-        Vector2 camPos   = mainCamera->getPosition();
-        Vector2 planeVec = mainCamera->getPlane();
+        const float pcmDist = 1 / (2 * tan(camera->getFieldOfView() / 2));
+        const int columnsPerRay = getColumnsPerRay();
+        const int rowsInterval  = getRowsInterval();
+        const Scene* mainScene = walker->getTargetScene();
+        Vector2 camDir   = camera->getDirection();
+        Vector2 camPos   = camera->getPosition();
+        Vector2 planeVec = camera->getPlane();
 
         // Linear function describing the camera plane, it is later used for computing distances to intersection points
         const float planeSlope = planeVec.y / planeVec.x;
         LinearFunc planeLine(planeSlope, camPos.y - planeSlope * camPos.x, 0, 1);
 
+        // Potentially visible set of the camera tile lets rays skip hidden tiles and stop past the farthest visible one
+        const VisibilitySet* pvs = mainScene->getVisibilitySet();
+        float pvsReach = -1;
+        if(pvs != nullptr && pvs->getWidth() == mainScene->getWidth() && pvs->getHeight() == mainScene->getHeight())
+        {
+            pvsReach = pvs->getReach(camPos.x, camPos.y);
+            int camTile = pvs->getTileIndex(camPos.x, camPos.y);
+            if(pvsReach >= 0 && (camTile != iPvsTile || pvs != pvsSource || pvs->getRevision() != iPvsRevision))
+            {
+                pvs->decode(camPos.x, camPos.y, pvsVisible);
+                iPvsTile     = camTile;
+                pvsSource    = pvs;
+                iPvsRevision = pvs->getRevision();
+            }
+        }
+
+        // Software mode draws into the framebuffer, which covers the render area
+        if(renderMode == RM_SOFTWARE)
+            framebuffer.resize(rRenderArea.w, rRenderArea.h);
+
+        // Indexed textures are shaded through the colormap in software mode, fog is put into it instead of its pass
+        const bool indexed  = renderMode == RM_SOFTWARE && mainScene->getTextureStorage() == TS_INDEXED;
+        const bool fogBaked = indexed && postProcessor.isPassEnabled(PP_FOG);
+        if(indexed)
+            colormap.update(mainScene->getTexturePalette(), fogBaked, postProcessor.getFogColor(), postProcessor.getFogStart(),
+                            postProcessor.getFogEnd());
+
         // Clear the specified part of screen buffer if requested
         if(bClear)
         {
             SDL_SetRenderDrawColor(sdlRend, cClearColor.r, cClearColor.g, cClearColor.b, cClearColor.a);
             SDL_RenderFillRect(sdlRend, &rClearArea);
+            // Fog pass would cover cleared pixels (nothing is seen there) with the fog color completely
+            if(renderMode == RM_SOFTWARE)
+                framebuffer.fill(rClearArea.x - rRenderArea.x, rClearArea.y - rRenderArea.y, rClearArea.w, rClearArea.h,
+                                 fogBaked ? postProcessor.getFogColor() : enColor(cClearColor.r, cClearColor.g, cClearColor.b, 255));
             bClear = false;
         }
         // Skip drawing process if redrawing is not requested
         int column = bRedraw ? rRenderArea.x : (rRenderArea.x + rRenderArea.w);
 
+        // Drawing exclusions for the current pixel column encoded in key-value pair (start-end heights in screen coordinates).
+        // Stored ranges never touch each other, and all of them start at rows interval grid, so there can not be more of them
+        // than there are rows on the screen.
+        FrameList<pair<int, int>> drawExcls(frameArena, rRenderArea.h + 2);
+
+        // Translucent lines wait for the end of their column, each with its own copy of the exclusions; rows let through
+        // as much of the farther walls as the lines in front of them leave
+        translucentLayers = FrameList<TranslucentLayer>(frameArena, TRANSLUCENT_LAYERS);
+        layerExclusions   = frameArena.allocate<FrameList<pair<int, int>>>(TRANSLUCENT_LAYERS);
+        for(int i = 0; i < TRANSLUCENT_LAYERS; i++)
+            layerExclusions[i] = FrameList<pair<int, int>>(frameArena, rRenderArea.h + 2);
+        transmittance = frameArena.allocate<float>(rRenderArea.h);
+        for(int y = 0; y < rRenderArea.h; y++)
+            transmittance[y] = 1;
+
+        // Features of column kernels which stay the same for the whole frame
+        const bool software   = renderMode == RM_SOFTWARE;
+        const int frameKernel = (bLightEnabled && !indexed ? CK_LIT : 0) | (columnsPerRay == 1 ? CK_SINGLE_COLUMN : 0)
+                              | (software ? CK_SOFTWARE : 0);
+        frameView = { camPos, camDir, planeVec, pcmDist, columnsPerRay, rowsInterval, frameKernel, indexed ? &colormap : nullptr };
+
+        // Directions of all rays of the frame, computed 8 at once; arrays are padded to whole batches. Ray is positioned
+        // on the camera plane from -1 (leftmost column) to 1 (rightmost column).
+        const int rayCount = (rRenderArea.w + columnsPerRay - 1) / columnsPerRay;
+        const int rayPadded = (rayCount + 7) / 8 * 8;
+        float* rayDirsX = frameArena.allocate<float>(rayPadded);
+        float* rayDirsY = frameArena.allocate<float>(rayPadded);
+        const Vector2x8 batchCamDir(camDir);
+        const Vector2x8 batchPlaneVec(planeVec);
+        for(int r = 0; r < rayPadded; r += 8)
+        {
+            float camerasX[8];
+            for(int l = 0; l < 8; l++)
+                camerasX[l] = 2 * (r + l) * columnsPerRay / (float)rRenderArea.w - 1;
+            Vector2x8 rayDirs = (batchCamDir + batchPlaneVec * Floatx8::load(camerasX)).normalized();
+            rayDirs.store(rayDirsX + r, rayDirsY + r);
+        }
+
+        // Lines drawn in this frame are kept for the G-buffer queries (`getColumnSample`, `pick`) until the next one is
+        // drawn, their storage is reserved for a bit more lines than the last frame had; vectors only grow so steady
+        // frames do not allocate
+        if(bRedraw)
+        {
+            rSampleArea = rRenderArea;
+            iSampleColumnsPerRay = columnsPerRay;
+            columnSamples.resize(rayCount);
+            spanOffsets.resize(rayCount + 1);
+            int sampleCapacity = spanSamples.size() + spanSamples.size() / 4;
+            sampleArena.reset();
+            spanSamples = FrameList<ColumnSample>(sampleArena, sampleCapacity > 2 * rayCount ? sampleCapacity : 2 * rayCount);
+        }
+
+        // Costs are recorded for the overlay only while it is shown
+        const bool recordCosts = bRedraw && overlay.isEnabled();
+        const bool timeColumns = recordCosts && overlay.isHeatmapEnabled() && overlay.getMetric() == CM_TIME;
+        if(recordCosts)
+            overlay.beginFrame(rayCount, mainScene->getWidth(), mainScene->getHeight());
+
+        // Pick the backend expected to draw the walls faster: its measured time per unit of work times the work the
+        // frame is estimated to take. Each of them draws a frame of a scene first to be measured, these probe frames
+        // are left out of the governor and the frame statistics.
+        frameBackend = backend;
+        bProbeFrame  = false;
+        if(backend == RB_AUTO)
+        {
+            if(costScene != mainScene)
+            {
+                fRaycastCost = -1;
+                fObjectCost  = -1;
+                costScene    = mainScene;
+                sampleDensities(mainScene);
+            }
+            else if(mainScene->getGridRevision() != costGridRevision || mainScene->getWallsRevision() != costWallsRevision)
+                sampleDensities(mainScene);
+            if(fRaycastCost < 0 || fObjectCost < 0)
+            {
+                frameBackend = fRaycastCost < 0 ? RB_RAYCAST : RB_OBJECT_ORDER;
+                bProbeFrame  = bRedraw;
+            }
+            else
+                frameBackend = fRaycastCost * estimateWallWork(RB_RAYCAST, rayCount)
+                               <= fObjectCost * estimateWallWork(RB_OBJECT_ORDER, rayCount) ? RB_RAYCAST : RB_OBJECT_ORDER;
+        }
+        time_point<steady_clock> wallsStart = steady_clock::now();
+        if(frameBackend == RB_OBJECT_ORDER && bRedraw)
+        {
+            drawObjectOrder(rayDirsX, rayDirsY, rayCount, drawExcls, pvsReach >= 0);
+            column = rRenderArea.x + rRenderArea.w;
+        }
+
+        const bool runsEnabled = bSpanCoherence && rowsInterval == 1;
+        int runResume = 0; // Ray the wall runs are tried again from after a failed one
+        iCoherentColumns = 0;
+
         // Draw the current frame, which consists of pixel columns
-        for( ; column < (rRenderArea.x + rRenderArea.w); column += iColumnsPerRay)
+        for( ; column < (rRenderArea.x + rRenderArea.w); column += columnsPerRay)
         {
 
-            // Drawing exclusions for the current pixel column encoded in key-value pair (start-end heights in screen coordinates)
-            vector<pair<int, int>> drawExcls;
+            drawExcls.clear();
             bool keepWalking = true;
 
-            // Position of the ray on the camera plane, from -1 (leftmost) to 1 (rightmost)
-            float cameraX  = 2 * (column - rRenderArea.x) / (float)rRenderArea.w - 1;
-            Vector2 rayDir = (camDir + planeVec * cameraX).normalized();
+            int ray = (column - rRenderArea.x) / columnsPerRay;
+            Vector2 rayDir(rayDirsX[ray], rayDirsY[ray]);
+            startSamples(ray);
+
+            // Cost of the column for the heatmap
+            int raySteps = 0, wallTests = 0, lineCount = 0;
+            time_point<steady_clock> columnStart = timeColumns ? steady_clock::now() : time_point<steady_clock>();
+
+            // Wall which may start a run: the first one drawn in the column which also stops the ray
+            int runWall = -1, runTileId = 0;
+            float runU  = 0;
+            Vector2 runTile;
+            ColumnSpan runSpan;
 
             walker->init(camPos, rayDir);
             while(keepWalking)
@@ -282,28 +1656,22 @@ namespace rpge
 
 
                 RayHitInfo hit = walker->next();
+                raySteps++;
                 if( walker->rayFlag & (DDA::RF_TOO_FAR | DDA::RF_OUTSIDE | DDA::RF_FAIL) )
                     break;
                 else if( !(walker->rayFlag & DDA::RF_HIT) )
                     continue;
-
-                // Compute the ray-tile intersection point in local tile coordinates, keep it pivoted to the bottom-left corner
-                // of a tile when looking at it from the top. If hit distance is exactly 0 it indicates that hit occurred inside
-                // the origin tile.
-                Vector2 localEnter;
-                float localX = hit.point.x - (int)hit.point.x;
-                float localY = hit.point.y - (int)hit.point.y;
-                if(walker->rayFlag & DDA::RF_SIDE)
+                if(pvsReach >= 0)
                 {
-                    localEnter.x = !hit.distance ? localX : (rayDir.x < 0);
-                    localEnter.y = localY;
-                }
-                else
-                {
-                    localEnter.x = localX;
-                    localEnter.y = !hit.distance ? localY : (rayDir.y < 0);
+                    if(hit.distance > pvsReach)
+                        break;
+                    if(!pvsVisible[pvs->getTileIndex(hit.tile.x, hit.tile.y)])
+                        continue;
                 }
 
+                // Compute the ray-tile intersection point in local tile coordinates
+                Vector2 localEnter = walker->getLocalEnter(hit);
+
                 // Obtain collection of walls defined for the hit tile, if there are any
                 int tileId = mainScene->getTileId(hit.tile.x, hit.tile.y);
                 const vector<WallData>* wallData = mainScene->getTileWalls(tileId);
@@ -316,37 +1684,21 @@ namespace rpge
                 /************************************************************************/
 
                 int wallCount = wallData->size();
-                // Array of distances to local intersection points of walls with respective indices (e.g. drawInfos[1]
-                // is all about wallData.at(1)).
-                pair<float, Vector2> drawInfos[wallCount];
+                wallTests += wallCount;
+                // Array of distances to intersection points of walls and their positions along the walls, with respective
+                // indices (e.g. drawInfos[1] is all about wallData.at(1)). It is given back to the arena once the tile is drawn.
+                FrameArena::Marker tileMark = frameArena.mark();
+                pair<float, float>* drawInfos = frameArena.allocate<pair<float, float>>(wallCount);
 
                 for(int i = 0; i != wallCount; i++)
                 {
-                    const WallData* wdPtr = &wallData->at(i);
                     float perpDist = 0xffff;
-                    Vector2 localInter;
-
-                    // The formula below was derived by parts, and compressed into one long computation
-                    // NOTE: this formula works even when enter point is actually inside a tile.
-                    float a         = wdPtr->func.slope;
-                    float h         = wdPtr->func.height;
-                    float interDist = ( localEnter.y - a * localEnter.x - ( h == 0 ? SAFE_LINE_HEIGHT : h ) ) / ( rayDir.x * a - rayDir.y );
-
-                    // Distance is negative when a wall is not reached by the ray, this and the fact that the longest
-                    // distance in tile boundary is 1/sqrt(2), can be used to perform early classification.
-                    if(interDist >= 0 && interDist <= SQRT2)
-                    {
-                        localInter = interDist * rayDir + localEnter;
+                    float interDist, u = 0;
 
-                        // Check if point is included in arguments and values range defined
-                        if((localInter.x >= wdPtr->func.xMin && localInter.x <= wdPtr->func.xMax) &&
-                           (localInter.y >= wdPtr->func.yMin && localInter.y <= wdPtr->func.yMax))
-                        {
-                            perpDist = rayDir.dot(camDir) * ( hit.distance + interDist );
-                        }
-                    }
+                    if(wallData->at(i).intersect(localEnter, rayDir, interDist, u))
+                        perpDist = rayDir.dot(camDir) * ( hit.distance + interDist );
 
-                    drawInfos[i] = make_pair(perpDist, localInter);
+                    drawInfos[i] = make_pair(perpDist, u);
                 }
 
 
@@ -376,172 +1728,192 @@ namespace rpge
 
                     // Exclude the (for now) the nearest wall and collect its second property
                     drawInfos[nearest].first = 0xffff;
-                    Vector2 localInter = drawInfos[nearest].second;
+                    float wallU = drawInfos[nearest].second;
 
                     const WallData* wdPtr = &wallData->at(nearest);
 
-                    // Calculate a normal vector of the wall, it always points outwards
-                    bool flipped = false;
-                    float a      = wdPtr->func.slope;
-                    float h      = wdPtr->func.height;
-                    float coef   = 1 / sqrt( a * a + 1 );
-                    Vector2 normal(a * coef, -1 * coef);
-                    if(camPos.y >= a * (camPos.x - hit.tile.x) + hit.tile.y + h)
-                    {
-                        normal *= -1;
-                        flipped = true;
-                    }
-
-                    // Find out range describing how column should be drawn for the current wall
-                    float lineHeight = rRenderArea.h * (pcmDist / perpDist);
-                    int drawStart    = rRenderArea.y + (rRenderArea.h - lineHeight) / 2 + lineHeight * (1 - wdPtr->hMax);
-                    int drawEnd      = rRenderArea.y + (rRenderArea.h + lineHeight) / 2 - lineHeight * wdPtr->hMin;
-
-                    // Obtain information on the wall looks
-                    SDL_Texture* texPtr = mainScene->getTextureSource(wdPtr->texId);
-                    bool isSolidColor = false;
-                    if(texPtr == nullptr) isSolidColor  = true;
-
-                    // Compute normalized horizontal position on the wall plane
-                    float planeHorizontal = (localInter - wdPtr->pivot).magnitude() / wdPtr->length;
-                    if(flipped)
-                        planeHorizontal = 1 - planeHorizontal;
-
                     // Draw the line with exclusions taken into account
-                    
-                    bool beg = false;
-                    int exclCount = drawExcls.size();
-                    int lineStart = drawStart;
-                    int lineEnd   = drawEnd;
-                    int e = 0;
-                    int texWidth, texHeight;
-
-                    SDL_QueryTexture(texPtr, NULL, NULL, &texWidth, &texHeight);
-                    // Texture pixel height in screen pixels
-                    float tpHeight = (drawEnd - drawStart) / (float)texHeight;
-
-                    pair<int, int> ex;
-                    while(true)
-                    {
-                        if(e != exclCount)
-                        {
-                            ex = drawExcls.at(e);
-                            if(ex.second > drawStart)
-                            {
-                                if(beg || drawStart > ex.first)
-                                {
-                                    lineStart = ex.second;
-                                    if(++e != exclCount)
-                                        ex = drawExcls.at(e);
-                                }
-                                lineEnd = (e == exclCount || drawEnd <= ex.first) ? drawEnd : ex.first;
-                                beg = true;
-                                if(lineStart > lineEnd)
-                                    break;
-                            }
-                            else
-                            {
-                                e++;
-                                continue;
-                            }
-                        }
-
-                        // Draw drawable part of the line drawing range if possible
-                        SDL_Rect rendRect = { column, lineStart, iColumnsPerRay, lineEnd - lineStart };
-                        if(isSolidColor)
-                        {
-                            // Draw solid-color column
-                            uint8_t cr, cg, cb, ca;
-                            deColor(wdPtr->tint, cr, cg, cb, ca);
-                            SDL_SetRenderDrawColor(sdlRend, cr, cg, cb, ca);
-                            SDL_RenderFillRect(sdlRend, &rendRect);
-                        }
-                        else
-                        {
-                            // Draw part of a texture
-                            float offset   = (rendRect.y - drawStart);
-                            float length   = rendRect.h;
-
-                            // THIS BLOCK REMOVES PARTIAL PIXELS = FIXES WRONG PIXELS STRETCH
-                            if(lineStart == drawStart)
-                                rendRect.h = floorf(rendRect.h / tpHeight) * tpHeight;
-                            else if(lineEnd == drawEnd)
-                            {
-                                float dist = rendRect.y - drawStart;
-                                dist = ceilf(dist / tpHeight) * tpHeight;
-                                rendRect.y = drawStart + dist;
-                                rendRect.h = floorf(rendRect.h / tpHeight) * tpHeight;
-                            }
-
-                            offset /= (float)(drawEnd - drawStart);
-                            length /= (float)(drawEnd - drawStart);
-                            
-                            SDL_Rect texRect  = { texWidth * planeHorizontal, texHeight * offset, 1, texHeight * length };
-                            
-                            SDL_RenderCopy(sdlRend, texPtr, &texRect, &rendRect);
-                        }
-                        // Shade the drawn column by drawing black color with appropriate opacity over it
-                        SDL_SetRenderDrawColor(sdlRend, 0, 0, 0, (normal.dot(vLightDir) + 1.0f) / 2.0f * 128);
-                        SDL_RenderDrawRect(sdlRend, &rendRect);
-
-                        if(e == exclCount || lineEnd == drawEnd || ex.second >= drawEnd)
-                            break;
-                    } 
-
-
-                    // Prepare exclusions vector for the new exclusion (the drawn line range), every range in that vector
-                    // must stay separated from each other.
-                    int varStart = drawStart;
-                    int varEnd   = drawEnd;
-                    e = -1;
-                    while(++e < exclCount)
+                    bool firstLine = drawExcls.size() == 0 && translucentLayers.size() == 0;
+                    ColumnSpan span;
+                    bool occluded = drawWallLine(*wdPtr, rayDir, column, perpDist, wallU, drawExcls, span);
+                    lineCount++;
+                    keepSample(ray, rayDir, hit.tile, tileId, *wdPtr, nearest, perpDist, wallU);
+
+                    // Runs drawn as geometry blend the shade into the wall color, which gives the same result only for opaque
+                    // walls; textured runs are drawn column by column
+                    if(runsEnabled && wdPtr->stopsRay && firstLine)
                     {
-                        pair<int, int>& ex = drawExcls.at(e);
-
-                        if(ex.first <= varEnd && ex.second >= varStart)
+                        if(!bLightEnabled || span.texture != nullptr || span.color.a == 255)
                         {
-                            varStart = ex.first  < varStart ? ex.first  : varStart;
-                            varEnd   = ex.second > varEnd   ? ex.second : varEnd  ;
-                            drawExcls.erase(drawExcls.begin() + e);
-                            exclCount--;
-                            e = -1;
+                            runWall = nearest;
+                            runU    = wallU;
+                            runTile = hit.tile;
+                            runTileId = tileId;
+                            runSpan = span;
                         }
                     }
-                    // Add the drawn line range as new exclusion, perform it in such way that will remain the vector sorted
-                    // ascendingly by start coordinate.
-                    int t = exclCount;
-                    for(int e = 0; e < exclCount; e++)
-                        if(varStart <= drawExcls.at(e).first)
-                        {
-                            t = e;
-                            break;
-                        }
-                    drawExcls.insert(drawExcls.begin() + t, make_pair(varStart, varEnd));
 
                     // Decide if ray should keep on walking, free column drawing information because it was already used
-                    if(wdPtr->stopsRay)
+                    if(wdPtr->stopsRay || occluded)
                     {
                         keepWalking = false;
                         break;
                     }
                 }
+                frameArena.rewind(tileMark);
             }
+            drawTranslucentLines();
+            if(recordCosts)
+                keepColumnCost(ray, raySteps, wallTests, lineCount, columnStart);
 
             #ifdef DEBUG
 
             // Draw exclusion ranges
-            for(const pair<int, int>& excl : drawExcls)
+            drawExclusions(column, drawExcls);
+
+            #endif
+
+            // Try to fill the columns up to some ray ahead at once, it is possible when that ray hits the same wall and no other
+            // wall stands in the wedge between both rays and the wall, so every ray in between hits that wall first
+            if(runWall < 0 || ray < runResume)
+                continue;
+            const WallData& wall = mainScene->getTileWalls(runTileId)->at(runWall);
+            Vector2 wallStart = runTile + wall.start;
+
+            // The farthest candidate is the last ray still hitting the wall, found from where its ends are seen on the
+            // camera plane; when something stands in its wedge, the ray halfway to it is tried too
+            int lastRay = rayCount - 1;
+            Vector2 ends[2] = { wallStart - camPos, runTile + wall.end - camPos };
+            if(ends[0].dot(camDir) > 0 && ends[1].dot(camDir) > 0)
+            {
+                float cameraX0 = ends[0].dot(planeVec) / planeVec.dot(planeVec) / ends[0].dot(camDir);
+                float cameraX1 = ends[1].dot(planeVec) / planeVec.dot(planeVec) / ends[1].dot(camDir);
+                float cameraX  = cameraX0 > cameraX1 ? cameraX0 : cameraX1;
+                lastRay = clamp((int)floorf((cameraX + 1) * rRenderArea.w / (2.0f * columnsPerRay)), 0, rayCount - 1);
+            }
+            int runEnds[2] = { lastRay, ray + (lastRay - ray) / 2 };
+            int runEnd = -1;
+            for(int attempt = 0; attempt < 2 && runEnd < 0; attempt++)
+            {
+                int end = runEnds[attempt];
+                if(end - ray < 2)
+                    continue;
+                Vector2 endDir(rayDirsX[end], rayDirsY[end]);
+                float endDist, endU;
+                if(!wall.intersect(camPos - runTile, endDir, endDist, endU))
+                    continue;
+                Vector2 wedge[3] = {
+                    camPos,
+                    wallStart + wall.dir * (runU * wall.length),
+                    wallStart + wall.dir * (endU * wall.length)
+                };
+                if(!isWedgeBlocked(runTile, runWall, wedge))
+                    runEnd = end;
+            }
+            if(runEnd < 0)
             {
-                SDL_SetRenderDrawColor(sdlRend, 0, 255, 0, 255);
-                SDL_RenderDrawPoint(sdlRend, column, excl.first);
-                SDL_SetRenderDrawColor(sdlRend, 255, 0, 0, 255);
-                SDL_RenderDrawPoint(sdlRend, column, excl.second + 1);
+                // Something changes before the nearer candidate, cast the columns up to it one by one
+                runResume = runEnds[1];
+                continue;
             }
 
-            #endif
+            // Rays of the run have to draw the wall under the rules cast rays walk by. The tile distance limit depends only
+            // on the tile, which the first ray reached already, but reach of the visibility set is measured along every ray;
+            // the run ends before the first ray going past it, or missing the wall.
+            for(int r = ray + 1; r <= runEnd; r++)
+            {
+                Vector2 runDir(rayDirsX[r], rayDirsY[r]);
+                float dist, u;
+                if(!wall.intersect(camPos - runTile, runDir, dist, u)
+                   || (pvsReach >= 0 && getTileEnterDistance(camPos, runDir, runTile) > pvsReach))
+                {
+                    runEnd = r - 1;
+                    break;
+                }
+            }
+            if(runEnd - ray < 2)
+            {
+                runResume = runEnd + 2;
+                continue;
+            }
+
+            // Nothing stands in front of the wall along the rays of the run (see the wedge test above), so their columns have
+            // no exclusions. Geometry is drawn only for solid-color walls: it interpolates texture coordinates across the
+            // strips, while the column kernels sample every column exactly and snap the rows to texels.
+            int xEnd = rRenderArea.x + (runEnd + 1) * columnsPerRay;
+            xEnd = xEnd < rRenderArea.x + rRenderArea.w ? xEnd : rRenderArea.x + rRenderArea.w;
+            bool geometry = !software && runSpan.texture == nullptr;
+            if(geometry)
+                drawRun(runSpan, wall, runTile, column + columnsPerRay, xEnd);
+            iCoherentColumns += xEnd - column - columnsPerRay;
+
+            // Rays of the run were not cast, their lines are found on the wall directly; the ones not drawn as geometry are
+            // drawn from there column by column, the software mode does not save anything by filling several at once
+            for(int r = ray + 1; r <= runEnd; r++)
+            {
+                Vector2 runDir(rayDirsX[r], rayDirsY[r]);
+                float dist, u;
+                startSamples(r);
+                wall.intersect(camPos - runTile, runDir, dist, u);
+                if(!geometry)
+                {
+                    ColumnSpan span;
+                    drawExcls.clear();
+                    drawWallLine(wall, runDir, rRenderArea.x + r * columnsPerRay, runDir.dot(camDir) * dist, u, drawExcls, span);
+                }
+                keepSample(r, runDir, runTile, runTileId, wall, runWall, runDir.dot(camDir) * dist, u);
+            }
+
+            // Continue past the run
+            column = rRenderArea.x + runEnd * columnsPerRay;
+        }
+
+        if(bRedraw)
+            spanOffsets[rayCount] = spanSamples.size();
+        float wallsTime = duration<float>(steady_clock::now() - wallsStart).count();
+        RPGE_TRACE_END(wallsSpan);
+
+        // Software frames go through the post passes, then they are uploaded to the screen
+        if(software && bRedraw)
+        {
+            RPGE_TRACE_SPAN(resolveSpan, "resolve");
+            bool withDepths = postProcessor.isPassEnabled(PP_FOG) && !fogBaked;
+            if(withDepths)
+                fillDepths();
+            framebuffer.resolve(withDepths);
+            RPGE_TRACE_END(resolveSpan);
+            postProcessor.process(framebuffer, fogBaked ? 1 << PP_FOG : 0);
+
+            RPGE_TRACE_SCOPE("upload");
+            if(!fitTexture(frameTexture, rRenderArea.w, rRenderArea.h)
+               || SDL_UpdateTexture(frameTexture, NULL, framebuffer.getRow(0), rRenderArea.w * sizeof(uint32_t)) != 0
+               || SDL_RenderCopy(sdlRend, frameTexture, NULL, &rRenderArea) != 0)
+                iError |= E_SDL;
         }
 
-        if(bIsCursorLocked)
+        // Cost overlay goes over the finished frame, so post passes do not change its colors
+        if(recordCosts)
+        {
+            RPGE_TRACE_SCOPE("overlay");
+            overlay.endFrame();
+            drawOverlay(rayCount);
+        }
+
+        // Keep the average time the backend which drew the frame took per unit of work for the walls
+        if(bRedraw && backend == RB_AUTO)
+        {
+            float& cost = frameBackend == RB_RAYCAST ? fRaycastCost : fObjectCost;
+            float unitTime = wallsTime / estimateWallWork(frameBackend, rayCount);
+            cost = cost < 0 ? unitTime : cost + (unitTime - cost) * 0.1f;
+        }
+
+        // Let the governor adjust resolution of the next frame to the time this one took, probe frames do not tell
+        // how long frames take
+        duration<float> workTime = steady_clock::now() - tpCurrent;
+        if(!bProbeFrame)
+            governor.update(workTime.count(), 1.0f / iFramesPerSecond);
+
+        if(bIsCursorLocked && sdlWindow != nullptr)
             SDL_WarpMouseInWindow(sdlWindow, iScreenWidth / 2, iScreenHeight / 2);
         
 
@@ -552,17 +1924,38 @@ namespace rpge
         /***********************************************/
 
 
-        int delay = (1.0f / iFramesPerSecond - elapsedTime.count()) * 1000;
-        delay = delay < 0 ? 0 : delay;
-        
-        SDL_Delay(delay); // Maybe this causes the lag when unfreezing?
+        // Present the frame at its deadline
+        RPGE_TRACE_SPAN(paceSpan, "pace");
+        pacer.wait(!bProbeFrame);
+        RPGE_TRACE_END(paceSpan);
 
         if(bRedraw)
         {
+            RPGE_TRACE_SCOPE("present");
             SDL_RenderPresent(sdlRend);
             bRedraw = false;
         }
+
+        // Input latency is measured from the oldest event the presented frame could react to, pipelined frames react
+        // to events handled by the tick they draw
+        time_point<steady_clock> tpPresented = steady_clock::now();
+        const SimulationSnapshot* drawn = simulation != nullptr ? &simulation->getSnapshot() : nullptr;
+        bool reacted = drawn != nullptr ? bFreshSnapshot && drawn->hasInput : !frameInputs.empty();
+        if(reacted && !bProbeFrame)
+        {
+            duration<float> latency = tpPresented - (drawn != nullptr ? drawn->inputTime : frameInputs.front().time);
+            fInputLatency = latency.count();
+            fMeanInputLatency = fMeanInputLatency == 0 ? fInputLatency : fMeanInputLatency + (fInputLatency - fMeanInputLatency) * 0.1f;
+        }
+        if(drawn != nullptr && !bProbeFrame)
+        {
+            duration<float> latency = tpPresented - drawn->time;
+            fSnapshotLatency = latency.count();
+            fMeanSnapshotLatency = fMeanSnapshotLatency == 0 ? fSnapshotLatency
+                                                             : fMeanSnapshotLatency + (fSnapshotLatency - fMeanSnapshotLatency) * 0.1f;
+        }
         frameIndex++;
+        frameAllocations = getAllocationCount() - allocations;
         return bRun;
     }
 }
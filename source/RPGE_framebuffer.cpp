@@ -0,0 +1,144 @@
+
+#include <RPGE_framebuffer.hpp>
+#include <RPGE_simd.hpp>
+
+// Writes `width` x `height` values stored column after column at `src` to `dst` row after row. It goes through strips
+// of `strip` columns from top to bottom, so the columns are read as a few sequential streams and every row of a strip
+// gets whole cache lines written, and moves 4 x 4 values at once.
+template<typename T>
+static void transposeColumns(const T* src, T* dst, int width, int height, int strip)
+{
+    static_assert(sizeof(T) == sizeof(float), "Values are moved as floats");
+    for(int stripX = 0; stripX < width; stripX += strip)
+    {
+        int xEnd = stripX + strip < width ? stripX + strip : width;
+        int y = 0;
+        #ifdef RPGE_SIMD_SSE
+        for( ; y + 4 <= height; y += 4)
+        {
+            int x = stripX;
+            for( ; x + 4 <= xEnd; x += 4)
+            {
+                const float* column = (const float*)(src + x * height + y);
+                __m128 row0 = _mm_loadu_ps(column);
+                __m128 row1 = _mm_loadu_ps(column + height);
+                __m128 row2 = _mm_loadu_ps(column + 2 * height);
+                __m128 row3 = _mm_loadu_ps(column + 3 * height);
+                _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+                float* row = (float*)(dst + y * width + x);
+                _mm_storeu_ps(row, row0);
+                _mm_storeu_ps(row + width, row1);
+                _mm_storeu_ps(row + 2 * width, row2);
+                _mm_storeu_ps(row + 3 * width, row3);
+            }
+            for( ; x < xEnd; x++)
+                for(int i = 0; i < 4; i++)
+                    dst[(y + i) * width + x] = src[x * height + y + i];
+        }
+        #endif
+        for( ; y < height; y++)
+            for(int x = stripX; x < xEnd; x++)
+                dst[y * width + x] = src[x * height + y];
+    }
+}
+
+namespace rpge
+{
+
+    /****************************************/
+    /********** CLASS: FRAMEBUFFER **********/
+    /****************************************/
+
+    const int Framebuffer::TRANSPOSE_STRIP = 32;
+
+    Framebuffer::Framebuffer()
+    {
+        this->columnMajor = false;
+        this->width       = 0;
+        this->height      = 0;
+    }
+    void Framebuffer::fill(int x, int y, int w, int h, uint32_t color)
+    {
+        int xEnd = x + w < width ? x + w : width;
+        int yEnd = y + h < height ? y + h : height;
+        x = x < 0 ? 0 : x;
+        y = y < 0 ? 0 : y;
+        const int step = getDrawStep();
+        for(int column = x; column < xEnd; column++)
+        {
+            uint32_t* pixel = getDrawColumn(column);
+            for(int row = y; row < yEnd; row++)
+                pixel[row * step] = color;
+        }
+    }
+    uint32_t* Framebuffer::getDrawColumn(int x)
+    {
+        return columnMajor ? columnPixels.data() + x * height : pixels.data() + x;
+    }
+    float* Framebuffer::getDrawDepthColumn(int x)
+    {
+        return columnMajor ? columnDepths.data() + x * height : depths.data() + x;
+    }
+    int Framebuffer::getDrawStep() const
+    {
+        return columnMajor ? 1 : width;
+    }
+    float* Framebuffer::getDepthRow(int y)
+    {
+        return depths.data() + y * width;
+    }
+    const float* Framebuffer::getDepthRow(int y) const
+    {
+        return depths.data() + y * width;
+    }
+    int Framebuffer::getHeight() const
+    {
+        return height;
+    }
+    uint32_t* Framebuffer::getRow(int y)
+    {
+        return pixels.data() + y * width;
+    }
+    const uint32_t* Framebuffer::getRow(int y) const
+    {
+        return pixels.data() + y * width;
+    }
+    int Framebuffer::getWidth() const
+    {
+        return width;
+    }
+    bool Framebuffer::isColumnMajor() const
+    {
+        return columnMajor;
+    }
+    void Framebuffer::resize(int width, int height)
+    {
+        if(width == this->width && height == this->height)
+            return;
+        this->width  = width < 0 ? 0 : width;
+        this->height = height < 0 ? 0 : height;
+        pixels.resize(this->width * this->height);
+        depths.resize(this->width * this->height);
+        if(columnMajor)
+        {
+            columnPixels.resize(this->width * this->height);
+            columnDepths.resize(this->width * this->height);
+        }
+    }
+    void Framebuffer::resolve(bool withDepths)
+    {
+        if(!columnMajor)
+            return;
+        transposeColumns(columnPixels.data(), pixels.data(), width, height, TRANSPOSE_STRIP);
+        if(withDepths)
+            transposeColumns(columnDepths.data(), depths.data(), width, height, TRANSPOSE_STRIP);
+    }
+    void Framebuffer::setColumnMajor(bool enabled)
+    {
+        if(enabled == columnMajor)
+            return;
+        this->columnMajor = enabled;
+        columnPixels.resize(enabled ? width * height : 0);
+        columnDepths.resize(enabled ? width * height : 0);
+    }
+}
@@ -0,0 +1,263 @@
+
+#include <fstream>
+#include <RPGE_generator.hpp>
+
+namespace rpge
+{
+    // Values `a` of hashes made for tile kinds and textures start here, so they do not repeat those of tiles
+    static const uint64_t KIND_SALT    = 1ull << 40;
+    static const uint64_t TEXTURE_SALT = 2ull << 40;
+
+    // Scrambles value `value` (the splitmix64 finalizer), it gives the same results on every platform unlike the
+    // standard random distributions
+    static uint64_t mixBits(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+    // Returns random number `bits` as a float from 0 (inclusive) to 1 (exclusive)
+    static float toUnit(uint64_t bits)
+    {
+        return (bits >> 40) / 16777216.0f;
+    }
+    // Appends number `value` (not negative) followed by a space to text `text`
+    static void appendNumber(string& text, int value)
+    {
+        char digits[12];
+        int count = 0;
+        do
+        {
+            digits[count++] = '0' + value % 10;
+            value /= 10;
+        } while(value > 0);
+        while(count > 0)
+            text += digits[--count];
+        text += ' ';
+    }
+
+    /***************************************************/
+    /********** STRUCTURE: GENERATOR SETTINGS **********/
+    /***************************************************/
+
+    GeneratorSettings::GeneratorSettings()
+    {
+        this->width            = 256;
+        this->height           = 256;
+        this->seed             = 1;
+        this->wallDensity      = 0.2f;
+        this->wallsPerTile     = 1;
+        this->tileKinds        = 8;
+        this->transparentRatio = 0;
+        this->solidRatio       = 0;
+        this->textureCount     = 0;
+        this->texturePrefix    = "texture_";
+        this->sightlineSpacing = 0;
+        this->bordered         = true;
+    }
+
+    /********************************************/
+    /********** CLASS: SCENE GENERATOR **********/
+    /********************************************/
+
+    const int SceneGenerator::SOLID_KIND = 1;
+
+    SceneGenerator::SceneGenerator(const GeneratorSettings& settings)
+    {
+        this->settings = settings;
+        this->settings.width            = settings.width > 1 ? settings.width : 1;
+        this->settings.height           = settings.height > 1 ? settings.height : 1;
+        this->settings.wallDensity      = clamp(settings.wallDensity, 0.0f, 1.0f);
+        this->settings.wallsPerTile     = settings.wallsPerTile > 1 ? settings.wallsPerTile : 1;
+        this->settings.tileKinds        = settings.tileKinds > 1 ? settings.tileKinds : 1;
+        this->settings.transparentRatio = clamp(settings.transparentRatio, 0.0f, 1.0f);
+        this->settings.solidRatio       = clamp(settings.solidRatio, 0.0f, 1.0f);
+        this->settings.textureCount     = settings.textureCount > 0 ? settings.textureCount : 0;
+        this->settings.sightlineSpacing = settings.sightlineSpacing > 0 ? settings.sightlineSpacing : 0;
+    }
+    uint64_t SceneGenerator::hash(uint64_t a, uint64_t b, uint64_t c) const
+    {
+        return mixBits(mixBits(mixBits(settings.seed + a) + b) + c);
+    }
+    void SceneGenerator::fill(Scene& scene) const
+    {
+        int width  = scene.getWidth() < settings.width ? scene.getWidth() : settings.width;
+        int height = scene.getHeight() < settings.height ? scene.getHeight() : settings.height;
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++)
+                scene.setTileId(x, y, getTileId(x, y));
+
+        // Scene numbers textures in the order they get loaded, missing files leave walls with solid colors
+        vector<int> texIds;
+        for(int t = 0; t < settings.textureCount; t++)
+            texIds.push_back(scene.loadTexture(getTextureFile(t)));
+        for(int id = SOLID_KIND; id <= settings.tileKinds + 1; id++)
+            for(WallData wall : getTileWalls(id))
+            {
+                wall.texId = wall.texId > 0 ? texIds[wall.texId - 1] : 0;
+                scene.createTileWall(id, wall);
+            }
+    }
+    const GeneratorSettings& SceneGenerator::getSettings() const
+    {
+        return settings;
+    }
+    string SceneGenerator::getTextureFile(int index) const
+    {
+        return settings.texturePrefix + std::to_string(index) + ".bmp";
+    }
+    int SceneGenerator::getTileId(int x, int y) const
+    {
+        if(x < 0 || y < 0 || x >= settings.width || y >= settings.height)
+            return 0;
+        if(settings.bordered && (x == 0 || y == 0 || x == settings.width - 1 || y == settings.height - 1))
+            return SOLID_KIND;
+        if(settings.sightlineSpacing > 0 && (x % settings.sightlineSpacing == 0 || y % settings.sightlineSpacing == 0))
+            return 0;
+        if(toUnit(hash(x, y, 0)) >= settings.wallDensity)
+            return 0;
+        if(toUnit(hash(x, y, 2)) < settings.solidRatio)
+            return SOLID_KIND;
+        return 2 + hash(x, y, 1) % settings.tileKinds;
+    }
+    vector<WallData> SceneGenerator::getTileWalls(int tileId) const
+    {
+        const Vector2 corners[4] = { Vector2(0, 0), Vector2(1, 0), Vector2(1, 1), Vector2(0, 1) };
+        vector<WallData> walls;
+        if(tileId < SOLID_KIND || tileId > settings.tileKinds + 1)
+            return walls;
+
+        // The border box is solid, with one color and texture for all of its sides
+        if(tileId == SOLID_KIND)
+        {
+            uint64_t bits = hash(KIND_SALT + tileId, 0, 0);
+            uint32_t color = enColor(96 + (bits & 63), 96 + ((bits >> 8) & 63), 96 + ((bits >> 16) & 63), 255);
+            int texId = settings.textureCount > 0 ? 1 + (bits >> 32) % settings.textureCount : 0;
+            for(int side = 0; side < 4; side++)
+                walls.push_back(WallData(corners[side], corners[(side + 1) % 4], color, 0, 1, texId, true));
+            return walls;
+        }
+
+        for(int w = 0; w < settings.wallsPerTile; w++)
+        {
+            uint64_t shape = hash(KIND_SALT + tileId, w, 0);
+            Vector2 start, end;
+            switch(shape % 4)
+            {
+                // Full side of the tile
+                case 0:
+                    start = corners[(shape >> 8) % 4];
+                    end   = corners[((shape >> 8) + 1) % 4];
+                    break;
+                // Diagonal
+                case 1:
+                    start = corners[(shape >> 8) % 2];
+                    end   = corners[(shape >> 8) % 2 + 2];
+                    break;
+                // Random segment, its ends are put on the grid
+                default:
+                    start = Vector2(((shape >> 8) % 17) / 16.0f, ((shape >> 16) % 17) / 16.0f);
+                    end   = Vector2(((shape >> 24) % 17) / 16.0f, ((shape >> 32) % 17) / 16.0f);
+                    if(start == end)
+                        end = Vector2(1, 1) - start;
+                    if(start == end)
+                        end = Vector2::ZERO;
+                    break;
+            }
+
+            bool transparent = toUnit(hash(KIND_SALT + tileId, w, 1)) < settings.transparentRatio;
+            uint64_t bits = hash(KIND_SALT + tileId, w, 2);
+            uint32_t color = enColor(48 + (bits % 192), 48 + ((bits >> 8) % 192), 48 + ((bits >> 16) % 192),
+                                     transparent ? 128 : 255);
+            int texId = settings.textureCount > 0 ? 1 + (bits >> 32) % settings.textureCount : 0;
+            walls.push_back(WallData(start, end, color, 0, 1, texId, !transparent));
+        }
+        return walls;
+    }
+    SDL_Surface* SceneGenerator::makeTexture(int index, int size) const
+    {
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+        if(surface == nullptr)
+            return nullptr;
+
+        uint64_t bits = hash(TEXTURE_SALT + index, 0, 0);
+        uint32_t colors[2] = {
+            enColor(64 + (bits & 127), 64 + ((bits >> 8) & 127), 64 + ((bits >> 16) & 127), 255),
+            enColor(128 + ((bits >> 24) & 127), 128 + ((bits >> 32) & 127), 128 + ((bits >> 40) & 127), 255)
+        };
+        int pattern = (bits >> 48) % 3;
+        int cell    = size / 8 > 1 ? size / 8 : 1;
+        for(int y = 0; y < size; y++)
+        {
+            uint32_t* row = (uint32_t*)((uint8_t*)surface->pixels + y * surface->pitch);
+            for(int x = 0; x < size; x++)
+            {
+                bool second;
+                if(pattern == 0)      // Checkerboard
+                    second = (x / cell + y / cell) % 2;
+                else if(pattern == 1) // Bricks, every other row is shifted by half a brick
+                    second = y % cell == 0 || (x + (y / cell % 2) * cell) % (2 * cell) == 0;
+                else                  // Stripes
+                    second = (x + y) / cell % 2;
+                row[x] = colors[second];
+            }
+        }
+        return surface;
+    }
+    void SceneGenerator::writeRps(ostream& stream) const
+    {
+        stream << "\n# Generated scene: size " << settings.width << "x" << settings.height;
+        stream << ", seed " << settings.seed << ", wall density " << settings.wallDensity << ", ";
+        stream << settings.wallsPerTile << " walls per tile, ";
+        stream << settings.tileKinds << " tile kinds, transparent ratio " << settings.transparentRatio << ", ";
+        stream << "solid ratio " << settings.solidRatio << ", ";
+        stream << settings.textureCount << " textures, sightline spacing " << settings.sightlineSpacing << "\n\n";
+
+        // Rows go from the top of the scene (the highest y) down
+        stream << "s " << settings.width << " " << settings.height << "\n";
+        string line;
+        for(int y = settings.height - 1; y >= 0; y--)
+        {
+            line = "w ";
+            for(int x = 0; x < settings.width; x++)
+                appendNumber(line, getTileId(x, y));
+            line.back() = '\n';
+            stream << line;
+        }
+
+        stream << "\n# Tile kinds\n\n";
+        for(int id = SOLID_KIND; id <= settings.tileKinds + 1; id++)
+            for(const WallData& wall : getTileWalls(id))
+            {
+                uint8_t r, g, b, a;
+                deColor(wall.tint, r, g, b, a);
+                stream << "t " << id << " e " << wall.start.x << " " << wall.start.y << " " << wall.end.x << " ";
+                stream << wall.end.y << " d 0 1 0 1 " << wall.hMin << " " << wall.hMax << " r " << wall.stopsRay;
+                stream << " c " << (int)r << " " << (int)g << " " << (int)b << " " << (int)a << " x \"";
+                stream << (wall.texId > 0 ? getTextureFile(wall.texId - 1) : "") << "\"\n";
+            }
+    }
+    bool SceneGenerator::writeRps(const string& file) const
+    {
+        std::ofstream stream(file);
+        if(!stream.good())
+            return false;
+        writeRps(stream);
+        return stream.good();
+    }
+    bool SceneGenerator::writeTextures(int size) const
+    {
+        for(int t = 0; t < settings.textureCount; t++)
+        {
+            SDL_Surface* surface = makeTexture(t, size);
+            if(surface == nullptr)
+                return false;
+            bool written = SDL_SaveBMP(surface, getTextureFile(t).c_str()) == 0;
+            SDL_FreeSurface(surface);
+            if(!written)
+                return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,109 @@
+
+#include <RPGE_governor.hpp>
+
+namespace rpge
+{
+
+    /*******************************************/
+    /********** CLASS: FRAME GOVERNOR **********/
+    /*******************************************/
+
+    const int   FrameGovernor::DEGRADE_FRAMES  = 10;
+    const int   FrameGovernor::IMPROVE_FRAMES  = 90;
+    const int   FrameGovernor::COOLDOWN_FRAMES = 30;
+    const float FrameGovernor::AVERAGE_WEIGHT  = 0.1f;
+
+    FrameGovernor::FrameGovernor()
+    {
+        this->enabled     = false;
+        this->maxColumns  = 8;
+        this->upperRatio  = 0.9f;
+        this->lowerRatio  = 0.6f;
+        reset(1);
+    }
+    int FrameGovernor::maxLevel() const
+    {
+        return maxColumns - baseColumns;
+    }
+    int FrameGovernor::levelColumns(int lvl) const
+    {
+        return baseColumns + lvl;
+    }
+    void FrameGovernor::reset(int columns)
+    {
+        this->level       = 0;
+        this->baseColumns = columns < 1 ? 1 : columns;
+        this->maxColumns  = maxColumns < baseColumns ? baseColumns : maxColumns;
+        this->overFrames  = 0;
+        this->underFrames = 0;
+        this->cooldown    = 0;
+        this->averageTime = 0;
+    }
+    void FrameGovernor::setEnabled(bool enabled)
+    {
+        this->enabled = enabled;
+    }
+    void FrameGovernor::setLimits(int maxColumns)
+    {
+        this->maxColumns = maxColumns < baseColumns ? baseColumns : maxColumns;
+        level = clamp(level, 0, maxLevel());
+    }
+    void FrameGovernor::setThresholds(float lower, float upper)
+    {
+        upperRatio = upper < 0.01f ? 0.01f : upper;
+        lowerRatio = clamp(lower, 0.0f, upperRatio);
+    }
+    int FrameGovernor::getColumnsPerRay() const
+    {
+        return levelColumns(level);
+    }
+    int FrameGovernor::getLevel() const
+    {
+        return level;
+    }
+    float FrameGovernor::getAverageTime() const
+    {
+        return averageTime;
+    }
+    bool FrameGovernor::isEnabled() const
+    {
+        return enabled;
+    }
+    bool FrameGovernor::update(float workTime, float budget)
+    {
+        averageTime = averageTime == 0 ? workTime : averageTime + (workTime - averageTime) * AVERAGE_WEIGHT;
+        if(!enabled || budget <= 0)
+            return false;
+        if(cooldown > 0)
+        {
+            cooldown--;
+            return false;
+        }
+
+        float ratio = averageTime / budget;
+        overFrames  = ratio > upperRatio ? overFrames + 1 : 0;
+        underFrames = ratio < lowerRatio ? underFrames + 1 : 0;
+
+        int next = level;
+        if(overFrames >= DEGRADE_FRAMES && level < maxLevel())
+            next = level + 1;
+        else if(underFrames >= IMPROVE_FRAMES && level > 0)
+        {
+            // Cost is roughly proportional to the amount of rays, do not go up if it would not fit anyway
+            float predicted = ratio * levelColumns(level) / (float)levelColumns(level - 1);
+            if(predicted < upperRatio)
+                next = level - 1;
+        }
+        if(next == level)
+            return false;
+
+        // Moving average is scaled by the expected cost change, so old samples do not trigger another change
+        averageTime *= levelColumns(level) / (float)levelColumns(next);
+
+        level       = next;
+        overFrames  = 0;
+        underFrames = 0;
+        cooldown    = COOLDOWN_FRAMES;
+        return true;
+    }
+}
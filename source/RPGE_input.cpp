@@ -0,0 +1,100 @@
+
+#include <RPGE_input.hpp>
+
+namespace rpge
+{
+
+    /********************************************/
+    /********** STRUCTURE: INPUT EVENT **********/
+    /********************************************/
+
+    InputEvent::InputEvent() : InputEvent(IE_KEY_DOWN, 0, steady_clock::now())
+    {
+    }
+    InputEvent::InputEvent(int type, int code, time_point<steady_clock> time)
+    {
+        this->type     = type;
+        this->code     = code;
+        this->position = Vector2::ZERO;
+        this->motion   = Vector2::ZERO;
+        this->time     = time;
+    }
+
+    /****************************************/
+    /********** CLASS: INPUT QUEUE **********/
+    /****************************************/
+
+    const int InputQueue::CAPACITY        = 256;
+    const int InputQueue::MOTION_CAPACITY = 192;
+
+    InputQueue::InputQueue() : head(0), tail(0)
+    {
+        this->merged = 0;
+        this->events = vector<InputEvent>(CAPACITY);
+        // Events wait only while the consumer is behind, as many as the ring holds are expected at most
+        this->waiting.reserve(CAPACITY);
+    }
+    bool InputQueue::write(const InputEvent& event, bool beforeTransition)
+    {
+        // Indices are never wrapped, their difference is the size even after they overflow
+        uint32_t index = head.load(std::memory_order_relaxed);
+        uint32_t size  = index - tail.load(std::memory_order_acquire);
+        bool motion = event.type == IE_MOUSE_MOTION && !beforeTransition;
+        if(size >= (uint32_t)(motion ? MOTION_CAPACITY : CAPACITY))
+            return false;
+        events[index & (CAPACITY - 1)] = event;
+        head.store(index + 1, std::memory_order_release);
+        return true;
+    }
+    void InputQueue::flush()
+    {
+        // Motion followed by a transition goes in with it, so the transition is not held back by it
+        int moved = 0;
+        for( ; moved < (int)waiting.size(); moved++)
+        {
+            bool beforeTransition = moved + 1 < (int)waiting.size();
+            if(!write(waiting[moved], beforeTransition))
+                break;
+        }
+        waiting.erase(waiting.begin(), waiting.begin() + moved);
+    }
+    uint32_t InputQueue::getMergedCount() const
+    {
+        return merged;
+    }
+    int InputQueue::getSize() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    int InputQueue::getWaitingCount() const
+    {
+        return waiting.size();
+    }
+    bool InputQueue::pop(InputEvent& event)
+    {
+        uint32_t index = tail.load(std::memory_order_relaxed);
+        if(index == head.load(std::memory_order_acquire))
+            return false;
+        event = events[index & (CAPACITY - 1)];
+        tail.store(index + 1, std::memory_order_release);
+        return true;
+    }
+    void InputQueue::push(const InputEvent& event)
+    {
+        // Events keep their order, so the new one goes into the ring only after all of the waiting ones
+        flush();
+        if(waiting.empty() && write(event, false))
+            return;
+
+        // Motion is added to the motion waiting last, it keeps the time of the older one to measure latency from
+        if(event.type == IE_MOUSE_MOTION && !waiting.empty() && waiting.back().type == IE_MOUSE_MOTION)
+        {
+            InputEvent& last = waiting.back();
+            last.position = event.position;
+            last.motion   = last.motion + event.motion;
+            merged++;
+            return;
+        }
+        waiting.push_back(event);
+    }
+}
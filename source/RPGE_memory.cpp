@@ -0,0 +1,152 @@
+
+#include <RPGE_memory.hpp>
+
+#ifdef RPGE_TRACK_ALLOCATIONS
+    #include <atomic>
+    #include <cstdlib>
+    #include <new>
+
+    static std::atomic<uint64_t> allocationCount(0);
+
+    // Global allocation functions are replaced, so every heap allocation of the program is counted
+    static void* trackedAllocate(std::size_t bytes, bool nothrow)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        void* data = std::malloc(bytes == 0 ? 1 : bytes);
+        if(data == nullptr && !nothrow)
+            throw std::bad_alloc();
+        return data;
+    }
+    void* operator new(std::size_t bytes)                                  { return trackedAllocate(bytes, false); }
+    void* operator new[](std::size_t bytes)                                { return trackedAllocate(bytes, false); }
+    void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept   { return trackedAllocate(bytes, true); }
+    void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept { return trackedAllocate(bytes, true); }
+    void  operator delete(void* data) noexcept                              { std::free(data); }
+    void  operator delete[](void* data) noexcept                            { std::free(data); }
+    void  operator delete(void* data, std::size_t) noexcept                 { std::free(data); }
+    void  operator delete[](void* data, std::size_t) noexcept               { std::free(data); }
+    void  operator delete(void* data, const std::nothrow_t&) noexcept       { std::free(data); }
+    void  operator delete[](void* data, const std::nothrow_t&) noexcept     { std::free(data); }
+#endif
+
+namespace rpge
+{
+    uint64_t getAllocationCount()
+    {
+        #ifdef RPGE_TRACK_ALLOCATIONS
+            return allocationCount.load(std::memory_order_relaxed);
+        #else
+            return 0;
+        #endif
+    }
+    bool isAllocationTracked()
+    {
+        #ifdef RPGE_TRACK_ALLOCATIONS
+            return true;
+        #else
+            return false;
+        #endif
+    }
+
+    /****************************************/
+    /********** CLASS: FRAME ARENA **********/
+    /****************************************/
+
+    const size_t FrameArena::BLOCK_ALIGNMENT = 64;
+
+    FrameArena::FrameArena() : FrameArena(64 * 1024)
+    {
+    }
+    FrameArena::FrameArena(size_t blockSize)
+    {
+        this->blockIndex = 0;
+        this->offset     = 0;
+        this->used       = 0;
+        this->peak       = 0;
+        this->blockSize  = blockSize < 64 ? 64 : blockSize;
+    }
+    FrameArena::~FrameArena()
+    {
+        release();
+    }
+    void FrameArena::addBlock(size_t size)
+    {
+        // Memory returned by new[] is aligned for fundamental types only, the block starts at the first address
+        // aligned more
+        uint8_t* memory = new uint8_t[size + BLOCK_ALIGNMENT - 1];
+        uintptr_t address = ((uintptr_t)memory + BLOCK_ALIGNMENT - 1) & ~(uintptr_t)(BLOCK_ALIGNMENT - 1);
+        blocks.push_back({ memory, (uint8_t*)address, size });
+    }
+    void FrameArena::release()
+    {
+        for(Block& block : blocks)
+            delete[] block.memory;
+        blocks.clear();
+    }
+    void* FrameArena::allocate(size_t bytes, size_t alignment)
+    {
+        while(blockIndex < (int)blocks.size())
+        {
+            // Address is aligned rather than the offset, the block itself is aligned to `BLOCK_ALIGNMENT` only
+            Block& block = blocks[blockIndex];
+            uintptr_t base = (uintptr_t)block.data;
+            size_t start = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+            if(start + bytes <= block.size)
+            {
+                used  += start + bytes - offset;
+                peak   = used > peak ? used : peak;
+                offset = start + bytes;
+                return block.data + start;
+            }
+            // Rest of the block is wasted, count it so the coalesced block is big enough
+            used += block.size - offset;
+            blockIndex++;
+            offset = 0;
+        }
+
+        // Alignments bigger than the one of blocks need some slack
+        size_t size = bytes + (alignment > BLOCK_ALIGNMENT ? alignment : 0);
+        addBlock(size > blockSize ? size : blockSize);
+        blockIndex = blocks.size() - 1;
+        offset = 0;
+        return allocate(bytes, alignment);
+    }
+    size_t FrameArena::getCapacity() const
+    {
+        size_t capacity = 0;
+        for(const Block& block : blocks)
+            capacity += block.size;
+        return capacity;
+    }
+    size_t FrameArena::getPeakUsage() const
+    {
+        return peak;
+    }
+    size_t FrameArena::getUsage() const
+    {
+        return used;
+    }
+    FrameArena::Marker FrameArena::mark() const
+    {
+        return { blockIndex, offset, used };
+    }
+    void FrameArena::reset()
+    {
+        if(blocks.size() > 1)
+        {
+            // Frame needed several blocks, replace them with one so the next frames are served from it alone
+            size_t size = getCapacity() > peak ? getCapacity() : peak;
+            release();
+            addBlock(size);
+        }
+        blockIndex = 0;
+        offset     = 0;
+        used       = 0;
+    }
+    void FrameArena::rewind(const Marker& marker)
+    {
+        blockIndex = marker.blockIndex;
+        offset     = marker.offset;
+        used       = marker.used;
+    }
+}
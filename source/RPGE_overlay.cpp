@@ -0,0 +1,232 @@
+
+#include <algorithm>
+#include <RPGE_overlay.hpp>
+
+namespace rpge
+{
+
+    /*****************************************/
+    /********** CLASS: COST OVERLAY **********/
+    /*****************************************/
+
+    const float CostOverlay::AVERAGE_WEIGHT = 0.1f;
+    const int   CostOverlay::MINIMAP_SIZE   = 256;
+
+    CostOverlay::CostOverlay()
+    {
+        this->heatmapEnabled = false;
+        this->minimapEnabled = false;
+        this->metric         = CM_RAY_STEPS;
+        this->opacity        = 0.5f;
+        this->costScale      = 0;
+        this->maxCost        = -1;
+        this->minimapArea    = { 0, 0, 0, 0 };
+        this->sceneWidth     = 0;
+        this->sceneHeight    = 0;
+        this->maxHeat        = 0;
+        this->minimapWidth   = 0;
+        this->minimapHeight  = 0;
+        this->gridRevision   = 0;
+        this->wallsRevision  = 0;
+    }
+    void CostOverlay::beginFrame(int rayCount, int sceneWidth, int sceneHeight)
+    {
+        rayCosts.resize(rayCount);
+        std::fill(rayCosts.begin(), rayCosts.end(), 0.0f);
+        if(sceneWidth != this->sceneWidth || sceneHeight != this->sceneHeight)
+        {
+            this->sceneWidth  = sceneWidth;
+            this->sceneHeight = sceneHeight;
+            tileHits.assign(sceneWidth * sceneHeight, 0);
+            tileHeat.assign(sceneWidth * sceneHeight, 0.0f);
+            maxHeat = 0;
+
+            // Big scenes are shrunk, every pixel shows a block of tiles
+            minimapWidth  = sceneWidth < MINIMAP_SIZE ? sceneWidth : MINIMAP_SIZE;
+            minimapHeight = sceneHeight < MINIMAP_SIZE ? sceneHeight : MINIMAP_SIZE;
+            minimapColumns.resize(sceneWidth);
+            minimapRows.resize(sceneHeight);
+            for(int x = 0; x < sceneWidth; x++)
+                minimapColumns[x] = (int64_t)x * minimapWidth / sceneWidth;
+            for(int y = 0; y < sceneHeight; y++)
+                minimapRows[y] = (int64_t)(sceneHeight - 1 - y) * minimapHeight / sceneHeight;
+            minimapHeat.assign(minimapWidth * minimapHeight, 0.0f);
+            minimapWalls.assign(minimapWidth * minimapHeight, 0);
+            gridRevision  = 0;
+            wallsRevision = 0;
+        }
+    }
+    void CostOverlay::endFrame()
+    {
+        float frameMax = 0;
+        for(float cost : rayCosts)
+            frameMax = cost > frameMax ? cost : frameMax;
+        maxCost = maxCost < 0 ? frameMax : maxCost + (frameMax - maxCost) * AVERAGE_WEIGHT;
+
+        if(!minimapEnabled)
+            return;
+        maxHeat = 0;
+        std::fill(minimapHeat.begin(), minimapHeat.end(), 0.0f);
+        for(int y = 0; y < sceneHeight; y++)
+        {
+            float* heatRow = minimapHeat.data() + minimapRows[y] * minimapWidth;
+            for(int x = 0; x < sceneWidth; x++)
+            {
+                int t = y * sceneWidth + x;
+                tileHeat[t] += (tileHits[t] - tileHeat[t]) * AVERAGE_WEIGHT;
+                tileHits[t] = 0;
+                maxHeat = tileHeat[t] > maxHeat ? tileHeat[t] : maxHeat;
+                float& pixelHeat = heatRow[minimapColumns[x]];
+                pixelHeat = tileHeat[t] > pixelHeat ? tileHeat[t] : pixelHeat;
+            }
+        }
+    }
+    void CostOverlay::countTileHit(int x, int y)
+    {
+        if(x < 0 || y < 0 || x >= sceneWidth || y >= sceneHeight)
+            return;
+        uint16_t& hits = tileHits[y * sceneWidth + x];
+        hits = hits < UINT16_MAX ? hits + 1 : hits;
+    }
+    void CostOverlay::fillHeatmap(uint32_t* pixels) const
+    {
+        float scale = costScale > 0 ? costScale : maxCost;
+        uint8_t alpha = opacity * 255;
+        for(int r = 0; r < (int)rayCosts.size(); r++)
+            pixels[r] = getHeatColor(scale > 0 ? rayCosts[r] / scale : 0, alpha);
+    }
+    void CostOverlay::fillMinimap(uint32_t* pixels) const
+    {
+        for(int p = 0; p < minimapWidth * minimapHeight; p++)
+        {
+            float heat = minimapHeat[p];
+            if(!minimapWalls[p])
+                pixels[p] = enColor(0, 0, 0, 128);
+            else
+                pixels[p] = maxHeat > 0 && heat > 0.001f ? getHeatColor(heat / maxHeat, 255) : enColor(128, 128, 128, 255);
+        }
+    }
+    void CostOverlay::findMinimapWalls(const Scene& scene)
+    {
+        if(scene.getGridRevision() == gridRevision && scene.getWallsRevision() == wallsRevision)
+            return;
+        gridRevision  = scene.getGridRevision();
+        wallsRevision = scene.getWallsRevision();
+
+        // Whether a tile has walls depends only on its ID, so the walls are looked up once per ID; IDs are small
+        // numbers, the rare big ones are looked up for every tile
+        const int tableSize = 65536;
+        vector<uint8_t> idWalls;
+        for(int id : *scene.getTileIds())
+        {
+            if(id < 0 || id >= tableSize)
+                continue;
+            if(id >= (int)idWalls.size())
+                idWalls.resize(id + 1, 0);
+            idWalls[id] = scene.getTileWalls(id) != nullptr;
+        }
+        std::fill(minimapWalls.begin(), minimapWalls.end(), 0);
+        for(int y = 0; y < sceneHeight; y++)
+        {
+            uint8_t* wallsRow = minimapWalls.data() + minimapRows[y] * minimapWidth;
+            for(int x = 0; x < sceneWidth; x++)
+            {
+                int id = scene.getTileId(x, y);
+                bool walls = id >= 0 && id < (int)idWalls.size() ? idWalls[id] : id >= tableSize && scene.getTileWalls(id) != nullptr;
+                wallsRow[minimapColumns[x]] |= walls;
+            }
+        }
+    }
+    uint32_t CostOverlay::getHeatColor(float t, uint8_t alpha)
+    {
+        // Blue goes to green, then red is added (yellow) and green is taken away
+        t = clamp(t, 0.0f, 1.0f) * 3;
+        if(t < 1)
+            return enColor(0, t * 255, (1 - t) * 255, alpha);
+        if(t < 2)
+            return enColor((t - 1) * 255, 255, 0, alpha);
+        return enColor(255, (3 - t) * 255, 0, alpha);
+    }
+    float CostOverlay::getCostScale() const
+    {
+        return costScale;
+    }
+    SDL_Rect CostOverlay::getMinimapArea() const
+    {
+        return minimapArea;
+    }
+    void CostOverlay::getMinimapSize(int& width, int& height) const
+    {
+        width  = minimapWidth;
+        height = minimapHeight;
+    }
+    CostMetric CostOverlay::getMetric() const
+    {
+        return metric;
+    }
+    float CostOverlay::getOpacity() const
+    {
+        return opacity;
+    }
+    float CostOverlay::getRayCost(int ray) const
+    {
+        return ray >= 0 && ray < (int)rayCosts.size() ? rayCosts[ray] : 0;
+    }
+    int CostOverlay::getRayCount() const
+    {
+        return rayCosts.size();
+    }
+    float CostOverlay::getTileHeat(int x, int y) const
+    {
+        if(x < 0 || y < 0 || x >= sceneWidth || y >= sceneHeight)
+            return 0;
+        return tileHeat[y * sceneWidth + x];
+    }
+    bool CostOverlay::getHottestTile(int& x, int& y) const
+    {
+        int hottest = -1;
+        for(int t = 0; t < (int)tileHeat.size(); t++)
+            if(tileHeat[t] > 0 && (hottest < 0 || tileHeat[t] > tileHeat[hottest]))
+                hottest = t;
+        if(hottest < 0)
+            return false;
+        x = hottest % sceneWidth;
+        y = hottest / sceneWidth;
+        return true;
+    }
+    bool CostOverlay::isHeatmapEnabled() const
+    {
+        return heatmapEnabled;
+    }
+    bool CostOverlay::isMinimapEnabled() const
+    {
+        return minimapEnabled;
+    }
+    bool CostOverlay::isEnabled() const
+    {
+        return heatmapEnabled || minimapEnabled;
+    }
+    void CostOverlay::setRayCost(int ray, float cost)
+    {
+        if(ray >= 0 && ray < (int)rayCosts.size())
+            rayCosts[ray] = cost;
+    }
+    void CostOverlay::setCostScale(float scale)
+    {
+        costScale = scale > 0 ? scale : 0;
+    }
+    void CostOverlay::setHeatmap(bool enabled, CostMetric metric, float opacity)
+    {
+        // Costs of another metric are not comparable with the old average
+        if(metric != this->metric)
+            maxCost = -1;
+        this->heatmapEnabled = enabled;
+        this->metric         = metric;
+        this->opacity        = clamp(opacity, 0.0f, 1.0f);
+    }
+    void CostOverlay::setMinimap(bool enabled, const SDL_Rect& area)
+    {
+        this->minimapEnabled = enabled;
+        this->minimapArea    = area;
+    }
+}
@@ -0,0 +1,126 @@
+
+#include <RPGE_pacer.hpp>
+
+namespace rpge
+{
+
+    /****************************************/
+    /********** CLASS: FRAME PACER **********/
+    /****************************************/
+
+    const int FramePacer::STATS_WINDOW = 120;
+
+    FramePacer::FramePacer() : FramePacer(60)
+    {
+    }
+    FramePacer::FramePacer(int fps)
+    {
+        this->maxLagFrames = 4;
+        this->spinWindow   = duration<double>(0.0015);
+        this->samples      = vector<float>(STATS_WINDOW, 0);
+        setFrameRate(fps);
+        reset();
+    }
+    void FramePacer::reset()
+    {
+        started     = false;
+        stallCount  = 0;
+        sampleIndex = 0;
+        sampleCount = 0;
+    }
+    void FramePacer::setFrameRate(int fps)
+    {
+        period = duration<double>(1.0 / (fps < 1 ? 1 : fps));
+    }
+    void FramePacer::setMaxLag(int frames)
+    {
+        maxLagFrames = frames < 1 ? 1 : frames;
+    }
+    void FramePacer::setSpinWindow(float seconds)
+    {
+        spinWindow = duration<double>(seconds < 0 ? 0 : seconds);
+    }
+    int FramePacer::getStallCount() const
+    {
+        return stallCount;
+    }
+    float FramePacer::getAverageInterval() const
+    {
+        if(sampleCount == 0)
+            return 0;
+        float sum = 0;
+        for(int i = 0; i < sampleCount; i++)
+            sum += samples[i];
+        return sum / sampleCount;
+    }
+    float FramePacer::getJitter() const
+    {
+        if(sampleCount < 2)
+            return 0;
+        float mean = getAverageInterval();
+        float sum = 0;
+        for(int i = 0; i < sampleCount; i++)
+            sum += (samples[i] - mean) * (samples[i] - mean);
+        return sqrtf(sum / (sampleCount - 1));
+    }
+    float FramePacer::getMaxInterval() const
+    {
+        float result = 0;
+        for(int i = 0; i < sampleCount; i++)
+            result = samples[i] > result ? samples[i] : result;
+        return result;
+    }
+    float FramePacer::getMinInterval() const
+    {
+        if(sampleCount == 0)
+            return 0;
+        float result = samples[0];
+        for(int i = 1; i < sampleCount; i++)
+            result = samples[i] < result ? samples[i] : result;
+        return result;
+    }
+    float FramePacer::wait()
+    {
+        return wait(true);
+    }
+    float FramePacer::wait(bool recorded)
+    {
+        time_point<steady_clock> now = steady_clock::now();
+        if(!started)
+        {
+            started   = true;
+            deadline  = now + std::chrono::duration_cast<steady_clock::duration>(period);
+            lastFrame = now;
+            return 0;
+        }
+
+        if(now > deadline + std::chrono::duration_cast<steady_clock::duration>(period * maxLagFrames))
+        {
+            // Too far behind, start a new schedule instead of rushing frames
+            deadline = now;
+            stallCount++;
+        }
+        else
+        {
+            // Sleep through most of the time left, then spin so the deadline is met precisely
+            time_point<steady_clock> wakeUp = deadline - std::chrono::duration_cast<steady_clock::duration>(spinWindow);
+            if(now < wakeUp)
+                std::this_thread::sleep_until(wakeUp);
+            while(steady_clock::now() < deadline)
+                ;
+        }
+
+        now = steady_clock::now();
+        duration<float> interval = now - lastFrame;
+        lastFrame = now;
+        deadline += std::chrono::duration_cast<steady_clock::duration>(period);
+
+        if(recorded)
+        {
+            samples[sampleIndex] = interval.count();
+            sampleIndex = (sampleIndex + 1) % STATS_WINDOW;
+            sampleCount = sampleCount < STATS_WINDOW ? sampleCount + 1 : STATS_WINDOW;
+        }
+        return interval.count();
+    }
+}
@@ -0,0 +1,243 @@
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <RPGE_palette.hpp>
+
+// Returns color `color` (ARGB8888) with 5 bits per channel, red in the highest bits
+static inline int colorKey(uint32_t color)
+{
+    return ((color >> 9) & 0x7c00) | ((color >> 6) & 0x3e0) | ((color >> 3) & 0x1f);
+}
+// Returns channel `channel` (0 red, 1 green, 2 blue) of color `key` made by `colorKey`, widened back to 8 bits and taken
+// at the middle of the range it covers
+static inline int keyChannel(int key, int channel)
+{
+    return (((key >> (10 - channel * 5)) & 31) << 3) | 4;
+}
+
+namespace rpge
+{
+
+    /************************************/
+    /********** CLASS: PALETTE **********/
+    /************************************/
+
+    const int Palette::TRANSPARENT_INDEX = 0;
+    const int Palette::ALPHA_THRESHOLD   = 128;
+
+    vector<uint8_t> Palette::findNearest(const uint32_t* colors, int count)
+    {
+        vector<uint8_t> nearest(32768);
+        for(int key = 0; key < 32768; key++)
+        {
+            int r = keyChannel(key, 0), g = keyChannel(key, 1), b = keyChannel(key, 2);
+            int best = TRANSPARENT_INDEX, bestDistance = INT_MAX;
+            for(int i = 1; i < count; i++)
+            {
+                int dr = r - (int)((colors[i] >> 16) & 255);
+                int dg = g - (int)((colors[i] >> 8) & 255);
+                int db = b - (int)(colors[i] & 255);
+                int distance = dr * dr + dg * dg + db * db;
+                if(distance < bestDistance)
+                {
+                    best = i;
+                    bestDistance = distance;
+                }
+            }
+            nearest[key] = best;
+        }
+        return nearest;
+    }
+    Palette::Palette()
+    {
+        this->count = 1;
+        this->colors[TRANSPARENT_INDEX] = 0;
+        for(int r = 0; r < 6; r++)
+            for(int g = 0; g < 7; g++)
+                for(int b = 0; b < 6; b++)
+                    this->colors[this->count++] = enColor(r * 255 / 5, g * 255 / 6, b * 255 / 5, 255);
+        for(int i = this->count; i < 256; i++)
+            this->colors[i] = 0;
+        // Every palette made this way has the same colors, so their table is found once
+        static const vector<uint8_t> defaultNearest = findNearest(this->colors, this->count);
+        this->nearest = defaultNearest;
+    }
+    Palette::Palette(const uint32_t* colors, int count)
+    {
+        this->count = clamp(count, 0, 255) + 1;
+        this->colors[TRANSPARENT_INDEX] = 0;
+        for(int i = 1; i < 256; i++)
+            this->colors[i] = i < this->count ? colors[i - 1] | 0xff000000 : 0;
+        this->nearest = findNearest(this->colors, this->count);
+    }
+    Palette Palette::fromPixels(const uint32_t* pixels, int pixelCount, int count)
+    {
+        count = clamp(count, 1, 255);
+
+        // Colors are counted with 5 bits per channel, which is the precision of the closest colors table anyway
+        vector<int> histogram(32768, 0);
+        for(int p = 0; p < pixelCount; p++)
+            if((int)(pixels[p] >> 24) >= ALPHA_THRESHOLD)
+                histogram[colorKey(pixels[p])]++;
+        vector<int> keys;
+        for(int key = 0; key < 32768; key++)
+            if(histogram[key] > 0)
+                keys.push_back(key);
+
+        // Boxes are ranges of the keys, the most populated box having more than one color gets split at the median of
+        // its widest channel until there are enough of them
+        struct Box {
+            int  begin, end;
+            long population;
+        };
+        auto makeBox = [&](int begin, int end) {
+            long population = 0;
+            for(int k = begin; k < end; k++)
+                population += histogram[keys[k]];
+            return Box{ begin, end, population };
+        };
+        vector<Box> boxes;
+        if(!keys.empty())
+            boxes.push_back(makeBox(0, keys.size()));
+        while((int)boxes.size() < count)
+        {
+            int split = -1;
+            for(int b = 0; b < (int)boxes.size(); b++)
+                if(boxes[b].end - boxes[b].begin > 1 && (split < 0 || boxes[b].population > boxes[split].population))
+                    split = b;
+            if(split < 0)
+                break;
+
+            Box box = boxes[split];
+            int widest = 0, widestRange = -1;
+            for(int channel = 0; channel < 3; channel++)
+            {
+                int low = 255, high = 0;
+                for(int k = box.begin; k < box.end; k++)
+                {
+                    low  = std::min(low, keyChannel(keys[k], channel));
+                    high = std::max(high, keyChannel(keys[k], channel));
+                }
+                if(high - low > widestRange)
+                {
+                    widest = channel;
+                    widestRange = high - low;
+                }
+            }
+            std::sort(keys.begin() + box.begin, keys.begin() + box.end, [&](int a, int b) {
+                return keyChannel(a, widest) < keyChannel(b, widest);
+            });
+            int median = box.begin + 1;
+            long below = histogram[keys[box.begin]];
+            while(median < box.end - 1 && below * 2 < box.population)
+                below += histogram[keys[median++]];
+            boxes[split] = makeBox(box.begin, median);
+            boxes.push_back(makeBox(median, box.end));
+        }
+
+        // Every box becomes average of its colors
+        vector<uint32_t> colors;
+        for(const Box& box : boxes)
+        {
+            long sums[3] = { 0, 0, 0 };
+            for(int k = box.begin; k < box.end; k++)
+                for(int channel = 0; channel < 3; channel++)
+                    sums[channel] += (long)keyChannel(keys[k], channel) * histogram[keys[k]];
+            colors.push_back(enColor(sums[0] / box.population, sums[1] / box.population, sums[2] / box.population, 255));
+        }
+        return Palette(colors.data(), colors.size());
+    }
+    uint32_t Palette::getColor(int index) const
+    {
+        return index >= 0 && index < 256 ? colors[index] : 0;
+    }
+    int Palette::getColorCount() const
+    {
+        return count;
+    }
+    const uint32_t* Palette::getColors() const
+    {
+        return colors;
+    }
+    uint8_t Palette::getIndex(uint32_t color) const
+    {
+        if((int)(color >> 24) < ALPHA_THRESHOLD)
+            return TRANSPARENT_INDEX;
+        return nearest[colorKey(color)];
+    }
+    void Palette::quantize(const uint32_t* pixels, int width, int height, int pitch, uint8_t* indices, int indexPitch) const
+    {
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++)
+                indices[y * indexPitch + x] = getIndex(pixels[y * pitch + x]);
+    }
+
+    /*************************************/
+    /********** CLASS: COLORMAP **********/
+    /*************************************/
+
+    const int Colormap::SHADE_LEVELS = 32;
+    const int Colormap::FOG_LEVELS   = 16;
+
+    uint32_t Colormap::mix(uint32_t color, int shade, int fog) const
+    {
+        uint32_t result = color & 0xff000000;
+        for(int shift = 0; shift < 24; shift += 8)
+        {
+            uint32_t channel = ((color >> shift) & 255) * (255 - shade) / 255;
+            channel = (channel * (256 - fog) + ((fogColor >> shift) & 255) * fog) >> 8;
+            result |= channel << shift;
+        }
+        return result;
+    }
+    Colormap::Colormap()
+    {
+        memset(this->colors, 0, sizeof(this->colors));
+        this->fogged   = false;
+        this->fogColor = 0;
+        this->fogStart = 0;
+        this->fogScale = 0;
+    }
+    uint32_t Colormap::apply(uint32_t color, int shadeLevel, int fogLevel) const
+    {
+        return mix(color, shadeLevel * 255 / (SHADE_LEVELS - 1), fogged ? fogLevel * 256 / (FOG_LEVELS - 1) : 0);
+    }
+    int Colormap::getFogLevel(float depth) const
+    {
+        if(!fogged)
+            return 0;
+        return clamp((depth - fogStart) * fogScale + 0.5f, 0.0f, (float)(FOG_LEVELS - 1));
+    }
+    const uint32_t* Colormap::getRow(int shadeLevel, int fogLevel) const
+    {
+        return rows.data() + (fogLevel * SHADE_LEVELS + shadeLevel) * 256;
+    }
+    int Colormap::getShadeLevel(int shade)
+    {
+        return (clamp(shade, 0, 255) * (SHADE_LEVELS - 1) + 127) / 255;
+    }
+    void Colormap::update(const Palette& palette, bool fogged, uint32_t fogColor, float fogStart, float fogEnd)
+    {
+        float fogScale = (FOG_LEVELS - 1) / (fogEnd > fogStart ? fogEnd - fogStart : 0.0001f);
+        if(!rows.empty() && memcmp(colors, palette.getColors(), sizeof(colors)) == 0 && fogged == this->fogged
+           && (!fogged || (fogColor == this->fogColor && fogStart == this->fogStart && fogScale == this->fogScale)))
+            return;
+
+        memcpy(this->colors, palette.getColors(), sizeof(this->colors));
+        this->fogged   = fogged;
+        this->fogColor = fogColor;
+        this->fogStart = fogStart;
+        this->fogScale = fogScale;
+
+        int fogLevels = fogged ? FOG_LEVELS : 1;
+        rows.resize(fogLevels * SHADE_LEVELS * 256);
+        for(int f = 0; f < fogLevels; f++)
+            for(int s = 0; s < SHADE_LEVELS; s++)
+            {
+                uint32_t* row = rows.data() + (f * SHADE_LEVELS + s) * 256;
+                for(int i = 0; i < 256; i++)
+                    row[i] = apply(colors[i], s, f);
+            }
+    }
+}
@@ -0,0 +1,269 @@
+
+#include <RPGE_post.hpp>
+#include <RPGE_trace.hpp>
+
+// Pass -> Name of its spans in traces
+static const char* const PASS_NAMES[rpge::PP_COUNT] = { "fog pass", "lut pass", "gamma pass", "vignette pass" };
+
+// Mixes pixel `pixel` with color `color` channel by channel, `factor` goes from 0 (pixel stays) to 256 (color only)
+static inline uint32_t mixPixel(uint32_t pixel, int factor, uint32_t color)
+{
+    uint32_t result = 0;
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t a = (pixel >> shift) & 255;
+        uint32_t b = (color >> shift) & 255;
+        result |= ((a * (256 - factor) + b * factor) >> 8) << shift;
+    }
+    return result;
+}
+
+#ifdef RPGE_SIMD_SSE
+    // Does what `mixPixel` does for 4 pixels at once, `factors` are 32-bit integers and `color` has its channels
+    // widened to 16 bits (two pixels per register)
+    static inline __m128i mixPixels(__m128i pixels, __m128i factors, __m128i color)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(256);
+
+        // Every factor is repeated for all 4 channels of its pixel
+        __m128i halves      = _mm_packs_epi32(factors, factors);
+        __m128i pairs       = _mm_unpacklo_epi16(halves, halves);
+        __m128i lowFactors  = _mm_unpacklo_epi32(pairs, pairs);
+        __m128i highFactors = _mm_unpackhi_epi32(pairs, pairs);
+
+        // Neither product nor their sum exceeds 16 bits, since channels are below 256 and factors sum up to 256
+        __m128i low  = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        low  = _mm_add_epi16(_mm_mullo_epi16(low, _mm_sub_epi16(full, lowFactors)), _mm_mullo_epi16(color, lowFactors));
+        high = _mm_add_epi16(_mm_mullo_epi16(high, _mm_sub_epi16(full, highFactors)), _mm_mullo_epi16(color, highFactors));
+        return _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+    }
+#endif
+
+namespace rpge
+{
+
+    /*******************************************/
+    /********** CLASS: POST PROCESSOR **********/
+    /*******************************************/
+
+    const int   PostProcessor::ROW_GRAIN      = 16;
+    const float PostProcessor::AVERAGE_WEIGHT = 0.1f;
+
+    PostProcessor::PostProcessor()
+    {
+        for(int p = 0; p < PP_COUNT; p++)
+        {
+            this->enabled[p]   = false;
+            this->passTimes[p] = -1;
+        }
+        for(int v = 0; v < 256; v++)
+        {
+            this->lut[0][v]    = v;
+            this->lut[1][v]    = v;
+            this->lut[2][v]    = v;
+            this->gammaLut[v]  = v;
+        }
+        this->fogColor         = enColor(0, 0, 0, 255);
+        this->fogStart         = 0;
+        this->fogEnd           = 1;
+        this->gamma            = 1;
+        this->vignetteStrength = 0;
+        this->pool             = nullptr;
+    }
+    void PostProcessor::applyFog(Framebuffer& fb, int rowStart, int rowEnd) const
+    {
+        const int width   = fb.getWidth();
+        const float scale = 256 / (fogEnd - fogStart);
+        for(int y = rowStart; y < rowEnd; y++)
+        {
+            uint32_t* row      = fb.getRow(y);
+            const float* depth = fb.getDepthRow(y);
+            int x = 0;
+            #ifdef RPGE_SIMD_SSE
+            const __m128i color = _mm_unpacklo_epi8(_mm_set1_epi32(fogColor), _mm_setzero_si128());
+            for( ; x + 4 <= width; x += 4)
+            {
+                // Infinite depth (nothing seen) gets the whole fog too
+                Floatx4 amount = min(max((Floatx4::load(depth + x) - Floatx4(fogStart)) * Floatx4(scale), Floatx4(0)), Floatx4(256));
+                __m128i pixels = _mm_loadu_si128((const __m128i*)(row + x));
+                _mm_storeu_si128((__m128i*)(row + x), mixPixels(pixels, _mm_cvttps_epi32(amount.v), color));
+            }
+            #endif
+            for( ; x < width; x++)
+                row[x] = mixPixel(row[x], clamp((depth[x] - fogStart) * scale, 0.0f, 256.0f), fogColor);
+        }
+    }
+    void PostProcessor::applyGamma(Framebuffer& fb, int rowStart, int rowEnd) const
+    {
+        const int width = fb.getWidth();
+        for(int y = rowStart; y < rowEnd; y++)
+        {
+            uint32_t* row = fb.getRow(y);
+            for(int x = 0; x < width; x++)
+            {
+                uint32_t pixel = row[x];
+                row[x] = (pixel & 0xff000000) | (gammaLut[(pixel >> 16) & 255] << 16) | (gammaLut[(pixel >> 8) & 255] << 8)
+                       | gammaLut[pixel & 255];
+            }
+        }
+    }
+    void PostProcessor::applyLut(Framebuffer& fb, int rowStart, int rowEnd) const
+    {
+        const int width = fb.getWidth();
+        for(int y = rowStart; y < rowEnd; y++)
+        {
+            uint32_t* row = fb.getRow(y);
+            for(int x = 0; x < width; x++)
+            {
+                uint32_t pixel = row[x];
+                row[x] = (pixel & 0xff000000) | (lut[0][(pixel >> 16) & 255] << 16) | (lut[1][(pixel >> 8) & 255] << 8)
+                       | lut[2][pixel & 255];
+            }
+        }
+    }
+    void PostProcessor::applyVignette(Framebuffer& fb, int rowStart, int rowEnd) const
+    {
+        const int width    = fb.getWidth();
+        const float height = fb.getHeight();
+        // Corners are at squared distance of 2, that is where the strength applies fully
+        const float scale = vignetteStrength / 2 * 256;
+        for(int y = rowStart; y < rowEnd; y++)
+        {
+            uint32_t* row = fb.getRow(y);
+            float rowY = 2 * (y + 0.5f) / height - 1;
+            float rowTerm = rowY * rowY;
+            int x = 0;
+            #ifdef RPGE_SIMD_SSE
+            const __m128i black = _mm_setzero_si128();
+            for( ; x + 4 <= width; x += 4)
+            {
+                Floatx4 amount = min((Floatx4::load(vignetteColumns.data() + x) + Floatx4(rowTerm)) * Floatx4(scale), Floatx4(256));
+                __m128i pixels = _mm_loadu_si128((const __m128i*)(row + x));
+                _mm_storeu_si128((__m128i*)(row + x), mixPixels(pixels, _mm_cvttps_epi32(amount.v), black));
+            }
+            #endif
+            for( ; x < width; x++)
+                row[x] = mixPixel(row[x], clamp((vignetteColumns[x] + rowTerm) * scale, 0.0f, 256.0f), 0);
+        }
+    }
+    void PostProcessor::runPass(int pass, Framebuffer& fb, void (PostProcessor::*kernel)(Framebuffer&, int, int) const)
+    {
+        RPGE_TRACE_SCOPE(PASS_NAMES[pass]);
+        steady_clock::time_point start = steady_clock::now();
+        if(pool != nullptr)
+        {
+            pool->run(fb.getHeight(), ROW_GRAIN, [&](int begin, int end) {
+                (this->*kernel)(fb, begin, end);
+            });
+        }
+        else
+            (this->*kernel)(fb, 0, fb.getHeight());
+
+        duration<float> time = steady_clock::now() - start;
+        float& average = passTimes[pass];
+        average = average < 0 ? time.count() : average + (time.count() - average) * AVERAGE_WEIGHT;
+    }
+    uint32_t PostProcessor::getFogColor() const
+    {
+        return fogColor;
+    }
+    float PostProcessor::getFogEnd() const
+    {
+        return fogEnd;
+    }
+    float PostProcessor::getFogStart() const
+    {
+        return fogStart;
+    }
+    float PostProcessor::getPassTime(int pass) const
+    {
+        if(pass < 0 || pass >= PP_COUNT)
+            return -1;
+        return passTimes[pass];
+    }
+    float PostProcessor::getTotalTime() const
+    {
+        float total = 0;
+        for(int p = 0; p < PP_COUNT; p++)
+            if(enabled[p] && passTimes[p] > 0)
+                total += passTimes[p];
+        return total;
+    }
+    bool PostProcessor::isEnabled() const
+    {
+        for(int p = 0; p < PP_COUNT; p++)
+            if(enabled[p])
+                return true;
+        return false;
+    }
+    bool PostProcessor::isPassEnabled(int pass) const
+    {
+        return pass >= 0 && pass < PP_COUNT && enabled[pass];
+    }
+    void PostProcessor::process(Framebuffer& fb)
+    {
+        process(fb, 0);
+    }
+    void PostProcessor::process(Framebuffer& fb, int skipped)
+    {
+        if(fb.getWidth() == 0 || fb.getHeight() == 0)
+            return;
+
+        // Distances of the columns from the center do not change until the framebuffer gets resized
+        if(enabled[PP_VIGNETTE] && (int)vignetteColumns.size() != fb.getWidth())
+        {
+            vignetteColumns.resize(fb.getWidth());
+            for(int x = 0; x < fb.getWidth(); x++)
+            {
+                float columnX = 2 * (x + 0.5f) / fb.getWidth() - 1;
+                vignetteColumns[x] = columnX * columnX;
+            }
+        }
+
+        if(enabled[PP_FOG] && !(skipped & (1 << PP_FOG)))
+            runPass(PP_FOG, fb, &PostProcessor::applyFog);
+        if(enabled[PP_LUT] && !(skipped & (1 << PP_LUT)))
+            runPass(PP_LUT, fb, &PostProcessor::applyLut);
+        if(enabled[PP_GAMMA] && !(skipped & (1 << PP_GAMMA)))
+            runPass(PP_GAMMA, fb, &PostProcessor::applyGamma);
+        if(enabled[PP_VIGNETTE] && !(skipped & (1 << PP_VIGNETTE)))
+            runPass(PP_VIGNETTE, fb, &PostProcessor::applyVignette);
+    }
+    void PostProcessor::setColorLut(bool enabled, const uint8_t* red, const uint8_t* green, const uint8_t* blue)
+    {
+        this->enabled[PP_LUT] = enabled && red != nullptr && green != nullptr && blue != nullptr;
+        if(!this->enabled[PP_LUT])
+            return;
+        for(int v = 0; v < 256; v++)
+        {
+            lut[0][v] = red[v];
+            lut[1][v] = green[v];
+            lut[2][v] = blue[v];
+        }
+    }
+    void PostProcessor::setFog(bool enabled, uint8_t r, uint8_t g, uint8_t b, float start, float end)
+    {
+        this->enabled[PP_FOG] = enabled;
+        this->fogColor = enColor(r, g, b, 255);
+        this->fogStart = start;
+        this->fogEnd   = end > start ? end : start + 0.0001f;
+    }
+    void PostProcessor::setGamma(float gamma)
+    {
+        this->gamma = gamma > 0 ? gamma : 1;
+        this->enabled[PP_GAMMA] = this->gamma != 1;
+        for(int v = 0; v < 256; v++)
+            gammaLut[v] = clamp(powf(v / 255.0f, 1 / this->gamma) * 255 + 0.5f, 0.0f, 255.0f);
+    }
+    void PostProcessor::setVignette(float strength)
+    {
+        this->vignetteStrength = strength > 0 ? strength : 0;
+        this->enabled[PP_VIGNETTE] = vignetteStrength > 0;
+    }
+    void PostProcessor::setWorkerPool(WorkerPool* pool)
+    {
+        this->pool = pool;
+    }
+}
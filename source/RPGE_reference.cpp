@@ -0,0 +1,211 @@
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <RPGE_pixel.hpp>
+#include <RPGE_reference.hpp>
+
+namespace rpge
+{
+    using ::std::vector;
+
+    // Wall line seen by one column, from the nearest one
+    struct ReferenceLine {
+        const WallData*     wall;
+        float               perpDist;
+        float               u;
+        int                 drawStart;
+        int                 drawEnd;
+        const SDL_Surface*  surface;  // Texture pixels, null pointer for walls drawn with their color
+        uint8_t             shade;
+        bool                flipped;  // Whether the wall is seen from its back
+    };
+
+    // Returns color of line `line` at screen row `y`, texels are picked at the pixel center like the engine does
+    static uint32_t sampleLine(const ReferenceLine& line, int y, const Palette& palette)
+    {
+        if(line.surface == nullptr)
+            return line.wall->tint;
+        const SDL_Surface* surface = line.surface;
+        float texX    = line.flipped ? 1 - line.u : line.u;
+        int texColumn = clamp((int)(surface->w * texX), 0, surface->w - 1);
+        float texStep = surface->h / (float)(line.drawEnd - line.drawStart);
+        int texRow    = clamp((int)((y + 0.5f - line.drawStart) * texStep), 0, surface->h - 1);
+        const uint8_t* row = (const uint8_t*)surface->pixels + texRow * surface->pitch;
+        if(surface->format->format == SDL_PIXELFORMAT_INDEX8)
+            return palette.getColor(row[texColumn]);
+        return ((const uint32_t*)row)[texColumn];
+    }
+
+    /***************************************************/
+    /********** STRUCTURE: REFERENCE SETTINGS **********/
+    /***************************************************/
+
+    ReferenceSettings::ReferenceSettings()
+    {
+        this->width        = 640;
+        this->height       = 480;
+        this->clearColor   = enColor(0, 0, 0, 255);
+        this->lightEnabled = false;
+        this->lightAngle   = 0;
+    }
+
+    /***********************************************/
+    /********** CLASS: REFERENCE RENDERER **********/
+    /***********************************************/
+
+    ReferenceRenderer::ReferenceRenderer(const ReferenceSettings& settings)
+    {
+        this->settings = settings;
+        this->settings.width  = settings.width > 1 ? settings.width : 1;
+        this->settings.height = settings.height > 1 ? settings.height : 1;
+    }
+    int ReferenceRenderer::compare(const uint32_t* expected, const uint32_t* actual, int count, int tolerance,
+                                   uint32_t* diff)
+    {
+        int differing = 0;
+        for(int i = 0; i < count; i++)
+        {
+            int largest = 0;
+            for(int shift = 0; shift < 24; shift += 8)
+            {
+                int delta = abs((int)((expected[i] >> shift) & 255) - (int)((actual[i] >> shift) & 255));
+                largest = delta > largest ? delta : largest;
+            }
+            bool differs = largest > tolerance;
+            differing += differs;
+            if(diff == nullptr)
+                continue;
+            if(differs)
+                diff[i] = enColor(64 + largest * 191 / 255, 0, 0, 255);
+            else
+            {
+                int gray = (((expected[i] >> 16) & 255) + ((expected[i] >> 8) & 255) + (expected[i] & 255)) / 12;
+                diff[i] = enColor(gray, gray, gray, 255);
+            }
+        }
+        return differing;
+    }
+    const ReferenceSettings& ReferenceRenderer::getSettings() const
+    {
+        return settings;
+    }
+    void ReferenceRenderer::render(const Scene& scene, const Camera& camera, Framebuffer& fb) const
+    {
+        const int width  = settings.width;
+        const int height = settings.height;
+        fb.resize(width, height);
+        for(int y = 0; y < height; y++)
+        {
+            std::fill(fb.getRow(y), fb.getRow(y) + width, settings.clearColor | 0xff000000);
+            std::fill(fb.getDepthRow(y), fb.getDepthRow(y) + width, INFINITY);
+        }
+
+        // Wall of height 1 seen orthogonally from this distance fills the whole frame height
+        const float pcmDist    = 1 / (2 * tan(camera.getFieldOfView() / 2));
+        const Vector2 camPos   = camera.getPosition();
+        const Vector2 camDir   = camera.getDirection();
+        const Vector2 planeVec = camera.getPlane();
+        const Vector2 lightDir = Vector2::RIGHT.rotate(settings.lightAngle);
+        const Palette& palette = scene.getTexturePalette();
+
+        vector<ReferenceLine> lines;
+        vector<ReferenceLine> tileLines;
+        for(int x = 0; x < width; x++)
+        {
+            // Ray goes through the left edge of the column on the camera plane
+            Vector2 rayDir = (camDir + planeVec * (2 * x / (float)width - 1)).normalized();
+
+            // Walk the tiles the ray crosses, nearest first
+            int tileX = floorf(camPos.x);
+            int tileY = floorf(camPos.y);
+            int stepX = rayDir.x < 0 ? -1 : 1;
+            int stepY = rayDir.y < 0 ? -1 : 1;
+            float deltaX = rayDir.x != 0 ? fabsf(1 / rayDir.x) : INFINITY;
+            float deltaY = rayDir.y != 0 ? fabsf(1 / rayDir.y) : INFINITY;
+            float sideX  = rayDir.x != 0 ? (rayDir.x < 0 ? camPos.x - tileX : tileX + 1 - camPos.x) * deltaX : INFINITY;
+            float sideY  = rayDir.y != 0 ? (rayDir.y < 0 ? camPos.y - tileY : tileY + 1 - camPos.y) * deltaY : INFINITY;
+            bool stopped = false;
+            lines.clear();
+            while(!stopped && scene.checkPosition(tileX, tileY))
+            {
+                const vector<WallData>* walls = scene.getTileWalls(scene.getTileId(tileX, tileY));
+                Vector2 tile(tileX, tileY);
+                tileLines.clear();
+                for(int i = 0; walls != nullptr && i < (int)walls->size(); i++)
+                {
+                    const WallData& wall = walls->at(i);
+                    float dist, u;
+                    if(!wall.intersect(camPos - tile, rayDir, dist, u))
+                        continue;
+
+                    ReferenceLine line;
+                    line.wall     = &wall;
+                    line.perpDist = rayDir.dot(camDir) * dist;
+                    line.u        = u;
+                    line.flipped  = rayDir.dot(wall.normal) > 0;
+
+                    float lineHeight = height * (pcmDist / line.perpDist);
+                    line.drawStart = floorf((height - lineHeight) / 2 + lineHeight * (1 - wall.hMax));
+                    line.drawEnd   = floorf((height + lineHeight) / 2 - lineHeight * wall.hMin);
+
+                    line.surface = scene.getTextureSurface(wall.texId);
+                    Vector2 normal = wall.normal * (line.flipped ? -1 : 1);
+                    line.shade = settings.lightEnabled ? (normal.dot(lightDir) + 1.0f) / 2.0f * 128 : 0;
+                    tileLines.push_back(line);
+                }
+
+                // Walls of the tile are seen from the nearest one, the first stopping the ray hides the rest
+                std::stable_sort(tileLines.begin(), tileLines.end(), [](const ReferenceLine& a, const ReferenceLine& b) {
+                    return a.perpDist < b.perpDist;
+                });
+                for(const ReferenceLine& line : tileLines)
+                {
+                    lines.push_back(line);
+                    if(line.wall->stopsRay)
+                    {
+                        stopped = true;
+                        break;
+                    }
+                }
+
+                if(sideX < sideY)
+                {
+                    sideX += deltaX;
+                    tileX += stepX;
+                }
+                else
+                {
+                    sideY += deltaY;
+                    tileY += stepY;
+                }
+            }
+
+            // Every pixel blends the lines covering it from the farthest one, those behind an opaque sample are hidden
+            for(int y = 0; y < height; y++)
+            {
+                int last = -1;
+                for(int i = 0; i < (int)lines.size(); i++)
+                {
+                    if(y < lines[i].drawStart || y >= lines[i].drawEnd)
+                        continue;
+                    if(last < 0)
+                        fb.getDepthRow(y)[x] = lines[i].perpDist;
+                    last = i;
+                    if((sampleLine(lines[i], y, palette) >> 24) == 255)
+                        break;
+                }
+                uint32_t& pixel = fb.getRow(y)[x];
+                for(int i = last; i >= 0; i--)
+                {
+                    if(y < lines[i].drawStart || y >= lines[i].drawEnd)
+                        continue;
+                    // Blended, then darkened by black of the line shade
+                    uint32_t source = sampleLine(lines[i], y, palette);
+                    int alpha = source >> 24;
+                    pixel = shadePixel(alpha == 255 ? source : blendPixel(pixel, source, alpha), lines[i].shade);
+                }
+            }
+        }
+    }
+}
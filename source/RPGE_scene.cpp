@@ -1,18 +1,78 @@
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <RPGE_scene.hpp>
+#include <RPGE_dda.hpp>
+#include <RPGE_trace.hpp>
+#include <RPGE_visibility.hpp>
 
 namespace rpge
 {
+    using ::std::chrono::duration;
+    using ::std::chrono::steady_clock;
 
     /******************************************/
     /********** STRUCTURE: WALL DATA **********/
     /******************************************/
 
+    // Clips segment going from `start` to `end` to the domain and values ranges of `ranges` (Liang-Barsky algorithm),
+    // returns false when no part of the segment is inside them. Clipped ends are put exactly on the range boundaries.
+    static bool clipToRanges(Vector2& start, Vector2& end, const LinearFunc& ranges)
+    {
+        Vector2 delta = end - start;
+        float tStart = 0, tEnd = 1;
+        int sideStart = -1, sideEnd = -1;
+
+        // Point at `t` is inside the boundary `i` when p[i] * t <= q[i]
+        float p[4] = { -delta.x, delta.x, -delta.y, delta.y };
+        float q[4] = { start.x - ranges.xMin, ranges.xMax - start.x, start.y - ranges.yMin, ranges.yMax - start.y };
+        for(int i = 0; i < 4; i++)
+        {
+            if(p[i] == 0)
+            {
+                if(q[i] < 0)
+                    return false;
+                continue;
+            }
+            float t = q[i] / p[i];
+            if(p[i] < 0 && t > tStart)
+            {
+                tStart = t;
+                sideStart = i;
+            }
+            else if(p[i] > 0 && t < tEnd)
+            {
+                tEnd = t;
+                sideEnd = i;
+            }
+        }
+        if(tStart > tEnd)
+            return false;
+
+        Vector2 clipped[2] = { start + delta * tStart, start + delta * tEnd };
+        int sides[2] = { sideStart, sideEnd };
+        for(int i = 0; i < 2; i++)
+        {
+            if(sides[i] == 0) clipped[i].x = ranges.xMin;
+            if(sides[i] == 1) clipped[i].x = ranges.xMax;
+            if(sides[i] == 2) clipped[i].y = ranges.yMin;
+            if(sides[i] == 3) clipped[i].y = ranges.yMax;
+        }
+        start = clipped[0];
+        end = clipped[1];
+        return true;
+    }
+
     WallData::WallData()
     {
         this->func = LinearFunc();
-        this->pivot = Vector2::ZERO;
+        this->start = Vector2::ZERO;
+        this->end = Vector2::ZERO;
+        this->dir = Vector2::ZERO;
+        this->normal = Vector2::ZERO;
         this->length = 0;
+        this->invLength = 0;
         this->hMin = 0;
         this->hMax = 1;
         this->tint = 0;
@@ -29,117 +89,521 @@ namespace rpge
         this->stopsRay = stopsRay;
         updateMetrics();
     }
+    WallData::WallData(const Vector2& start, const Vector2& end, const uint32_t& tint, float hMin, float hMax, uint16_t texId, bool stopsRay)
+        : WallData(LinearFunc(), tint, hMin, hMax, texId, stopsRay)
+    {
+        setSegment(start, end);
+    }
+    bool WallData::intersect(const Vector2& localEnter, const Vector2& direction, float& distance, float& u) const
+    {
+        // Distance along the ray to the wall line. Rays parallel to the wall and walls of no length (zero normal)
+        // give infinite or NaN distance, which fails the checks below, so they need no special treatment.
+        distance = (start - localEnter).dot(normal) / direction.dot(normal);
+        u = (localEnter + direction * distance - start).dot(dir) * invLength;
+        return (distance >= 0) & (u >= 0) & (u <= 1);
+    }
+    void WallData::setSegment(const Vector2& start, const Vector2& end)
+    {
+        this->start = start;
+        this->end = end;
+
+        Vector2 delta = end - start;
+        length = delta.magnitude();
+        invLength = length == 0 ? 0 : 1 / length;
+        dir = delta * invLength;
+        normal = dir.orthogonal();
+
+        // Keep the function describing the same segment, vertical ones are approximated by a steep line
+        float xMin = start.x < end.x ? start.x : end.x;
+        float xMax = start.x < end.x ? end.x : start.x;
+        float yMin = start.y < end.y ? start.y : end.y;
+        float yMax = start.y < end.y ? end.y : start.y;
+        float slope = delta.x == 0 ? 10000 : delta.y / delta.x;
+        func = LinearFunc(slope, start.y - slope * start.x, xMin, xMax, yMin, yMax);
+    }
     void WallData::updateMetrics()
     {
-        pivot.y = func.slope * func.xMin + func.height;
-        if(pivot.y < func.yMin)
+        // Wall goes to the right along the line, from the beginning to the end of the domain range
+        Vector2 segStart(func.xMin, func.slope * func.xMin + func.height);
+        Vector2 segEnd(func.xMax, func.slope * func.xMax + func.height);
+        if(!clipToRanges(segStart, segEnd, func))
+            segEnd = segStart;
+
+        LinearFunc source = func;
+        setSegment(segStart, segEnd);
+        func = source;
+    }
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const WallData& wd)
+    {
+        stream << "WallData(func=" << wd.func << ", start=" << wd.start << ", end=" << wd.end << ", length=" << wd.length;
+        stream << ", hMin=" << wd.hMin << ", hMax=" << wd.hMax << ", texId=" << wd.texId << ", stopsRay=";
+        stream << wd.stopsRay << ")";
+        return stream;
+    }
+    #endif
+
+    /******************************************/
+    /********** STRUCTURE: RAY QUERY **********/
+    /******************************************/
+
+    RayQuery::RayQuery()
+    {
+        this->origin = Vector2::ZERO;
+        this->direction = Vector2::RIGHT;
+        this->maxDistance = 128;
+        this->solidOnly = false;
+    }
+    RayQuery::RayQuery(const Vector2& origin, const Vector2& direction, float maxDistance) : RayQuery()
+    {
+        this->origin = origin;
+        this->direction = direction;
+        this->maxDistance = maxDistance;
+    }
+    RayQuery::RayQuery(const Vector2& origin, const Vector2& direction, float maxDistance, bool solidOnly) : RayQuery(origin, direction, maxDistance)
+    {
+        this->solidOnly = solidOnly;
+    }
+
+    /**********************************************/
+    /********** STRUCTURE: RAY QUERY HIT **********/
+    /**********************************************/
+
+    RayQueryHit::RayQueryHit()
+    {
+        this->hit = false;
+        this->blocked = false;
+        this->tileId = 0;
+        this->wallIndex = -1;
+        this->distance = -1;
+        this->tile = Vector2::ZERO;
+        this->point = Vector2::ZERO;
+    }
+    #ifdef DEBUG
+    ostream& operator<<(ostream& stream, const RayQueryHit& hit)
+    {
+        stream << "RayQueryHit(hit=" << hit.hit << ", blocked=" << hit.blocked << ", tileId=" << hit.tileId;
+        stream << ", wallIndex=" << hit.wallIndex << ", distance=" << hit.distance << ", tile=" << hit.tile;
+        stream << ", point=" << hit.point << ")";
+        return stream;
+    }
+    #endif
+
+    /*******************************************/
+    /********** STRUCTURE: SCENE DATA **********/
+    /*******************************************/
+
+    // Returns revision no grid or walls had before, scenes on any thread take them
+    static uint64_t takeRevision()
+    {
+        static atomic<uint64_t> next(1);
+        return next++;
+    }
+
+    SceneGrid::SceneGrid()
+    {
+        this->revision = takeRevision();
+    }
+    SceneWalls::SceneWalls()
+    {
+        this->revision = takeRevision();
+    }
+    SceneTextures::SceneTextures()
+    {
+        this->texStorage = TS_TRUE_COLOR;
+    }
+    SceneData::SceneData()
+    {
+        this->width    = 0;
+        this->height   = 0;
+        this->grid     = std::make_shared<SceneGrid>();
+        this->walls    = std::make_shared<SceneWalls>();
+        this->textures = std::make_shared<SceneTextures>();
+        this->rpsTime  = 0;
+    }
+    SceneData::SceneData(int width, int height) : SceneData()
+    {
+        this->width       = width;
+        this->height      = height;
+        this->grid->tiles = vector<int>(width * height, 0);
+    }
+
+    /********************************************/
+    /********** STRUCTURE: RELOAD INFO **********/
+    /********************************************/
+
+    ReloadInfo::ReloadInfo()
+    {
+        this->reloaded        = false;
+        this->errorLine       = 0;
+        this->rowsChanged     = 0;
+        this->tilesChanged    = 0;
+        this->texturesLoaded  = 0;
+        this->texturesKept    = 0;
+        this->texturesDropped = 0;
+        this->time            = 0;
+    }
+
+    /**********************************/
+    /********** CLASS: SCENE **********/
+    /**********************************/
+
+    // Returns time file `file` was last written to as a number, or 0 if it can not be found
+    static int64_t getFileTime(const string& file)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(file, error);
+        return error ? 0 : (int64_t)time.time_since_epoch().count();
+    }
+    // Returns FNV-1a hash of text `text`
+    static uint64_t hashText(const string& text)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for(char ch : text)
+            hash = (hash ^ (uint8_t)ch) * 0x100000001B3ull;
+        return hash;
+    }
+    // Returns whether walls `a` and `b` are defined the same way
+    static bool isSameWall(const WallData& a, const WallData& b)
+    {
+        return a.func.slope == b.func.slope && a.func.height == b.func.height && a.func.xMin == b.func.xMin &&
+               a.func.xMax == b.func.xMax && a.func.yMin == b.func.yMin && a.func.yMax == b.func.yMax &&
+               a.start == b.start && a.end == b.end && a.hMin == b.hMin && a.hMax == b.hMax && a.tint == b.tint &&
+               a.texId == b.texId && a.stopsRay == b.stopsRay;
+    }
+    // Appends wall `wd` to walls of tile ID `tileId` in walls `target`, returns index of the wall
+    static int appendWall(SceneWalls& target, int tileId, const WallData& wd)
+    {
+        // Create tile entry if there is no one yet
+        if(target.tileWalls.count(tileId) == 0)
         {
-            pivot.x = (func.yMin - func.height) / func.slope;
-            pivot.y = func.yMin;
+            target.tileWalls.insert(make_pair( tileId, vector<WallData>() ));
+            target.tileIds.push_back(tileId);
         }
-        else if(pivot.y > func.yMax)
+        // Append new wall data, and return its index
+        target.tileWalls.at(tileId).push_back(wd);
+        return target.tileWalls.at(tileId).size() - 1;
+    }
+    // Returns ID the next texture loaded to textures `target` gets, it follows the highest one so removed textures
+    // leave gaps instead of having their IDs reused
+    static int nextTextureId(const SceneTextures& target)
+    {
+        return target.texSurfaces.empty() ? 1 : target.texSurfaces.rbegin()->first + 1;
+    }
+
+    const int Scene::QUERY_BATCH_GRAIN = 256;
+
+    SDL_Surface* Scene::convertSurface(SDL_Surface* surface, TextureStorage storage) const
+    {
+        bool indexed = storage == TS_INDEXED;
+        SDL_Surface* result = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h, indexed ? 8 : 32,
+                                                             indexed ? SDL_PIXELFORMAT_INDEX8 : SDL_PIXELFORMAT_ARGB8888);
+        if(result == nullptr)
+            return nullptr;
+
+        if(indexed)
         {
-            pivot.x = (func.yMax - func.height) / func.slope;
-            pivot.y = func.yMax;
+            // Surface palette gets the same colors, so the pixels look right outside of the engine as well
+            SDL_Color sdlColors[256];
+            for(int i = 0; i < 256; i++)
+                deColor(data->textures->texPalette.getColor(i), sdlColors[i].r, sdlColors[i].g, sdlColors[i].b, sdlColors[i].a);
+            SDL_SetPaletteColors(result->format->palette, sdlColors, 0, 256);
+            data->textures->texPalette.quantize((const uint32_t*)surface->pixels, surface->w, surface->h, surface->pitch / sizeof(uint32_t),
+                                (uint8_t*)result->pixels, result->pitch);
         }
         else
         {
-            pivot.x = func.xMin;
+            for(int y = 0; y < surface->h; y++)
+            {
+                const uint8_t* indices = (const uint8_t*)surface->pixels + y * surface->pitch;
+                uint32_t* row = (uint32_t*)((uint8_t*)result->pixels + y * result->pitch);
+                for(int x = 0; x < surface->w; x++)
+                    row[x] = data->textures->texPalette.getColor(indices[x]);
+            }
+        }
+        return result;
+    }
+    bool Scene::isSurfaceOpaque(const SDL_Surface* surface)
+    {
+        bool indexed = surface->format->format == SDL_PIXELFORMAT_INDEX8;
+        for(int y = 0; y < surface->h; y++)
+        {
+            const uint8_t* row = (const uint8_t*)surface->pixels + y * surface->pitch;
+            for(int x = 0; x < surface->w; x++)
+                if(indexed ? row[x] == Palette::TRANSPARENT_INDEX : (((const uint32_t*)row)[x] >> 24) != 255)
+                    return false;
         }
+        return true;
+    }
+    SDL_Surface* Scene::readTexture(const string& file, TextureStorage storage) const
+    {
+        RPGE_TRACE_SCOPE("texture load");
+        SDL_Surface* image = IMG_Load(file.c_str());
+        if(image == nullptr)
+            return nullptr;
 
-        Vector2 end;
-        end.y = func.slope * func.xMax + func.height;
-        if(end.y < func.yMin)
+        // Only the pixels are kept, textures of the renderer are made from them when they are first asked for
+        SDL_Surface* pixels = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(image);
+        if(pixels != nullptr && storage == TS_INDEXED)
         {
-            end.x = (func.yMin - func.height) / func.slope;
-            end.y = func.yMin;
+            SDL_Surface* indexed = convertSurface(pixels, TS_INDEXED);
+            SDL_FreeSurface(pixels);
+            pixels = indexed;
         }
-        else if(end.y > func.yMax)
+        return pixels;
+    }
+    int Scene::takeTexture(SceneTextures& target, const SceneTextures& previous, const string& file) const
+    {
+        auto found = target.texIds.find(file);
+        if(found != target.texIds.end())
+            return found->second;
+
+        // Texture keeps its ID, and its pixels too when the file was not written to since they were read
+        int64_t time = getFileTime(file);
+        auto kept = previous.texIds.find(file);
+        int id = kept != previous.texIds.end() ? kept->second : std::max(nextTextureId(target), nextTextureId(previous));
+        if(kept != previous.texIds.end() && previous.texTimes.at(id) == time && previous.texStorage == target.texStorage)
         {
-            end.x = (func.yMax - func.height) / func.slope;
-            end.y = func.yMax;
+            target.texSurfaces.insert(make_pair(id, previous.texSurfaces.at(id)));
+            target.texOpaque.insert(pair<int, bool>(id, previous.texOpaque.at(id)));
         }
         else
         {
-            end.x = func.xMax;
+            SDL_Surface* pixels = readTexture(file, target.texStorage);
+            if(pixels == nullptr)
+                return 0;
+            target.texSurfaces.insert(make_pair(id, shared_ptr<SDL_Surface>(pixels, SDL_FreeSurface)));
+            target.texOpaque.insert(pair<int, bool>(id, isSurfaceOpaque(pixels)));
         }
-
-        length = (end - pivot).magnitude();
+        target.texIds.insert(pair<string, int>(file, id));
+        target.texTimes.insert(pair<int, int64_t>(id, time));
+        return id;
     }
-    #ifdef DEBUG
-    ostream& operator<<(ostream& stream, const WallData& wd)
+    void Scene::dropTextures()
     {
-        stream << "WallData(func=" << wd.func << ", pivot=" << wd.pivot << ", length=" << wd.length;
-        stream << ", hMin=" << wd.hMin << ", hMax=" << wd.hMax << ", texId=" << wd.texId << ", stopsRay=";
-        stream << wd.stopsRay << ")";
-        return stream;
+        for(pair<int, SDL_Texture*> sources : texSources)
+            if(sources.second != nullptr)
+                SDL_DestroyTexture(sources.second);
+        texSources.clear();
+    }
+    void Scene::dropStaleTextures(const SceneData& next)
+    {
+        if(next.textures == data->textures)
+            return;
+        const map<int, shared_ptr<SDL_Surface>>& nextSurfaces = next.textures->texSurfaces;
+        const map<int, shared_ptr<SDL_Surface>>& surfaces = data->textures->texSurfaces;
+        for(auto sources = texSources.begin(); sources != texSources.end(); )
+        {
+            auto now = nextSurfaces.find(sources->first);
+            auto old = surfaces.find(sources->first);
+            if(now != nextSurfaces.end() && old != surfaces.end() && now->second == old->second)
+            {
+                sources++;
+                continue;
+            }
+            if(sources->second != nullptr)
+                SDL_DestroyTexture(sources->second);
+            sources = texSources.erase(sources);
+        }
+    }
+    SceneData* Scene::edit()
+    {
+        // Other scenes keep the data they view, this one gets a copy which still shares all of the parts. Reference
+        // count is not trusted for it, scenes on other threads may be letting go of the data at the same time.
+        if(shared & SP_DATA)
+        {
+            data = std::make_shared<SceneData>(*data);
+            shared &= ~SP_DATA;
+        }
+        return data.get();
+    }
+    SceneGrid* Scene::editGrid()
+    {
+        SceneData* edited = edit();
+        if(shared & SP_GRID)
+        {
+            edited->grid = std::make_shared<SceneGrid>(*edited->grid);
+            shared &= ~SP_GRID;
+        }
+        edited->grid->revision = takeRevision();
+        return edited->grid.get();
+    }
+    SceneWalls* Scene::editWalls()
+    {
+        SceneData* edited = edit();
+        if(shared & SP_WALLS)
+        {
+            edited->walls = std::make_shared<SceneWalls>(*edited->walls);
+            shared &= ~SP_WALLS;
+        }
+        edited->walls->revision = takeRevision();
+        return edited->walls.get();
+    }
+    SceneTextures* Scene::editTextures()
+    {
+        // Copy still shares the texture pixels
+        SceneData* edited = edit();
+        if(shared & SP_TEXTURES)
+        {
+            edited->textures = std::make_shared<SceneTextures>(*edited->textures);
+            shared &= ~SP_TEXTURES;
+        }
+        return edited->textures.get();
     }
-    #endif
-
-    /**********************************/
-    /********** CLASS: SCENE **********/
-    /**********************************/
-
     int Scene::posAsDataIndex(int x, int y) const
     {
-        return width * (height - y - 1) + x;
+        return data->width * (data->height - y - 1) + x;
     }
     Scene::Scene(SDL_Renderer* sdlRend)
     {
         this->error = E_CLEAR;
-        this->width = 0;
-        this->height = 0;
-        this->tiles = nullptr;
-        this->tileWalls = map<int, vector<WallData>>();
+        this->data = std::make_shared<SceneData>();
+        this->shared = 0;
         this->texSources = map<int, SDL_Texture*>();
-        this->texIds = map<string, int>();
-        this->tileIds = vector<int>();
+        this->visibility = nullptr;
         this->sdlRend = sdlRend;
     }
     Scene::Scene(SDL_Renderer* sdlRend, int width, int height) : Scene(sdlRend)
     {
-        this->width = width;
-        this->height = height;
-        this->tiles = new int[width * height];
+        this->data = std::make_shared<SceneData>(width, height);
     }
     Scene::Scene(SDL_Renderer* sdlRend, const string& file) : Scene(sdlRend)
     {
         loadFromFile(file);
     }
+    Scene::Scene(SDL_Renderer* sdlRend, const shared_ptr<const SceneData>& data) : Scene(sdlRend)
+    {
+        // Data is changed only through `edit`, which copies it while it is shared
+        if(data != nullptr)
+        {
+            this->data = std::const_pointer_cast<SceneData>(data);
+            this->shared = SP_ALL;
+        }
+    }
     Scene::~Scene()
     {
-        if(tiles != nullptr)
-            delete[] tiles;
+        dropTextures();
+    }
+    bool Scene::castRay(const RayQuery& query, RayQueryHit& hit) const
+    {
+        hit = RayQueryHit();
+        Vector2 rayDir = query.direction.normalized();
+        float maxDistance = query.maxDistance;
+        if(rayDir == Vector2::ZERO || maxDistance < 0)
+            return false;
 
-        tileWalls.clear();
+        // Nothing can be hit past the farthest tile visible from the origin tile
+        if(visibility != nullptr && visibility->getWidth() == data->width && visibility->getHeight() == data->height)
+        {
+            float reach = visibility->getReach(query.origin.x, query.origin.y);
+            if(reach >= 0 && reach < maxDistance)
+                maxDistance = reach;
+        }
 
-        for(pair<int, SDL_Texture*> sources : texSources)
-            SDL_DestroyTexture(sources.second);
-        texSources.clear();
-        
-        texIds.clear();
+        // Every query gets its own walker, which only reads the scene, so queries do not share any state
+        DDA walker(const_cast<Scene*>(this), (int)maxDistance + 1);
+        walker.init(query.origin, rayDir);
+        while(true)
+        {
+            RayHitInfo tileHit = walker.next();
+            if( walker.rayFlag & (DDA::RF_TOO_FAR | DDA::RF_OUTSIDE | DDA::RF_FAIL) )
+                break;
+            else if( !(walker.rayFlag & DDA::RF_HIT) )
+                continue;
+            if(tileHit.distance > maxDistance)
+                break;
+
+            const vector<WallData>* walls = getTileWalls(getTileId(tileHit.tile.x, tileHit.tile.y));
+            if(walls == nullptr)
+                continue;
+
+            // Find the nearest wall of the tile reached within the maximum distance
+            Vector2 localEnter = walker.getLocalEnter(tileHit);
+            int wallCount = walls->size();
+            for(int i = 0; i != wallCount; i++)
+            {
+                const WallData& wd = walls->at(i);
+                float interDist, u;
+                if(query.solidOnly && !wd.stopsRay)
+                    continue;
+                if(!wd.intersect(localEnter, rayDir, interDist, u))
+                    continue;
+
+                float totalDist = tileHit.distance + interDist;
+                if(totalDist <= maxDistance && (!hit.hit || totalDist < hit.distance))
+                {
+                    hit.hit       = true;
+                    hit.blocked   = wd.stopsRay;
+                    hit.wallIndex = i;
+                    hit.distance  = totalDist;
+                    hit.point     = tileHit.tile + localEnter + rayDir * interDist;
+                }
+            }
+            if(hit.hit)
+            {
+                hit.tile   = tileHit.tile;
+                hit.tileId = getTileId(tileHit.tile.x, tileHit.tile.y);
+                return true;
+            }
+        }
+        return false;
     }
-    bool Scene::checkPosition(int x, int y) const
+    void Scene::castRays(const RayQuery* queries, RayQueryHit* hits, int count) const
     {
-        return (x > -1 && x < width) && (y > -1 && y < height);
+        for(int i = 0; i < count; i++)
+            castRay(queries[i], hits[i]);
     }
-    int Scene::createTileWall(int tileId, const WallData& wd)
+    void Scene::castRays(const RayQuery* queries, RayQueryHit* hits, int count, WorkerPool* pool) const
     {
-        // Create tile entry if there is no one yet
-        if(tileWalls.count(tileId) == 0)
+        if(pool == nullptr || count <= QUERY_BATCH_GRAIN)
         {
-            tileWalls.insert(make_pair( tileId, vector<WallData>() ));
-            tileIds.push_back(tileId);
+            castRays(queries, hits, count);
+            return;
         }
-        // Append new wall data, and return its index
-        tileWalls.at(tileId).push_back(wd);
-        return tileWalls.at(tileId).size() - 1;
+        pool->run(count, QUERY_BATCH_GRAIN, [&](int begin, int end) {
+            castRays(queries + begin, hits + begin, end - begin);
+        });
+    }
+    bool Scene::checkLineOfSight(const Vector2& from, const Vector2& to) const
+    {
+        // Visibility set knows only about tiles having walls
+        if(visibility != nullptr && visibility->getWidth() == data->width && visibility->getHeight() == data->height &&
+           getTileId(to.x, to.y) != 0 && !visibility->isVisible(from.x, from.y, to.x, to.y))
+            return false;
+
+        Vector2 delta = to - from;
+        RayQueryHit hit;
+        return !castRay(RayQuery(from, delta, delta.magnitude(), true), hit);
+    }
+    bool Scene::checkPosition(int x, int y) const
+    {
+        return (x > -1 && x < data->width) && (y > -1 && y < data->height);
+    }
+    int Scene::createTileWall(int tileId, const WallData& wd)
+    {
+        visibility = nullptr;
+        return appendWall(*editWalls(), tileId, wd);
+    }
+    bool Scene::setTileWall(int tileId, int index, const WallData& wd)
+    {
+        const vector<WallData>* walls = getTileWalls(tileId);
+        if(walls == nullptr || index < 0 || index >= (int)walls->size())
+            return false;
+        editWalls()->tileWalls.at(tileId)[index] = wd;
+        visibility = nullptr;
+        return true;
     }
     bool Scene::setTileId(int x, int y, int tileId)
     {
         if(checkPosition(x, y))
         {
-            tiles[posAsDataIndex(x, y)] = tileId;
+            SceneGrid* edited = editGrid();
+            edited->tiles[posAsDataIndex(x, y)] = tileId;
+            visibility = nullptr;
+            // Row no longer holds what the file says, so reloading interprets it again
+            if(y < (int)edited->rowHashes.size())
+                edited->rowHashes[y] = 0;
             return true;
         }
         return false;
@@ -147,65 +611,295 @@ namespace rpge
     int Scene::getError() const {
         return error;
     }
+    uint64_t Scene::getGridRevision() const
+    {
+        return data->grid->revision;
+    }
+    uint64_t Scene::getWallsRevision() const
+    {
+        return data->walls->revision;
+    }
     int Scene::getTileId(int x, int y) const
     {
         if(checkPosition(x, y))
-            return tiles[posAsDataIndex(x, y)];
+            return data->grid->tiles[posAsDataIndex(x, y)];
         return 0;
     }
     int Scene::getWidth() const
     {
-        return width;
+        return data->width;
     }
     int Scene::getHeight() const
     {
-        return height;
+        return data->height;
+    }
+    shared_ptr<const SceneData> Scene::getData() const
+    {
+        shared |= SP_ALL;
+        return data;
+    }
+    void Scene::setData(const shared_ptr<const SceneData>& data)
+    {
+        if(data == nullptr || data == this->data)
+            return;
+        if(data->grid != this->data->grid || data->walls != this->data->walls)
+            visibility = nullptr;
+        dropStaleTextures(*data);
+        this->data = std::const_pointer_cast<SceneData>(data);
+        shared = SP_ALL;
     }
     int Scene::getTextureId(const string& file) const
     {
-        if(texIds.count(file) == 0)
+        auto found = data->textures->texIds.find(file);
+        if(found == data->textures->texIds.end())
             return 0;
-        return texIds.at(file);
+        return found->second;
     }
     string Scene::getTextureName(int texId) const
     {
-        for(const auto& p : texIds)
+        for(const auto& p : data->textures->texIds)
             if(p.second == texId)
                 return p.first;
         return "";
     }
     SDL_Texture* Scene::getTextureSource(int texId)
     {
-        if(texSources.count(texId) == 0)
+        auto found = texSources.find(texId);
+        if(found != texSources.end())
+            return found->second;
+
+        SDL_Surface* surface = getTextureSurface(texId);
+        if(surface == nullptr || sdlRend == nullptr)
+            return nullptr;
+
+        // Texture blends only when some of its pixels let walls behind be seen; failure is kept too, so it is not
+        // tried again for every column
+        SDL_Texture* tex = SDL_CreateTextureFromSurface(sdlRend, surface);
+        if(tex != nullptr)
+            SDL_SetTextureBlendMode(tex, isTextureOpaque(texId) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+        texSources.insert(pair<int, SDL_Texture*>(texId, tex));
+        return tex;
+    }
+    SDL_Surface* Scene::getTextureSurface(int texId) const
+    {
+        auto found = data->textures->texSurfaces.find(texId);
+        if(found == data->textures->texSurfaces.end())
             return nullptr;
-        
-        return texSources.at(texId);
+
+        return found->second.get();
+    }
+    size_t Scene::getTextureMemory() const
+    {
+        size_t bytes = 0;
+        for(const pair<const int, shared_ptr<SDL_Surface>>& surfaces : data->textures->texSurfaces)
+            bytes += (size_t)surfaces.second->pitch * surfaces.second->h;
+        return bytes;
+    }
+    bool Scene::isTextureOpaque(int texId) const
+    {
+        auto found = data->textures->texOpaque.find(texId);
+        return found != data->textures->texOpaque.end() && found->second;
+    }
+    const Palette& Scene::getTexturePalette() const
+    {
+        return data->textures->texPalette;
+    }
+    TextureStorage Scene::getTextureStorage() const
+    {
+        return data->textures->texStorage;
+    }
+    void Scene::fitTexturePalette(int count)
+    {
+        vector<uint32_t> pixels;
+        for(const pair<const int, shared_ptr<SDL_Surface>>& surfaces : data->textures->texSurfaces)
+        {
+            const SDL_Surface* surface = surfaces.second.get();
+            bool indexed = surface->format->format == SDL_PIXELFORMAT_INDEX8;
+            for(int y = 0; y < surface->h; y++)
+            {
+                const uint8_t* row = (const uint8_t*)surface->pixels + y * surface->pitch;
+                for(int x = 0; x < surface->w; x++)
+                    pixels.push_back(indexed ? data->textures->texPalette.getColor(row[x]) : ((const uint32_t*)row)[x]);
+            }
+        }
+        setTexturePalette(Palette::fromPixels(pixels.data(), pixels.size(), count));
+    }
+    void Scene::setTexturePalette(const Palette& palette)
+    {
+        // Indexed textures go through true color, so their indices refer to the new colors
+        if(data->textures->texStorage == TS_INDEXED)
+        {
+            setTextureStorage(TS_TRUE_COLOR);
+            editTextures()->texPalette = palette;
+            setTextureStorage(TS_INDEXED);
+        }
+        else
+            editTextures()->texPalette = palette;
+    }
+    bool Scene::setTextureStorage(TextureStorage storage)
+    {
+        // Converted pixels replace the old ones, which stay alive while other scenes view them
+        SceneTextures* edited = editTextures();
+        bool converted = true;
+        for(pair<const int, shared_ptr<SDL_Surface>>& surfaces : edited->texSurfaces)
+        {
+            bool indexed = surfaces.second->format->format == SDL_PIXELFORMAT_INDEX8;
+            if(indexed == (storage == TS_INDEXED))
+                continue;
+            SDL_Surface* result = convertSurface(surfaces.second.get(), storage);
+            if(result == nullptr)
+            {
+                converted = false;
+                continue;
+            }
+            surfaces.second.reset(result, SDL_FreeSurface);
+            // Quantizing can make translucent pixels either transparent or opaque
+            edited->texOpaque[surfaces.first] = isSurfaceOpaque(result);
+        }
+        edited->texStorage = storage;
+        dropTextures();
+        return converted;
+    }
+    const VisibilitySet* Scene::getVisibilitySet() const
+    {
+        return visibility;
+    }
+    bool Scene::setVisibilitySet(const VisibilitySet* pvs)
+    {
+        visibility = pvs != nullptr && pvs->matches(*this) ? pvs : nullptr;
+        return visibility == pvs;
     }
     const vector<int>* Scene::getTileIds() const
     {
-        return &tileIds;
+        return &data->walls->tileIds;
     }
-    vector<WallData>* Scene::getTileWalls(int tileId)
+    const vector<WallData>* Scene::getTileWalls(int tileId) const
     {
-        if(tileWalls.count(tileId) == 0)
+        auto found = data->walls->tileWalls.find(tileId);
+        if(found == data->walls->tileWalls.end())
             return nullptr;
-        return &tileWalls.at(tileId);
+        return &found->second;
     }
     int Scene::loadTexture(const string& file)
     {
-        if(texIds.count(file) != 0)
-            return texIds.at(file);
+        int loaded = getTextureId(file);
+        if(loaded != 0)
+            return loaded;
 
-        int id = texIds.size() + 1;
-        SDL_Texture* tex = IMG_LoadTexture(sdlRend, file.c_str());
-        if(tex == nullptr)
+        int64_t time = getFileTime(file);
+        SDL_Surface* pixels = readTexture(file, data->textures->texStorage);
+        if(pixels == nullptr)
             return 0;
 
-        texSources.insert(pair<int, SDL_Texture*>(id, tex));
-        texIds.insert(pair<string, int>(file, id));
+        SceneTextures* edited = editTextures();
+        int id = nextTextureId(*edited);
+        edited->texSurfaces.insert(make_pair(id, shared_ptr<SDL_Surface>(pixels, SDL_FreeSurface)));
+        edited->texOpaque.insert(pair<int, bool>(id, isSurfaceOpaque(pixels)));
+        edited->texIds.insert(pair<string, int>(file, id));
+        edited->texTimes.insert(pair<int, int64_t>(id, time));
         return id;
     }
     int Scene::loadFromFile(const string& rpsFile)
+    {
+        RPGE_TRACE_SCOPE("scene load");
+
+        // Scene starts over with data of its own, texture storage and palette stay; scenes sharing the old data keep it
+        shared_ptr<SceneData> loaded = std::make_shared<SceneData>();
+        loaded->textures->texStorage = data->textures->texStorage;
+        loaded->textures->texPalette = data->textures->texPalette;
+        int ln = parseRps(rpsFile, *loaded, SceneData());
+        if(error == E_RPS_FAILED_TO_READ)
+            return ln;
+        data = std::move(loaded);
+        shared = 0;
+        visibility = nullptr;
+        dropTextures();
+        return ln;
+    }
+    ReloadInfo Scene::reloadFromFile(const string& rpsFile)
+    {
+        RPGE_TRACE_SCOPE("scene reload");
+        ReloadInfo info;
+        steady_clock::time_point start = steady_clock::now();
+
+        // File is read into data of its own, the scene stays as it was when it can not be interpreted
+        shared_ptr<SceneData> parsed = std::make_shared<SceneData>();
+        parsed->textures->texStorage = data->textures->texStorage;
+        parsed->textures->texPalette = data->textures->texPalette;
+        info.errorLine = parseRps(rpsFile, *parsed, *data);
+        if(error != E_CLEAR)
+            return info;
+
+        // Textures whose pixels were taken over keep their IDs, textures of the renderer are dropped for the rest
+        const map<int, shared_ptr<SDL_Surface>>& surfaces = data->textures->texSurfaces;
+        for(const pair<const int, shared_ptr<SDL_Surface>>& parsedSurfaces : parsed->textures->texSurfaces)
+        {
+            auto old = surfaces.find(parsedSurfaces.first);
+            bool kept = old != surfaces.end() && old->second == parsedSurfaces.second;
+            info.texturesKept   += kept;
+            info.texturesLoaded += !kept;
+        }
+        for(const pair<const int, shared_ptr<SDL_Surface>>& oldSurfaces : surfaces)
+            info.texturesDropped += parsed->textures->texSurfaces.count(oldSurfaces.first) == 0;
+        dropStaleTextures(*parsed);
+
+        // Rows and tile walls which differ are counted, the parts of the data they are in are replaced by the parsed
+        // ones; parts where nothing differs stay as they are, shared with other scenes
+        if(data->width != parsed->width || data->height != parsed->height)
+            info.rowsChanged = parsed->height;
+        else
+            for(int row = 0; row < parsed->height; row++)
+            {
+                const int* fresh = parsed->grid->tiles.data() + row * parsed->width;
+                const int* live = data->grid->tiles.data() + row * parsed->width;
+                info.rowsChanged += !std::equal(fresh, fresh + parsed->width, live);
+            }
+        const map<int, vector<WallData>>& tileWalls = data->walls->tileWalls;
+        for(const pair<const int, vector<WallData>>& walls : parsed->walls->tileWalls)
+        {
+            auto live = tileWalls.find(walls.first);
+            info.tilesChanged += live == tileWalls.end() || !std::equal(live->second.begin(), live->second.end(),
+                                                                        walls.second.begin(), walls.second.end(), isSameWall);
+        }
+        for(const pair<const int, vector<WallData>>& walls : tileWalls)
+            info.tilesChanged += parsed->walls->tileWalls.count(walls.first) == 0;
+
+        SceneData* edited = edit();
+        if(info.rowsChanged > 0 || edited->grid->rowHashes != parsed->grid->rowHashes)
+        {
+            edited->width  = parsed->width;
+            edited->height = parsed->height;
+            edited->grid   = parsed->grid;
+            shared &= ~SP_GRID;
+        }
+        if(info.tilesChanged > 0 || edited->walls->tileIds != parsed->walls->tileIds)
+        {
+            edited->walls = parsed->walls;
+            shared &= ~SP_WALLS;
+        }
+        edited->textures = parsed->textures;
+        shared &= ~SP_TEXTURES;
+        if(info.rowsChanged > 0 || info.tilesChanged > 0)
+            visibility = nullptr;
+        edited->rpsFile  = parsed->rpsFile;
+        edited->rpsTime  = parsed->rpsTime;
+
+        info.reloaded = true;
+        info.time = duration<float>(steady_clock::now() - start).count();
+        return info;
+    }
+    ReloadInfo Scene::reloadIfChanged()
+    {
+        if(data->rpsFile.empty())
+            return ReloadInfo();
+
+        const SceneTextures& textures = *data->textures;
+        bool changed = getFileTime(data->rpsFile) != data->rpsTime;
+        for(auto files = textures.texIds.begin(); !changed && files != textures.texIds.end(); files++)
+            changed = getFileTime(files->first) != textures.texTimes.at(files->second);
+        return changed ? reloadFromFile(data->rpsFile) : ReloadInfo();
+    }
+    int Scene::parseRps(const string& rpsFile, SceneData& target, const SceneData& previous)
     {
         error = E_CLEAR;
         ifstream stream(rpsFile);
@@ -215,17 +909,29 @@ namespace rpge
             error = E_RPS_FAILED_TO_READ;
             return ln;
         }
-
-        tileWalls.clear();
-        texSources.clear();
-        texIds.clear();
-        tileIds.clear();
+        // Time is taken before reading, so changes made meanwhile are noticed by the next check
+        target.rpsFile = rpsFile;
+        target.rpsTime = getFileTime(rpsFile);
 
         string fileLine;
         int wdh = -1; // World data height (starting from top)
+        bool sameSize = false; // Whether rows of the previous data can be taken over
         while(std::getline(stream, fileLine))
         {
             ln++;
+            // Rows written the same as in the previous data are copied from it instead of being interpreted again
+            if(sameSize && wdh >= 0 && fileLine.size() > 1 && fileLine[0] == 'w' && fileLine[1] == ' ')
+            {
+                uint64_t lineHash = hashText(fileLine);
+                if(previous.grid->rowHashes[wdh] == lineHash)
+                {
+                    int offset = target.width * (target.height - wdh - 1);
+                    std::copy(previous.grid->tiles.begin() + offset, previous.grid->tiles.begin() + offset + target.width,
+                              target.grid->tiles.begin() + offset);
+                    target.grid->rowHashes[wdh--] = lineHash;
+                    continue;
+                }
+            }
             // Extract space-separated arguments
             vector<string> args;
             string current = "";
@@ -264,10 +970,13 @@ namespace rpge
                         error = E_RPS_UNKNOWN_NUMBER_FORMAT;
                         return ln;
                     }
-                    width = (int)stof(args.at(1));
-                    height = (int)stof(args.at(2));
-                    wdh = height - 1;
-                    tiles = new int[width * height];
+                    target.width = (int)stof(args.at(1));
+                    target.height = (int)stof(args.at(2));
+                    target.grid->tiles.assign(target.width * target.height, 0);
+                    target.grid->rowHashes.assign(target.height, 0);
+                    wdh = target.height - 1;
+                    sameSize = previous.width == target.width && previous.height == target.height &&
+                               (int)previous.grid->rowHashes.size() == target.height;
                     break;
                 }
                 // Define next world data height (counting from top)
@@ -278,44 +987,49 @@ namespace rpge
                         error = E_RPS_OPERATION_NOT_AVAILABLE;
                         return ln;
                     }
-                    if(args.size() != width + 1)
+                    if(args.size() != target.width + 1)
                     {
                         error = E_RPS_INVALID_ARGUMENTS_COUNT;
                         return ln;
                     }
-                    for(int x = 0; x < width; x++)
+                    for(int x = 0; x < target.width; x++)
                     {
                         if(!isFloat(args.at(1 + x)))
                         {
                             error = E_RPS_UNKNOWN_NUMBER_FORMAT;
                             return ln;
                         }
-                        setTileId(x, wdh, (int)stof(args.at(1 + x)));
+                        target.grid->tiles[target.width * (target.height - wdh - 1) + x] = (int)stof(args.at(1 + x));
                     }
-                    wdh--;
+                    target.grid->rowHashes[wdh--] = hashText(fileLine);
                     break;
                 }
                 // Define properties of a tile with specified data
                 case 't':
                 {
-                    if(args.size() != 21)
+                    // Wall geometry is given either by a linear function (`l`) or by segment endpoints (`e`), the latter
+                    // takes two more arguments, so everything after it is shifted by `shift`.
+                    bool isSegment = args.size() > 2 && args.at(2) == "e";
+                    int shift = isSegment ? 2 : 0;
+                    if((int)args.size() != 21 + shift)
                     {
                         error = E_RPS_INVALID_ARGUMENTS_COUNT;
                         return ln;
                     }
                     else if(!(
-                        isFloat(args.at(1))  && isFloat(args.at(3))  && isFloat(args.at(4))  &&
-                        isFloat(args.at(6))  && isFloat(args.at(7))  && isFloat(args.at(8))  &&
-                        isFloat(args.at(9))  && isFloat(args.at(10)) && isFloat(args.at(11)) &&
-                        isFloat(args.at(13)) && isFloat(args.at(15)) && isFloat(args.at(16)) &&
-                        isFloat(args.at(17)) && isFloat(args.at(18))
+                        isFloat(args.at(1))          && isFloat(args.at(3))          && isFloat(args.at(4))          &&
+                        (!isSegment || (isFloat(args.at(5)) && isFloat(args.at(6))))                                    &&
+                        isFloat(args.at(6 + shift))  && isFloat(args.at(7 + shift))  && isFloat(args.at(8 + shift))  &&
+                        isFloat(args.at(9 + shift))  && isFloat(args.at(10 + shift)) && isFloat(args.at(11 + shift)) &&
+                        isFloat(args.at(13 + shift)) && isFloat(args.at(15 + shift)) && isFloat(args.at(16 + shift)) &&
+                        isFloat(args.at(17 + shift)) && isFloat(args.at(18 + shift))
                     ))
                     {
                         error = E_RPS_UNKNOWN_NUMBER_FORMAT;
                         return ln;
                     }
 
-                    string text = args.at(20);
+                    string text = args.at(20 + shift);
                     int tLen = text.length();
                     if(tLen < 2 || text[0] != '"' || text[tLen - 1] != '"')
                     {
@@ -324,31 +1038,38 @@ namespace rpge
                     }
 
                     string textureFile = text.substr(1, tLen - 2); // Without double apostrophes
-                    int assignedId = loadTexture(textureFile);
-
-                    createTileWall(
-                        (int)stof(args.at(1)),
-                        WallData(
-                            LinearFunc(
-                                stof(args.at(3)),
-                                stof(args.at(4)),
-                                stof(args.at(6)),
-                                stof(args.at(7)),
-                                stof(args.at(8)),
-                                stof(args.at(9))
-                            ),
-                            enColor(
-                                (uint8_t)stof(args.at(15)),
-                                (uint8_t)stof(args.at(16)),
-                                (uint8_t)stof(args.at(17)),
-                                (uint8_t)stof(args.at(18))
-                            ),
-                            stof(args.at(10)),
-                            stof(args.at(11)),
-                            assignedId,
-                            (bool)stof(args.at(13))
-                        )
+                    int assignedId = takeTexture(*target.textures, *previous.textures, textureFile);
+
+                    WallData wall(
+                        LinearFunc(
+                            isSegment ? 0 : stof(args.at(3)),
+                            isSegment ? 0 : stof(args.at(4)),
+                            stof(args.at(6 + shift)),
+                            stof(args.at(7 + shift)),
+                            stof(args.at(8 + shift)),
+                            stof(args.at(9 + shift))
+                        ),
+                        enColor(
+                            (uint8_t)stof(args.at(15 + shift)),
+                            (uint8_t)stof(args.at(16 + shift)),
+                            (uint8_t)stof(args.at(17 + shift)),
+                            (uint8_t)stof(args.at(18 + shift))
+                        ),
+                        stof(args.at(10 + shift)),
+                        stof(args.at(11 + shift)),
+                        assignedId,
+                        (bool)stof(args.at(13 + shift))
                     );
+                    if(isSegment)
+                    {
+                        // Segment is clipped to the display domain the same way linear functions are
+                        Vector2 start(stof(args.at(3)), stof(args.at(4)));
+                        Vector2 end(stof(args.at(5)), stof(args.at(6)));
+                        if(!clipToRanges(start, end, wall.func))
+                            end = start;
+                        wall.setSegment(start, end);
+                    }
+                    appendWall(*target.walls, (int)stof(args.at(1)), wall);
                     break;
                 }
                 default:
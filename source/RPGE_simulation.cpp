@@ -0,0 +1,204 @@
+
+#include <RPGE_simulation.hpp>
+#include <RPGE_trace.hpp>
+
+namespace rpge
+{
+
+    /****************************************************/
+    /********** STRUCTURE: SIMULATION SNAPSHOT **********/
+    /****************************************************/
+
+    SimulationSnapshot::SimulationSnapshot()
+    {
+        this->tick       = 0;
+        this->previous   = Camera();
+        this->camera     = Camera();
+        this->scene      = nullptr;
+        this->visibility = nullptr;
+        this->time       = steady_clock::now();
+        this->inputTime  = time;
+        this->hasInput   = false;
+    }
+
+    /********************************************/
+    /********** CLASS: SNAPSHOT BUFFER **********/
+    /********************************************/
+
+    SnapshotBuffer::SnapshotBuffer()
+    {
+        this->back   = 0;
+        this->middle = 1;
+        this->front  = 2;
+    }
+    bool SnapshotBuffer::acquire()
+    {
+        if(!(middle.load(std::memory_order_acquire) & FRESH))
+            return false;
+        // Reader gives its slot to the writer and gets the latest snapshot, which is not fresh for it anymore
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+        return true;
+    }
+    SimulationSnapshot& SnapshotBuffer::getBack()
+    {
+        return slots[back];
+    }
+    const SimulationSnapshot& SnapshotBuffer::getFront() const
+    {
+        return slots[front];
+    }
+    void SnapshotBuffer::publish()
+    {
+        // Snapshot not taken by the reader yet is overwritten the next time, its slot is the new back one
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    /***************************************/
+    /********** CLASS: SIMULATION **********/
+    /***************************************/
+
+    Simulation::Simulation(Scene* scene, Camera* camera, int ticksPerSecond)
+    {
+        this->bRun              = false;
+        this->iTicksPerSecond   = ticksPerSecond < 1 ? 1 : ticksPerSecond;
+        this->tickCount         = 0;
+        this->fMeanTickTime     = 0;
+        this->fMeanTickInterval = 0;
+        this->camera            = camera;
+        this->scene             = scene;
+        this->update            = nullptr;
+        this->lastCamera        = *camera;
+        this->pacer.setFrameRate(iTicksPerSecond);
+        for(int sc = 0; sc < SDL_NUM_SCANCODES; sc++)
+            this->keysHeld[sc] = false;
+        // Events of a tick are taken from the input queue, so there are never more of them than it can hold
+        this->tickInputs.reserve(InputQueue::CAPACITY);
+
+        // Starting state is there to be drawn before the first tick
+        publish();
+        snapshots.acquire();
+    }
+    Simulation::~Simulation()
+    {
+        stop();
+    }
+    void Simulation::publish()
+    {
+        SimulationSnapshot& snapshot = snapshots.getBack();
+        snapshot.tick       = tickCount;
+        snapshot.previous   = lastCamera;
+        snapshot.camera     = *camera;
+        snapshot.scene      = scene->getData();
+        snapshot.visibility = scene->getVisibilitySet();
+        snapshot.time       = steady_clock::now();
+        snapshot.hasInput   = !tickInputs.empty();
+        snapshot.inputTime  = snapshot.hasInput ? tickInputs.front().time : snapshot.time;
+        lastCamera = *camera;
+        snapshots.publish();
+    }
+    void Simulation::loop()
+    {
+        #ifdef RPGE_TRACING
+        Tracer::setThreadName("simulation");
+        #endif
+        const float period = getTickPeriod();
+        pacer.reset();
+        while(bRun)
+        {
+            float interval = pacer.wait();
+            RPGE_TRACE_SCOPE("tick");
+            time_point<steady_clock> start = steady_clock::now();
+
+            // Events handed over since the last tick, at most as many as the queue holds so they can not starve it
+            InputEvent input;
+            tickInputs.clear();
+            while((int)tickInputs.size() < InputQueue::CAPACITY && inputQueue.pop(input))
+            {
+                if((input.type == IE_KEY_DOWN || input.type == IE_KEY_UP) && input.code >= 0 && input.code < SDL_NUM_SCANCODES)
+                    keysHeld[input.code] = input.type == IE_KEY_DOWN;
+                tickInputs.push_back(input);
+            }
+
+            if(update)
+                update(period);
+            tickCount++;
+            publish();
+
+            // Interval of the first tick after starting is not known
+            float tickTime = duration<float>(steady_clock::now() - start).count();
+            float meanTime = fMeanTickTime;
+            fMeanTickTime = meanTime == 0 ? tickTime : meanTime + (tickTime - meanTime) * 0.1f;
+            if(interval > 0)
+            {
+                float meanInterval = fMeanTickInterval;
+                fMeanTickInterval = meanInterval == 0 ? interval : meanInterval + (interval - meanInterval) * 0.1f;
+            }
+        }
+    }
+    bool Simulation::acquireSnapshot()
+    {
+        return snapshots.acquire();
+    }
+    void Simulation::flushInput()
+    {
+        inputQueue.flush();
+    }
+    float Simulation::getAverageTickInterval() const
+    {
+        return fMeanTickInterval;
+    }
+    float Simulation::getAverageTickTime() const
+    {
+        return fMeanTickTime;
+    }
+    const InputEvent& Simulation::getInputEvent(int i) const
+    {
+        return tickInputs[i];
+    }
+    int Simulation::getInputEventCount() const
+    {
+        return tickInputs.size();
+    }
+    const SimulationSnapshot& Simulation::getSnapshot() const
+    {
+        return snapshots.getFront();
+    }
+    uint64_t Simulation::getTickCount() const
+    {
+        return tickCount;
+    }
+    float Simulation::getTickPeriod() const
+    {
+        return 1.0f / iTicksPerSecond;
+    }
+    bool Simulation::isKeyHeld(int sc) const
+    {
+        return sc >= 0 && sc < SDL_NUM_SCANCODES && keysHeld[sc];
+    }
+    bool Simulation::isRunning() const
+    {
+        return bRun;
+    }
+    void Simulation::pushInput(const InputEvent& event)
+    {
+        inputQueue.push(event);
+    }
+    void Simulation::setUpdate(const function<void(float)>& update)
+    {
+        if(!worker.joinable())
+            this->update = update;
+    }
+    void Simulation::start()
+    {
+        if(worker.joinable())
+            return;
+        bRun = true;
+        worker = thread(&Simulation::loop, this);
+    }
+    void Simulation::stop()
+    {
+        bRun = false;
+        if(worker.joinable())
+            worker.join();
+    }
+}
@@ -0,0 +1,109 @@
+
+#include <RPGE_threads.hpp>
+#include <RPGE_trace.hpp>
+
+namespace rpge
+{
+
+    /****************************************/
+    /********** CLASS: WORKER POOL **********/
+    /****************************************/
+
+    WorkerPool::WorkerPool() : WorkerPool(thread::hardware_concurrency())
+    {
+    }
+    WorkerPool::WorkerPool(int threadCount)
+    {
+        this->stopping    = false;
+        this->jobCount    = 0;
+        this->jobGrain    = 1;
+        this->doneWorkers = 0;
+        this->generation  = 0;
+        this->nextItem    = 0;
+        this->job         = nullptr;
+
+        // The calling thread counts as one of the pool threads
+        for(int i = 1; i < threadCount; i++)
+            workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+    WorkerPool::~WorkerPool()
+    {
+        {
+            unique_lock<mutex> lock(stateLock);
+            stopping = true;
+        }
+        wakeSignal.notify_all();
+        for(thread& worker : workers)
+            worker.join();
+    }
+    int WorkerPool::getThreadCount() const
+    {
+        return workers.size() + 1;
+    }
+    void WorkerPool::processChunks()
+    {
+        while(true)
+        {
+            int begin = nextItem.fetch_add(jobGrain);
+            if(begin >= jobCount)
+                break;
+            int end = begin + jobGrain;
+            RPGE_TRACE_SCOPE("job chunk");
+            (*job)(begin, end > jobCount ? jobCount : end);
+        }
+    }
+    void WorkerPool::workerLoop(int index)
+    {
+        #ifdef RPGE_TRACING
+        Tracer::setThreadName("worker " + std::to_string(index));
+        #endif
+        uint64_t seen = 0;
+        while(true)
+        {
+            {
+                unique_lock<mutex> lock(stateLock);
+                wakeSignal.wait(lock, [&]{ return stopping || generation != seen; });
+                if(stopping)
+                    return;
+                seen = generation;
+            }
+            processChunks();
+            {
+                unique_lock<mutex> lock(stateLock);
+                doneWorkers++;
+            }
+            doneSignal.notify_one();
+        }
+    }
+    void WorkerPool::run(int count, int grain, const RangeJob& job)
+    {
+        if(count <= 0)
+            return;
+        grain = grain < 1 ? 1 : grain;
+        // Do not bother waking workers when there is only one chunk
+        if(workers.empty() || count <= grain)
+        {
+            job(0, count);
+            return;
+        }
+
+        unique_lock<mutex> runGuard(runLock);
+        {
+            unique_lock<mutex> lock(stateLock);
+            this->job         = &job;
+            this->jobCount    = count;
+            this->jobGrain    = grain;
+            this->nextItem    = 0;
+            this->doneWorkers = 0;
+            generation++;
+        }
+        wakeSignal.notify_all();
+        processChunks();
+
+        // Every chunk is claimed at this point, wait until all workers are done with this job, so none of them
+        // can touch its state after `run` returns
+        unique_lock<mutex> lock(stateLock);
+        doneSignal.wait(lock, [&]{ return doneWorkers == (int)workers.size(); });
+        this->job = nullptr;
+    }
+}
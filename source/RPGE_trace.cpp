@@ -0,0 +1,254 @@
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <RPGE_trace.hpp>
+
+namespace rpge
+{
+    using ::std::condition_variable;
+    using ::std::lock_guard;
+    using ::std::mutex;
+    using ::std::thread;
+    using ::std::unique_lock;
+    using ::std::unique_ptr;
+    using ::std::vector;
+
+    /**
+     * Spans of one thread, only that thread writes them. It works as a sequence lock: fields of the spans are atomic,
+     * readers copy them and drop the ones the writer may have overwritten meanwhile, telling by the head read before
+     * and after the copy.
+     */
+    struct TraceRing {
+        struct Span {
+            const char* name;
+            int64_t     start;
+            int64_t     end;
+        };
+        struct Slot {
+            atomic<const char*> name;
+            atomic<int64_t>     start;
+            atomic<int64_t>     end;
+        };
+        unique_ptr<Slot[]> spans;
+        atomic<uint64_t>   head;     // Amount of spans ever written, the next one goes to `head % RING_CAPACITY`
+        atomic<uint64_t>   tail;     // Spans before this one were cleared
+        int                threadId;
+        string             threadName;
+    };
+
+    // Rings of all threads which recorded something, they live until the program ends so traces can be written after
+    // their threads are gone
+    static mutex                         ringsLock;
+    static vector<unique_ptr<TraceRing>> rings;
+
+    // Spike trigger state, it is only touched by the thread calling `checkSpike`
+    static float  spikeFrameTime = 0;
+    static string spikePrefix;
+    static bool   spikeActive    = false; // Whether the previous frame was a spike already
+    static int    spikeCount     = 0;
+
+    /**
+     * Thread writing the rings when a spike starts, so the frame which noticed it does not wait for the file. It is
+     * started by the first spike and writes all of the requested files before the program ends.
+     */
+    struct SpikeWriter {
+        mutex              lock;
+        condition_variable wake;
+        vector<string>     files; // Files the rings are to be written to, from the oldest request
+        bool               stop = false;
+        thread             worker;
+
+        ~SpikeWriter()
+        {
+            {
+                lock_guard<mutex> guard(lock);
+                stop = true;
+            }
+            wake.notify_one();
+            if(worker.joinable())
+                worker.join();
+        }
+        // Asks for the rings to be written to file `file`
+        void request(const string& file)
+        {
+            {
+                lock_guard<mutex> guard(lock);
+                files.push_back(file);
+                if(!worker.joinable())
+                    worker = thread(&SpikeWriter::loop, this);
+            }
+            wake.notify_one();
+        }
+        // Body of the writing thread
+        void loop()
+        {
+            unique_lock<mutex> guard(lock);
+            while(true)
+            {
+                wake.wait(guard, [this] { return stop || !files.empty(); });
+                if(files.empty())
+                    return;
+                string file = files.front();
+                files.erase(files.begin());
+                guard.unlock();
+                Tracer::writeChromeJson(file);
+                guard.lock();
+            }
+        }
+    };
+    // Declared after the rings, so it is destroyed (and done writing) before them
+    static SpikeWriter spikeWriter;
+
+    // Returns ring of the calling thread, it is made when the thread records its first span
+    static TraceRing* getThreadRing()
+    {
+        thread_local TraceRing* ring = nullptr;
+        if(ring == nullptr)
+        {
+            lock_guard<mutex> lock(ringsLock);
+            rings.emplace_back(new TraceRing());
+            ring = rings.back().get();
+            ring->spans.reset(new TraceRing::Slot[Tracer::RING_CAPACITY]);
+            ring->head       = 0;
+            ring->tail       = 0;
+            ring->threadId   = rings.size();
+            ring->threadName = "thread " + std::to_string(ring->threadId);
+        }
+        return ring;
+    }
+    // Writes text `text` to stream `stream` as JSON string
+    static void writeJsonString(ostream& stream, const string& text)
+    {
+        stream << '"';
+        for(char ch : text)
+        {
+            if(ch == '"' || ch == '\\')
+                stream << '\\' << ch;
+            else if((unsigned char)ch < 0x20)
+                stream << ' ';
+            else
+                stream << ch;
+        }
+        stream << '"';
+    }
+    // Writes time `time` in nanoseconds to stream `stream` in microseconds, which trace events use
+    static void writeMicroseconds(ostream& stream, int64_t time)
+    {
+        int64_t fraction = time % 1000;
+        stream << time / 1000 << '.' << fraction / 100 << (fraction / 10) % 10 << fraction % 10;
+    }
+
+    /***********************************/
+    /********** CLASS: TRACER **********/
+    /***********************************/
+
+    atomic<bool> Tracer::enabled(false);
+    const int    Tracer::RING_CAPACITY = 16384;
+
+    bool Tracer::checkSpike(float frameTime)
+    {
+        if(spikeFrameTime <= 0 || frameTime <= spikeFrameTime)
+        {
+            spikeActive = false;
+            return false;
+        }
+        if(spikeActive)
+            return false;
+        spikeActive = true;
+        spikeWriter.request(spikePrefix + std::to_string(spikeCount++) + ".json");
+        return true;
+    }
+    void Tracer::clear()
+    {
+        // Only the owning thread moves the head, so the kept spans are skipped by moving the tail instead
+        lock_guard<mutex> lock(ringsLock);
+        for(unique_ptr<TraceRing>& ring : rings)
+            ring->tail.store(ring->head.load(std::memory_order_acquire), memory_order_relaxed);
+    }
+    void Tracer::record(const char* name, int64_t start, int64_t end)
+    {
+        // Fence keeps the span from being seen before the head of the span written last, so readers seeing any part
+        // of it see that its slot is being overwritten too
+        TraceRing* ring = getThreadRing();
+        uint64_t head = ring->head.load(memory_order_relaxed);
+        TraceRing::Slot& slot = ring->spans[head % RING_CAPACITY];
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, memory_order_relaxed);
+        slot.start.store(start, memory_order_relaxed);
+        slot.end.store(end, memory_order_relaxed);
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+    void Tracer::setEnabled(bool enabled)
+    {
+        Tracer::enabled.store(enabled, memory_order_relaxed);
+    }
+    void Tracer::setSpikeTrigger(float frameTime, const string& prefix)
+    {
+        spikeFrameTime = frameTime > 0 ? frameTime : 0;
+        spikePrefix    = prefix;
+        spikeActive    = false;
+    }
+    void Tracer::setThreadName(const string& name)
+    {
+        TraceRing* ring = getThreadRing();
+        lock_guard<mutex> lock(ringsLock);
+        ring->threadName = name;
+    }
+    void Tracer::writeChromeJson(ostream& stream)
+    {
+        lock_guard<mutex> lock(ringsLock);
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        vector<TraceRing::Span> spans;
+        for(unique_ptr<TraceRing>& ring : rings)
+        {
+            // Spans are copied first, then the ones overwritten while copying (up to the one being written) are dropped
+            uint64_t head  = ring->head.load(std::memory_order_acquire);
+            uint64_t begin = head > (uint64_t)RING_CAPACITY ? head - RING_CAPACITY : 0;
+            begin = std::max(begin, ring->tail.load(memory_order_relaxed));
+            spans.clear();
+            for(uint64_t s = begin; s < head; s++)
+            {
+                const TraceRing::Slot& slot = ring->spans[s % RING_CAPACITY];
+                spans.push_back({ slot.name.load(memory_order_relaxed), slot.start.load(memory_order_relaxed),
+                                  slot.end.load(memory_order_relaxed) });
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = ring->head.load(memory_order_relaxed);
+            uint64_t valid = after + 1 > (uint64_t)RING_CAPACITY ? after + 1 - RING_CAPACITY : 0;
+            uint64_t skipped = valid > begin ? valid - begin : 0;
+
+            stream << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId;
+            stream << ",\"args\":{\"name\":";
+            writeJsonString(stream, ring->threadName);
+            stream << "}}";
+            first = false;
+            for(uint64_t s = skipped; s < spans.size(); s++)
+            {
+                // Times are in microseconds
+                stream << ",{\"name\":";
+                writeJsonString(stream, spans[s].name);
+                stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId;
+                stream << ",\"ts\":";
+                writeMicroseconds(stream, spans[s].start);
+                stream << ",\"dur\":";
+                writeMicroseconds(stream, spans[s].end - spans[s].start);
+                stream << "}";
+            }
+        }
+        stream << "]}\n";
+    }
+    bool Tracer::writeChromeJson(const string& file)
+    {
+        std::ofstream stream(file);
+        if(!stream.good())
+            return false;
+        writeChromeJson(stream);
+        return stream.good();
+    }
+}
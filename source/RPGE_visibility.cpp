@@ -0,0 +1,513 @@
+
+#include <RPGE_visibility.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace rpge
+{
+
+    /*******************************************/
+    /********** CLASS: VISIBILITY SET **********/
+    /*******************************************/
+
+    const int VisibilitySet::FILE_VERSION = 1;
+    const int VisibilitySet::MAX_VARINT_SIZE = 5;
+    const int VisibilitySet::MAX_TILES = 1 << 28;
+    const float VisibilitySet::SAMPLE_SPACING = 0.25f;
+    const float VisibilitySet::EROSION = 0.1875f;
+
+    VisibilitySet::VisibilitySet()
+    {
+        this->error = E_CLEAR;
+        this->width = 0;
+        this->height = 0;
+        this->checksum = 0;
+        this->revision = 0;
+        this->offsets = vector<uint32_t>(1, 0);
+        this->runs = vector<uint8_t>();
+        this->reach = vector<float>();
+    }
+    uint32_t VisibilitySet::computeChecksum(const Scene& scene)
+    {
+        // FNV-1a over the tile grid and amount of walls of every tile type
+        uint32_t hash = 2166136261u;
+        auto mix = [&hash](uint32_t value) {
+            for(int i = 0; i != 4; i++)
+            {
+                hash ^= (value >> (i * 8)) & 0xff;
+                hash *= 16777619u;
+            }
+        };
+        mix(scene.getWidth());
+        mix(scene.getHeight());
+        for(int y = 0; y < scene.getHeight(); y++)
+            for(int x = 0; x < scene.getWidth(); x++)
+            {
+                int tileId = scene.getTileId(x, y);
+                const vector<WallData>* walls = scene.getTileWalls(tileId);
+                mix(tileId);
+                mix(walls == nullptr ? 0 : walls->size());
+            }
+        return hash;
+    }
+    uint32_t VisibilitySet::readVarint(const vector<uint8_t>& data, uint32_t& offset, uint32_t end)
+    {
+        uint32_t value = 0;
+        for(int shift = 0; offset < end && shift < MAX_VARINT_SIZE * 7; shift += 7)
+        {
+            uint8_t byte = data[offset++];
+            value |= (uint32_t)(byte & 0x7f) << shift;
+            if(!(byte & 0x80))
+                break;
+        }
+        return value;
+    }
+    bool VisibilitySet::isEncodingValid() const
+    {
+        uint64_t count = (uint64_t)width * height;
+        if(offsets.size() != count + 1 || reach.size() != count || offsets[0] != 0 || offsets[count] != runs.size())
+            return false;
+        for(float distance : reach)
+            if(!std::isfinite(distance) || distance < 0)
+                return false;
+
+        // Every number has to end within its tile and MAX_VARINT_SIZE bytes, and runs can not go past the last tile
+        for(uint64_t t = 0; t < count; t++)
+        {
+            uint32_t offset = offsets[t];
+            uint32_t end = offsets[t + 1];
+            if(end < offset)
+                return false;
+            uint64_t position = 0;
+            while(offset < end)
+            {
+                uint32_t start = offset;
+                uint32_t value = readVarint(runs, offset, end);
+                bool unterminated = runs[offset - 1] & 0x80;
+                bool overflowing = offset - start == (uint32_t)MAX_VARINT_SIZE && runs[offset - 1] > 0x0f;
+                if(unterminated || overflowing)
+                    return false;
+                position += value;
+                if(position > count)
+                    return false;
+            }
+        }
+        return true;
+    }
+    bool VisibilitySet::isOpaque(const Scene& scene, int x, int y)
+    {
+        const vector<WallData>* walls = scene.getTileWalls(scene.getTileId(x, y));
+        if(walls == nullptr)
+            return false;
+
+        // Every side of the tile must be one stopping wall going from corner to corner, in either direction
+        const Vector2 corners[4] = { Vector2(0, 0), Vector2(1, 0), Vector2(1, 1), Vector2(0, 1) };
+        for(int side = 0; side < 4; side++)
+        {
+            const Vector2& a = corners[side];
+            const Vector2& b = corners[(side + 1) % 4];
+            bool covered = false;
+            for(const WallData& wd : *walls)
+                covered = covered || (wd.stopsRay && (((wd.start - a).magnitude() < 0.001f && (wd.end - b).magnitude() < 0.001f)
+                                                   || ((wd.start - b).magnitude() < 0.001f && (wd.end - a).magnitude() < 0.001f)));
+            if(!covered)
+                return false;
+        }
+        return true;
+    }
+    int VisibilitySet::getBlockers(const vector<uint8_t>& opaque, int width, int height, int x, int y, float blockers[2][4])
+    {
+        // Tiles outside of the scene count as opaque, nothing can be seen through them anyway
+        auto isOpaqueAt = [&](int tx, int ty) {
+            return tx < 0 || ty < 0 || tx >= width || ty >= height || opaque[ty * width + tx];
+        };
+        const float r = EROSION;
+        float left   = isOpaqueAt(x - 1, y) ? 0 : r;
+        float right  = isOpaqueAt(x + 1, y) ? 0 : r;
+        float bottom = isOpaqueAt(x, y - 1) ? 0 : r;
+        float top    = isOpaqueAt(x, y + 1) ? 0 : r;
+
+        // Inner corners (both sides opaque, the diagonal not) lose a square; the tile becomes two rectangles then, one
+        // narrowed at the sides with such corners and the other one lowered there
+        bool bottomLeft  = left == 0 && bottom == 0 && !isOpaqueAt(x - 1, y - 1);
+        bool bottomRight = right == 0 && bottom == 0 && !isOpaqueAt(x + 1, y - 1);
+        bool topLeft     = left == 0 && top == 0 && !isOpaqueAt(x - 1, y + 1);
+        bool topRight    = right == 0 && top == 0 && !isOpaqueAt(x + 1, y + 1);
+        float x0 = x + left, x1 = x + 1 - right, y0 = y + bottom, y1 = y + 1 - top;
+        if(!(bottomLeft || bottomRight || topLeft || topRight))
+        {
+            blockers[0][0] = x0; blockers[0][1] = x1; blockers[0][2] = y0; blockers[0][3] = y1;
+            return 1;
+        }
+        blockers[0][0] = x0 + (bottomLeft || topLeft ? r : 0);
+        blockers[0][1] = x1 - (bottomRight || topRight ? r : 0);
+        blockers[0][2] = y0;
+        blockers[0][3] = y1;
+        blockers[1][0] = x0;
+        blockers[1][1] = x1;
+        blockers[1][2] = y0 + (bottomLeft || bottomRight ? r : 0);
+        blockers[1][3] = y1 - (topLeft || topRight ? r : 0);
+        return 2;
+    }
+    void VisibilitySet::sweepTile(const Scene& scene, const vector<uint8_t>& opaque, int x, int y, float maxDistance, vector<uint8_t>& marks, vector<int>& touched)
+    {
+        const int w = scene.getWidth(), h = scene.getHeight();
+        // Marks tile with walls as visible
+        auto mark = [&](int tx, int ty) {
+            int index = ty * w + tx;
+            if(!marks[index] && scene.getTileId(tx, ty) != 0)
+            {
+                marks[index] = 1;
+                touched.push_back(index);
+            }
+        };
+
+        // Slopes of a rectangle spanning `u0` to `u1` along a sweep and `v0` to `v1` across it, seen from the origin;
+        // the sweep covers slopes from -1 to 1
+        auto getSpan = [](float u0, float u1, float v0, float v1, float& low, float& high) {
+            u0 = u0 > 0.000001f ? u0 : 0.000001f;
+            low  = clamp(v0 >= 0 ? v0 / u1 : v0 / u0, -1.0f, 1.0f);
+            high = clamp(v1 >= 0 ? v1 / u0 : v1 / u1, -1.0f, 1.0f);
+        };
+
+        // Points every SAMPLE_SPACING around the edge of the tile, corners included
+        int samplesPerSide = ceilf(1 / SAMPLE_SPACING);
+        vector<pair<float, float>> open;
+        for(int sample = 0; sample < 4 * samplesPerSide; sample++)
+        {
+            int side = sample / samplesPerSide;
+            float along = (float)(sample % samplesPerSide) / samplesPerSide;
+            const float sideX[4] = { along, 1, 1 - along, 0 }, sideY[4] = { 0, along, 1, 1 - along };
+            const float px = x + sideX[side], py = y + sideY[side];
+
+            // Sweeps go along +x, -x, +y and -y, each covers directions up to 45 degrees off its axis. Columns are
+            // crossed by the sweep one after another, every tile of a column is seen if it shows between the shadows
+            // cast by opaque tiles of the columns before.
+            for(int sweep = 0; sweep < 4; sweep++)
+            {
+                const bool alongX = sweep < 2;
+                const int sign = sweep % 2 ? -1 : 1;
+                const float originU = alongX ? px : py, originV = alongX ? py : px;
+                const int lines = alongX ? h : w; // Tiles in a column
+                open.assign(1, std::make_pair(-1.0f, 1.0f));
+                int column = sign > 0 ? (int)floorf(originU) : (int)ceilf(originU) - 1;
+                for(; !open.empty(); column += sign)
+                {
+                    if(column < 0 || column >= (alongX ? w : h))
+                        break;
+                    float u0 = sign > 0 ? column - originU : originU - column - 1;
+                    float u1 = u0 + 1;
+                    if(u0 > maxDistance)
+                        break;
+
+                    // Tiles of the column which the open slopes cross
+                    float vMin = fminf(open.front().first * u0, open.front().first * u1);
+                    float vMax = fmaxf(open.back().second * u0, open.back().second * u1);
+                    int first = std::max(0, (int)floorf(originV + vMin));
+                    int last  = std::min(lines - 1, (int)floorf(originV + vMax));
+                    for(int line = first; line <= last; line++)
+                    {
+                        float low, high;
+                        getSpan(u0, u1, line - originV, line + 1 - originV, low, high);
+                        float du = u0 > 0 ? u0 : 0, dv = line - originV > 0 ? line - originV : (line + 1 - originV < 0 ? originV - line - 1 : 0);
+                        if(du * du + dv * dv > maxDistance * maxDistance)
+                            continue;
+                        for(const pair<float, float>& range : open)
+                            if(low <= range.second && high >= range.first)
+                            {
+                                mark(alongX ? column : line, alongX ? line : column);
+                                break;
+                            }
+                    }
+
+                    // Opaque tiles of the column hide what is behind them, except the tile the sweep starts from
+                    for(int line = first; line <= last; line++)
+                    {
+                        int tx = alongX ? column : line, ty = alongX ? line : column;
+                        if(!opaque[ty * w + tx] || (tx == x && ty == y))
+                            continue;
+                        float blockers[2][4];
+                        int count = getBlockers(opaque, w, h, tx, ty, blockers);
+                        for(int b = 0; b < count; b++)
+                        {
+                            // Blocker is turned into the coordinates of the sweep
+                            const float* rect = blockers[b];
+                            float c0 = alongX ? rect[0] : rect[2], c1 = alongX ? rect[1] : rect[3];
+                            float l0 = alongX ? rect[2] : rect[0], l1 = alongX ? rect[3] : rect[1];
+                            float bu0 = sign > 0 ? c0 - originU : originU - c1;
+                            float bu1 = sign > 0 ? c1 - originU : originU - c0;
+                            if(bu1 <= 0 || l1 <= l0)
+                                continue;
+                            float low, high;
+                            getSpan(bu0 > 0 ? bu0 : 0, bu1, l0 - originV, l1 - originV, low, high);
+                            subtractRange(open, low, high);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    void VisibilitySet::subtractRange(vector<pair<float, float>>& open, float low, float high)
+    {
+        // Gaps left narrower than this are closed, true gaps are wider thanks to the erosion margin
+        const float minGap = 0.000001f;
+        vector<pair<float, float>>::iterator it = open.begin();
+        while(it != open.end())
+        {
+            if(high <= it->first || low >= it->second)
+            {
+                ++it;
+                continue;
+            }
+            pair<float, float> range = *it;
+            it = open.erase(it);
+            if(high + minGap < range.second)
+                it = open.insert(it, std::make_pair(high, range.second));
+            if(range.first + minGap < low)
+                it = open.insert(it, std::make_pair(range.first, low));
+            while(it != open.end() && it->first < high)
+                ++it;
+        }
+    }
+    void VisibilitySet::build(const Scene& scene, float maxDistance)
+    {
+        build(scene, maxDistance, nullptr);
+    }
+    void VisibilitySet::build(const Scene& scene, float maxDistance, WorkerPool* pool)
+    {
+        error = E_CLEAR;
+        width = scene.getWidth();
+        height = scene.getHeight();
+        revision++;
+        offsets = vector<uint32_t>(1, 0);
+        runs.clear();
+        reach.clear();
+        if(width <= 0 || height <= 0)
+        {
+            error = E_PVS_INVALID_SCENE;
+            width = height = 0;
+            return;
+        }
+        int count = width * height;
+        vector<uint8_t> opaque(count);
+        for(int t = 0; t < count; t++)
+            opaque[t] = isOpaque(scene, t % width, t / width);
+        vector<vector<uint8_t>> encoded(count);
+        reach.assign(count, 0);
+
+        auto job = [&](int begin, int end) {
+            vector<uint8_t> marks(count, 0);
+            vector<int> touched;
+            for(int t = begin; t < end; t++)
+            {
+                int x = t % width;
+                int y = t / width;
+                touched.clear();
+                sweepTile(scene, opaque, x, y, maxDistance, marks, touched);
+                std::sort(touched.begin(), touched.end());
+
+                // Encode sorted indices as alternating lengths of invisible and visible runs
+                vector<uint8_t>& out = encoded[t];
+                auto writeVarint = [&out](uint32_t value) {
+                    while(value >= 0x80)
+                    {
+                        out.push_back((value & 0x7f) | 0x80);
+                        value >>= 7;
+                    }
+                    out.push_back(value);
+                };
+                int position = 0;
+                float farthest = 0;
+                for(int i = 0, n = touched.size(); i < n; )
+                {
+                    int j = i;
+                    while(j + 1 < n && touched[j + 1] == touched[j] + 1)
+                        j++;
+                    writeVarint(touched[i] - position);
+                    writeVarint(j - i + 1);
+                    position = touched[j] + 1;
+                    i = j + 1;
+                }
+                for(int index : touched)
+                {
+                    // Distance between the farthest points of both tiles, padded by a tile
+                    float dx = abs(index % width - x) + 2;
+                    float dy = abs(index / width - y) + 2;
+                    farthest = std::max(farthest, sqrtf(dx * dx + dy * dy));
+                    marks[index] = 0;
+                }
+                reach[t] = farthest;
+            }
+        };
+        if(pool == nullptr)
+            job(0, count);
+        else
+            pool->run(count, std::max(1, count / (pool->getThreadCount() * 8)), job);
+
+        // Join encoded tiles into one buffer
+        offsets.resize(count + 1);
+        for(int t = 0; t < count; t++)
+        {
+            offsets[t] = runs.size();
+            runs.insert(runs.end(), encoded[t].begin(), encoded[t].end());
+        }
+        offsets[count] = runs.size();
+        checksum = computeChecksum(scene);
+    }
+    bool VisibilitySet::decode(int x, int y, vector<uint8_t>& visible) const
+    {
+        if(x < 0 || x >= width || y < 0 || y >= height)
+            return false;
+        uint32_t count = width * height;
+        visible.assign(count, 0);
+
+        // Runs are checked when the set is loaded, they are clamped to the grid anyway
+        int t = getTileIndex(x, y);
+        uint32_t offset = offsets[t];
+        uint32_t end = offsets[t + 1];
+        uint32_t position = 0;
+        while(offset < end)
+        {
+            position += readVarint(runs, offset, end);
+            uint32_t length = readVarint(runs, offset, end);
+            if(position >= count)
+                break;
+            length = std::min(length, count - position);
+            std::fill(visible.begin() + position, visible.begin() + position + length, 1);
+            position += length;
+        }
+        return true;
+    }
+    bool VisibilitySet::isVisible(int fromX, int fromY, int toX, int toY) const
+    {
+        if(fromX < 0 || fromX >= width || fromY < 0 || fromY >= height)
+            return false;
+        if(toX < 0 || toX >= width || toY < 0 || toY >= height)
+            return false;
+
+        int t = getTileIndex(fromX, fromY);
+        uint32_t target = getTileIndex(toX, toY);
+        uint32_t offset = offsets[t];
+        uint32_t end = offsets[t + 1];
+        uint32_t position = 0;
+        while(offset < end)
+        {
+            position += readVarint(runs, offset, end);
+            if(target < position)
+                return false;
+            position += readVarint(runs, offset, end);
+            if(target < position)
+                return true;
+        }
+        return false;
+    }
+    int VisibilitySet::getError() const
+    {
+        return error;
+    }
+    int VisibilitySet::getEncodedSize() const
+    {
+        return runs.size() + offsets.size() * sizeof(uint32_t) + reach.size() * sizeof(float);
+    }
+    int VisibilitySet::getWidth() const
+    {
+        return width;
+    }
+    int VisibilitySet::getHeight() const
+    {
+        return height;
+    }
+    int VisibilitySet::getRevision() const
+    {
+        return revision;
+    }
+    int VisibilitySet::getTileIndex(int x, int y) const
+    {
+        return y * width + x;
+    }
+    float VisibilitySet::getReach(int x, int y) const
+    {
+        if(x < 0 || x >= width || y < 0 || y >= height)
+            return -1;
+        return reach[getTileIndex(x, y)];
+    }
+    bool VisibilitySet::matches(const Scene& scene) const
+    {
+        return width == scene.getWidth() && height == scene.getHeight() && checksum == computeChecksum(scene);
+    }
+    bool VisibilitySet::saveToFile(const string& file) const
+    {
+        error = E_CLEAR;
+        ofstream stream(file, std::ios::binary);
+        if(!stream.good())
+        {
+            error = E_PVS_FAILED_TO_WRITE;
+            return false;
+        }
+        uint32_t header[6] = { 0x53565052 /* "RPVS" */, (uint32_t)FILE_VERSION, (uint32_t)width, (uint32_t)height, checksum, (uint32_t)runs.size() };
+        stream.write((const char*)header, sizeof(header));
+        stream.write((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+        stream.write((const char*)reach.data(), reach.size() * sizeof(float));
+        stream.write((const char*)runs.data(), runs.size());
+        if(!stream.good())
+        {
+            error = E_PVS_FAILED_TO_WRITE;
+            return false;
+        }
+        return true;
+    }
+    bool VisibilitySet::loadFromFile(const string& file)
+    {
+        error = E_CLEAR;
+        ifstream stream(file, std::ios::binary);
+        if(!stream.good())
+        {
+            error = E_PVS_FAILED_TO_READ;
+            return false;
+        }
+        uint32_t header[6];
+        stream.read((char*)header, sizeof(header));
+        if(!stream.good() || header[0] != 0x53565052 || header[1] != (uint32_t)FILE_VERSION)
+        {
+            error = E_PVS_INVALID_FORMAT;
+            return false;
+        }
+
+        // Sizes are checked against the file length before anything gets allocated for them
+        uint64_t count = (uint64_t)header[2] * header[3];
+        uint64_t expected = sizeof(header) + (count + 1) * sizeof(uint32_t) + count * sizeof(float) + header[5];
+        std::streamoff start = stream.tellg();
+        stream.seekg(0, std::ios::end);
+        std::streamoff length = stream.tellg();
+        stream.seekg(start);
+        if(header[2] == 0 || header[3] == 0 || count > (uint64_t)MAX_TILES || length < 0 || (uint64_t)length != expected)
+        {
+            error = E_PVS_INVALID_FORMAT;
+            return false;
+        }
+
+        VisibilitySet loaded;
+        loaded.width = header[2];
+        loaded.height = header[3];
+        loaded.offsets.resize(count + 1);
+        loaded.reach.resize(count);
+        loaded.runs.resize(header[5]);
+        stream.read((char*)loaded.offsets.data(), loaded.offsets.size() * sizeof(uint32_t));
+        stream.read((char*)loaded.reach.data(), loaded.reach.size() * sizeof(float));
+        stream.read((char*)loaded.runs.data(), loaded.runs.size());
+        if(!stream.good() || !loaded.isEncodingValid())
+        {
+            error = E_PVS_INVALID_FORMAT;
+            return false;
+        }
+
+        width = loaded.width;
+        height = loaded.height;
+        checksum = header[4];
+        revision++;
+        offsets.swap(loaded.offsets);
+        reach.swap(loaded.reach);
+        runs.swap(loaded.runs);
+        return true;
+    }
+}
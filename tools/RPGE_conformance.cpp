@@ -0,0 +1,300 @@
+
+/**
+ * Checks that the optimized render paths draw what the reference renderer (see `ReferenceRenderer`) does. Generated
+ * scenes are seen from fixed camera poses by a headless engine in the software mode, once for every configuration
+ * of the paths, and every frame is compared with the reference one pixel by pixel.
+ *
+ * Usage:
+ *   RPGE-conformance [--size W H] [--tolerance N] [--budget F] [--filter TEXT] [--output DIR]
+ *
+ * A frame passes when no more than `--budget` percent of its pixels differ by more than `--tolerance` in any color
+ * channel; rays of the engine are computed in batches, which moves a few wall edges by a pixel. Configurations which
+ * only cull work are compared with the frames the engine draws without the culling instead, with no budget and no
+ * tolerance, so a single wall lost through a narrow gap fails them. Failing frames are
+ * written to the output directory as BMP images: the expected one, the actual one and the differences (see
+ * `ReferenceRenderer::compare`). The program returns 1 when any frame fails.
+ *
+ * Hardware render mode and the indexed texture storage are not checked, the SDL renderer and the colormap levels
+ * only approximate the exact colors. Builds with the tools run it as CTest test `conformance-software-only`, which
+ * writes into directory `conformance` of the build.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <RPGE_engine.hpp>
+#include <RPGE_generator.hpp>
+#include <RPGE_reference.hpp>
+
+#define SCREEN_WIDTH   320
+#define SCREEN_HEIGHT  200
+#define TOLERANCE      2
+#define BUDGET         0.5f
+#define POSE_COUNT     6
+#define TEXTURE_SIZE   64
+#define WORKER_COUNT   4
+
+using namespace rpge;
+
+// Optimized paths used to draw frames of one run
+struct Configuration {
+    const char*   name;
+    RenderBackend backend;
+    bool          spanCoherence;
+    bool          columnMajor;
+    bool          visibilitySet;
+    float         opacityThreshold;
+    bool          lit;
+    bool          post;             // Whether post passes run on the worker pool, the reference runs them serially
+    bool          exact;            // Whether frames are compared with the ones drawn with no visibility set, which
+                                    // they must match pixel for pixel
+};
+
+const Configuration CONFIGURATIONS[] = {
+    // name              backend          runs   columns pvs    threshold lit    post   exact
+    { "baseline",        RB_RAYCAST,      false, false,  false, 1.0f,     false, false, false },
+    { "span-coherence",  RB_RAYCAST,      true,  false,  false, 1.0f,     false, false, false },
+    { "object-order",    RB_OBJECT_ORDER, false, false,  false, 1.0f,     false, false, false },
+    { "visibility-set",  RB_RAYCAST,      false, false,  true,  1.0f,     false, false, true  },
+    { "column-major",    RB_RAYCAST,      false, true,   false, 1.0f,     false, false, false },
+    { "opacity-cutoff",  RB_RAYCAST,      false, false,  false, 0.99f,    false, false, false },
+    { "lighting",        RB_RAYCAST,      true,  false,  false, 1.0f,     true,  false, false },
+    { "post-passes",     RB_RAYCAST,      false, true,   false, 1.0f,     false, true,  false },
+    { "all",             RB_OBJECT_ORDER, true,  true,   true,  0.99f,    true,  true,  false }
+};
+
+// Returns settings of the scenes frames are drawn in: solid textured walls, translucent walls over textures, several
+// walls of solid colors per tile, and crowded solid boxes with narrow gaps between them
+std::vector<GeneratorSettings> makeScenes()
+{
+    std::vector<GeneratorSettings> scenes(4);
+    for(int s = 0; s < 4; s++)
+    {
+        scenes[s].width  = 48;
+        scenes[s].height = 48;
+        scenes[s].seed   = 7 + s;
+    }
+    scenes[0].wallDensity      = 0.25f;
+    scenes[0].textureCount     = 4;
+    scenes[1].wallDensity      = 0.3f;
+    scenes[1].wallsPerTile     = 2;
+    scenes[1].transparentRatio = 0.4f;
+    scenes[1].textureCount     = 4;
+    scenes[1].sightlineSpacing = 6;
+    scenes[2].wallDensity      = 0.2f;
+    scenes[2].wallsPerTile     = 3;
+    scenes[2].transparentRatio = 0.2f;
+    scenes[3].wallDensity      = 0.45f;
+    scenes[3].solidRatio       = 0.8f;
+    scenes[3].textureCount     = 4;
+    return scenes;
+}
+
+// Returns camera pose `pose` in the scene made by `generator`, cameras stand in empty tiles spread over the scene and
+// look in various directions
+Camera makePose(const SceneGenerator& generator, int pose)
+{
+    const GeneratorSettings& settings = generator.getSettings();
+    int x = settings.width * (pose + 1) / (POSE_COUNT + 1);
+    int y = settings.height * ((pose * 3) % POSE_COUNT + 1) / (POSE_COUNT + 1);
+
+    // Nearest empty tile along the row, then along the column
+    for(int t = 0; t < settings.width * settings.height && generator.getTileId(x, y) != 0; t++)
+    {
+        x = x + 1 < settings.width - 1 ? x + 1 : 1;
+        if(x == 1)
+            y = y + 1 < settings.height - 1 ? y + 1 : 1;
+    }
+    float fov = pose % 3 == 2 ? M_PI / 3 : M_PI_2;
+    return Camera(Vector2(x + 0.37f, y + 0.61f), pose * 1.1f + 0.2f, fov);
+}
+
+// Sets up post passes of processor `post`, they are all turned off when the `enabled` flag is not set
+void setUpPost(PostProcessor& post, bool enabled)
+{
+    uint8_t red[256], green[256], blue[256];
+    for(int i = 0; i < 256; i++)
+    {
+        red[i]   = 20 + i * 9 / 10;
+        green[i] = i;
+        blue[i]  = 255 - (255 - i) * 9 / 10;
+    }
+    post.setFog(enabled, 40, 50, 60, 2, 16);
+    post.setColorLut(enabled, red, green, blue);
+    post.setGamma(enabled ? 1.2f : 1);
+    post.setVignette(enabled ? 0.5f : 0);
+}
+
+// Draws frame of the main camera of `engine` and copies it to `pixels`, returns whether it succeeded
+bool drawFrame(Engine& engine, uint32_t* pixels)
+{
+    engine.clear();
+    engine.render();
+    return engine.tick() && engine.readFrame(pixels);
+}
+
+// Writes `width` x `height` pixels `pixels` (ARGB8888) to BMP file `file`, returns whether it was written
+bool writeImage(const std::string& file, uint32_t* pixels, int width, int height)
+{
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, width, height, 32, width * sizeof(uint32_t),
+                                                              SDL_PIXELFORMAT_ARGB8888);
+    if(surface == nullptr)
+        return false;
+    bool written = SDL_SaveBMP(surface, file.c_str()) == 0;
+    SDL_FreeSurface(surface);
+    return written;
+}
+
+// Prints usage of the program `program` and returns exit code of a wrong invocation
+int printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n";
+    std::cerr << "  --size W H      frame size in pixels (" << SCREEN_WIDTH << " " << SCREEN_HEIGHT << ")\n";
+    std::cerr << "  --tolerance N   largest color channel difference of matching pixels (" << TOLERANCE << ")\n";
+    std::cerr << "  --budget F      percent of pixels of a frame allowed to differ (" << BUDGET << ")\n";
+    std::cerr << "  --filter TEXT   run only configurations whose name contains TEXT\n";
+    std::cerr << "  --output DIR    directory for the scene textures and images of failing frames (.)\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    int width = SCREEN_WIDTH, height = SCREEN_HEIGHT, tolerance = TOLERANCE;
+    float budget = BUDGET;
+    std::string filter, output = ".";
+    for(int a = 1; a < argc; a++)
+    {
+        bool hasValue = a + 1 < argc;
+        if(!strcmp(argv[a], "--size") && a + 2 < argc)
+        {
+            width  = atoi(argv[++a]);
+            height = atoi(argv[++a]);
+        }
+        else if(!strcmp(argv[a], "--tolerance") && hasValue)
+            tolerance = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--budget") && hasValue)
+            budget = atof(argv[++a]);
+        else if(!strcmp(argv[a], "--filter") && hasValue)
+            filter = argv[++a];
+        else if(!strcmp(argv[a], "--output") && hasValue)
+            output = argv[++a];
+        else
+            return printUsage(argv[0]);
+    }
+    if(width < 1 || height < 1)
+        return printUsage(argv[0]);
+
+    Engine engine(width, height, true);
+    if(engine.getError())
+    {
+        std::cerr << "Can not start headless engine: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    WorkerPool pool(WORKER_COUNT);
+    engine.setRenderMode(RM_SOFTWARE);
+    engine.setResolutionGovernor(false);
+    engine.setFrameRate(1000);
+    engine.setColumnsPerRay(1);
+    engine.setRowsInterval(1);
+    engine.setClearColor(30, 30, 40);
+    engine.setClearArea({ 0, 0, width, height });
+    engine.setRenderArea({ 0, 0, width, height });
+
+    ReferenceSettings settings;
+    settings.width      = width;
+    settings.height     = height;
+    settings.clearColor = enColor(30, 30, 40, 255);
+    settings.lightAngle = 0.7f;
+
+    std::vector<uint32_t> actual(width * height), expected(width * height), diff(width * height);
+    Framebuffer referenceFrame;
+    PostProcessor referencePost;
+    int frames = 0, failures = 0;
+    std::vector<GeneratorSettings> scenes = makeScenes();
+    for(int s = 0; s < (int)scenes.size(); s++)
+    {
+        scenes[s].texturePrefix = output + "/conformance_" + std::to_string(s) + "_texture_";
+        SceneGenerator generator(scenes[s]);
+        if(!generator.writeTextures(TEXTURE_SIZE))
+        {
+            std::cerr << "Can not write textures: " << SDL_GetError() << "\n";
+            return 1;
+        }
+        Scene scene(engine.getRendererHandle(), scenes[s].width, scenes[s].height);
+        generator.fill(scene);
+        VisibilitySet pvs;
+        pvs.build(scene, scenes[s].width + scenes[s].height, &pool);
+        engine.getWalker()->setTargetScene(&scene);
+        engine.getWalker()->setMaxTileDistance(scenes[s].width + scenes[s].height);
+
+        for(const Configuration& config : CONFIGURATIONS)
+        {
+            if(strstr(config.name, filter.c_str()) == nullptr)
+                continue;
+            engine.setRenderBackend(config.backend);
+            engine.setSpanCoherence(config.spanCoherence);
+            engine.getFramebuffer()->setColumnMajor(config.columnMajor);
+            engine.setOpacityThreshold(config.opacityThreshold);
+            engine.setLightBehavior(config.lit, settings.lightAngle);
+            scene.setVisibilitySet(config.visibilitySet ? &pvs : nullptr);
+            setUpPost(*engine.getPostProcessor(), config.post);
+            engine.getPostProcessor()->setWorkerPool(config.post ? &pool : nullptr);
+            setUpPost(referencePost, config.post);
+            settings.lightEnabled = config.lit;
+            ReferenceRenderer reference(settings);
+
+            int worst = 0;
+            for(int p = 0; p < POSE_COUNT; p++)
+            {
+                Camera camera = makePose(generator, p);
+                engine.setMainCamera(&camera);
+                bool drawn = drawFrame(engine, actual.data());
+                if(config.exact)
+                {
+                    // Frame drawn without the culling is checked by the baseline configuration already
+                    scene.setVisibilitySet(nullptr);
+                    drawn = drawn && drawFrame(engine, expected.data());
+                    scene.setVisibilitySet(config.visibilitySet ? &pvs : nullptr);
+                }
+                else
+                {
+                    reference.render(scene, camera, referenceFrame);
+                    referencePost.process(referenceFrame);
+                    for(int y = 0; y < height; y++)
+                        std::copy(referenceFrame.getRow(y), referenceFrame.getRow(y) + width, expected.begin() + y * width);
+                }
+                if(!drawn)
+                {
+                    std::cerr << "Can not draw frame: " << SDL_GetError() << "\n";
+                    return 1;
+                }
+
+                int differing = ReferenceRenderer::compare(expected.data(), actual.data(), width * height,
+                                                           config.exact ? 0 : tolerance, diff.data());
+                worst = differing > worst ? differing : worst;
+                frames++;
+                if(differing <= (config.exact ? 0 : budget / 100 * width * height))
+                    continue;
+
+                failures++;
+                std::string prefix = output + "/" + config.name + "_scene" + std::to_string(s) + "_pose" + std::to_string(p);
+                std::cout << "FAIL " << config.name << " scene " << s << " pose " << p << ": " << differing;
+                std::cout << " pixels differ, images written to " << prefix << "_*.bmp\n";
+                if(!writeImage(prefix + "_expected.bmp", expected.data(), width, height)
+                   || !writeImage(prefix + "_actual.bmp", actual.data(), width, height)
+                   || !writeImage(prefix + "_diff.bmp", diff.data(), width, height))
+                    std::cerr << "Can not write images: " << SDL_GetError() << "\n";
+            }
+            std::cout << "scene " << s << " " << config.name << ": at most " << 100.0f * worst / (width * height);
+            std::cout << "% of pixels differ\n";
+        }
+        engine.setMainCamera(nullptr);
+        engine.getWalker()->setTargetScene(nullptr);
+    }
+
+    std::cout << frames - failures << " of " << frames << " frames match the reference\n";
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+
+/**
+ * Writes a generated scene (see `SceneGenerator`) to an RPS file, together with its textures as BMP images next to
+ * it. The same arguments always give the same files, so the scenes can serve as reproducible performance workloads.
+ *
+ * Usage:
+ *   RPGE-scenegen OUTPUT.rps [--size W H] [--seed N] [--density F] [--walls N] [--kinds N] [--transparent F]
+ *                 [--solid F] [--textures N] [--texture-size N] [--sightlines N] [--open]
+ *
+ * Texture paths in the scene are the ones the textures were written to, so load the scene from the directory the
+ * generator was run in.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <RPGE_generator.hpp>
+
+#define TEXTURE_SIZE  64
+
+using namespace rpge;
+using ::std::chrono::steady_clock;
+using ::std::chrono::duration;
+
+// Prints usage of the program `program` and returns exit code of a wrong invocation
+int printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " OUTPUT.rps [options]\n";
+    std::cerr << "  --size W H        scene size in tiles (256 256)\n";
+    std::cerr << "  --seed N          seed of the scene (1)\n";
+    std::cerr << "  --density F       part of tiles with walls, 0 - 1 (0.2)\n";
+    std::cerr << "  --walls N         walls per tile kind (1)\n";
+    std::cerr << "  --kinds N         distinct tile kinds (8)\n";
+    std::cerr << "  --transparent F   part of walls which are translucent, 0 - 1 (0)\n";
+    std::cerr << "  --solid F         part of tiles with walls which are solid boxes, 0 - 1 (0)\n";
+    std::cerr << "  --textures N      textures spread over the walls, 0 for solid colors (0)\n";
+    std::cerr << "  --texture-size N  texture size in pixels (" << TEXTURE_SIZE << ")\n";
+    std::cerr << "  --sightlines N    keep every N-th row and column empty, 0 for none (0)\n";
+    std::cerr << "  --open            do not enclose the scene with solid tiles\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2 || argv[1][0] == '-')
+        return printUsage(argv[0]);
+
+    string output = argv[1];
+    GeneratorSettings settings;
+    int textureSize = TEXTURE_SIZE;
+    for(int a = 2; a < argc; a++)
+    {
+        bool hasValue = a + 1 < argc;
+        if(!strcmp(argv[a], "--size") && a + 2 < argc)
+        {
+            settings.width  = atoi(argv[++a]);
+            settings.height = atoi(argv[++a]);
+        }
+        else if(!strcmp(argv[a], "--seed") && hasValue)
+            settings.seed = strtoul(argv[++a], nullptr, 10);
+        else if(!strcmp(argv[a], "--density") && hasValue)
+            settings.wallDensity = atof(argv[++a]);
+        else if(!strcmp(argv[a], "--walls") && hasValue)
+            settings.wallsPerTile = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--kinds") && hasValue)
+            settings.tileKinds = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--transparent") && hasValue)
+            settings.transparentRatio = atof(argv[++a]);
+        else if(!strcmp(argv[a], "--solid") && hasValue)
+            settings.solidRatio = atof(argv[++a]);
+        else if(!strcmp(argv[a], "--textures") && hasValue)
+            settings.textureCount = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--texture-size") && hasValue)
+            textureSize = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--sightlines") && hasValue)
+            settings.sightlineSpacing = atoi(argv[++a]);
+        else if(!strcmp(argv[a], "--open"))
+            settings.bordered = false;
+        else
+            return printUsage(argv[0]);
+    }
+    if(settings.width < 1 || settings.height < 1 || textureSize < 1)
+        return printUsage(argv[0]);
+
+    // Textures are named after the scene file, without its extension
+    size_t extension = output.rfind('.');
+    size_t directory = output.find_last_of("/\\");
+    bool hasExtension = extension != string::npos && (directory == string::npos || extension > directory);
+    settings.texturePrefix = output.substr(0, hasExtension ? extension : output.size()) + "_texture_";
+
+    steady_clock::time_point start = steady_clock::now();
+    SceneGenerator generator(settings);
+    if(!generator.writeRps(output))
+    {
+        std::cerr << "Can not write scene to " << output << "\n";
+        return 1;
+    }
+    if(!generator.writeTextures(textureSize))
+    {
+        std::cerr << "Can not write textures: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    duration<float> time = steady_clock::now() - start;
+
+    std::cout << "Wrote " << settings.width << "x" << settings.height << " scene to " << output;
+    if(settings.textureCount > 0)
+        std::cout << " and " << settings.textureCount << " textures to " << generator.getTextureFile(0) << "...";
+    std::cout << " in " << time.count() << " s\n";
+    return 0;
+}